@@ -0,0 +1,181 @@
+#include "allocationstats.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#if defined(Q_OS_WIN)
+#  include <malloc.h>
+#elif defined(Q_OS_DARWIN)
+#  include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+#  include <malloc.h>
+#endif
+
+namespace {
+
+// Plain zero-initialised data: usable from operator new before and during static
+// initialisation, on any thread.
+struct ThreadCounters {
+    quint64 allocations;
+    quint64 bytes;
+    qint64 live;    // signed: memory is often freed on another thread than it was allocated on
+    qint64 peak;
+};
+
+thread_local ThreadCounters t_counters;
+
+inline std::size_t usableSize(void *p)
+{
+#if defined(Q_OS_WIN)
+    return _msize(p);
+#elif defined(Q_OS_DARWIN)
+    return malloc_size(p);
+#elif defined(__GLIBC__)
+    return malloc_usable_size(p);
+#else
+    Q_UNUSED(p);
+    return 0;
+#endif
+}
+
+void *countedAlloc(std::size_t size) noexcept
+{
+    void *p = std::malloc(size ? size : 1);
+    if (p) {
+        ThreadCounters &counters = t_counters;
+        ++counters.allocations;
+        counters.bytes += size;
+        counters.live += qint64(usableSize(p));
+        if (counters.live > counters.peak)
+            counters.peak = counters.live;
+    }
+    return p;
+}
+
+void *countedAllocOrThrow(std::size_t size)
+{
+    for (;;) {
+        if (void *p = countedAlloc(size))
+            return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void countedFree(void *p) noexcept
+{
+    if (!p)
+        return;
+    t_counters.live -= qint64(usableSize(p));
+    std::free(p);
+}
+
+QMutex &statsMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+QHash<QString, AllocationStats::Stats> &statsByName()
+{
+    static QHash<QString, AllocationStats::Stats> stats;
+    return stats;
+}
+
+} // namespace
+
+// ------------------ Global operator new/delete ------------------
+
+void *operator new(std::size_t size) { return countedAllocOrThrow(size); }
+void *operator new[](std::size_t size) { return countedAllocOrThrow(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete(void *p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void *p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+
+// ------------------ AllocationStats ------------------
+
+AllocationStats::Counters AllocationStats::threadTotals()
+{
+    const ThreadCounters &counters = t_counters;
+    Counters totals;
+    totals.allocations = counters.allocations;
+    totals.bytes = counters.bytes;
+    totals.peakBytes = quint64(qMax<qint64>(0, counters.peak));
+    return totals;
+}
+
+QList<AllocationStats::Stats> AllocationStats::statistics()
+{
+    QList<Stats> stats;
+    {
+        QMutexLocker locker(&statsMutex());
+        stats = statsByName().values();
+    }
+    std::sort(stats.begin(), stats.end(), [](const Stats &a, const Stats &b) {
+        return a.name < b.name;
+    });
+    return stats;
+}
+
+void AllocationStats::clear()
+{
+    QMutexLocker locker(&statsMutex());
+    statsByName().clear();
+}
+
+void AllocationStats::record(const QString &name, const Counters &counters)
+{
+    QMutexLocker locker(&statsMutex());
+    Stats &stats = statsByName()[name];
+    stats.name = name;
+    ++stats.runs;
+    stats.last = counters;
+    stats.maxAllocations = qMax(stats.maxAllocations, counters.allocations);
+    stats.maxPeakBytes = qMax(stats.maxPeakBytes, counters.peakBytes);
+    stats.totalAllocations += counters.allocations;
+}
+
+// ------------------ AllocationScope ------------------
+
+AllocationScope::AllocationScope(const QString &name)
+    : m_name(name)
+{
+    ThreadCounters &counters = t_counters;
+    m_startAllocations = counters.allocations;
+    m_startBytes = counters.bytes;
+    m_startLive = counters.live;
+    // The peak is tracked from here on; the outer value is restored on exit.
+    m_outerPeak = counters.peak;
+    counters.peak = counters.live;
+}
+
+AllocationScope::~AllocationScope()
+{
+    const AllocationStats::Counters result = counters();
+    ThreadCounters &counters = t_counters;
+    counters.peak = qMax(counters.peak, m_outerPeak);
+    AllocationStats::record(m_name, result);
+}
+
+AllocationStats::Counters AllocationScope::counters() const
+{
+    const ThreadCounters &counters = t_counters;
+    AllocationStats::Counters result;
+    result.allocations = counters.allocations - m_startAllocations;
+    result.bytes = counters.bytes - m_startBytes;
+    result.peakBytes = quint64(qMax<qint64>(0, counters.peak - m_startLive));
+    return result;
+}
@@ -0,0 +1,74 @@
+#ifndef ALLOCATIONSTATS_H
+#define ALLOCATIONSTATS_H
+
+#include <QString>
+#include <QList>
+
+// Heap allocation accounting.
+//
+// allocationstats.cpp replaces the global operator new/delete of the executable
+// it is linked into with versions that count, per thread, the number of
+// allocations, the bytes allocated and the live/peak bytes (from the allocator's
+// usable size; zero where the platform cannot report it). Storage still comes
+// from malloc/free, so memory handed across a DLL boundary is freed correctly.
+//
+// What is counted: everything created with new in this binary (QObjects, model
+// items, std containers, QHash spans, ...). Not counted: memory Qt allocates with
+// malloc itself (QString/QList/QByteArray payloads) and allocations inside Qt's
+// own DLLs on Windows.
+//
+// An AllocationScope measures one operation on the current thread and folds the
+// result into per-name statistics shown in the diagnostics dialog and the bench
+// report.
+class AllocationStats
+{
+public:
+    struct Counters {
+        quint64 allocations = 0;
+        quint64 bytes = 0;
+        quint64 peakBytes = 0;      // high-water mark of live bytes above the start
+    };
+
+    struct Stats {
+        QString name;
+        quint64 runs = 0;
+        Counters last;
+        quint64 maxAllocations = 0;
+        quint64 maxPeakBytes = 0;
+        quint64 totalAllocations = 0;
+    };
+
+    // Totals for the calling thread since it started.
+    static Counters threadTotals();
+
+    static QList<Stats> statistics();
+    static void clear();
+
+    static void record(const QString &name, const Counters &counters);
+
+    // What the counters include, shown next to them wherever they are reported. A
+    // load whose rows are mostly QString payloads can show a flat count while it
+    // still mallocs per row.
+    static constexpr const char *Coverage = "operator new only";
+};
+
+class AllocationScope
+{
+public:
+    explicit AllocationScope(const QString &name);
+    ~AllocationScope();
+
+    // Counters so far; final once the scope ends.
+    AllocationStats::Counters counters() const;
+
+private:
+    Q_DISABLE_COPY(AllocationScope)
+
+    QString m_name;
+    quint64 m_startAllocations;
+    quint64 m_startBytes;
+    qint64 m_startLive;
+    qint64 m_outerPeak;
+};
+
+#endif // ALLOCATIONSTATS_H
@@ -0,0 +1,276 @@
+#include "appconfig.h"
+
+#include <QCoreApplication>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QSettings>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+#include <memory>
+
+namespace {
+
+struct Definition {
+    const char *key;
+    const char *env;
+    QVariant fallback;   // also fixes the type: int, bool or string
+    int minimum;         // int settings only
+    bool live;
+};
+
+const Definition &definition(AppConfig::Setting setting)
+{
+    // In AppConfig::Setting order.
+    static const Definition table[] = {
+        { "storage/backend",               "ARCHIFLOW_BACKEND",                 QString("oracle"), 0, false },
+        { "storage/odbcConnectionString",  "ARCHIFLOW_ODBC_CONNECTION",         QString(),         0, false },
+        { "storage/sqlitePath",            "ARCHIFLOW_SQLITE_PATH",             QString(),         0, false },
+        { "storage/fetchSize",             "ARCHIFLOW_FETCH_SIZE",              500,               1, false },
+        { "storage/migrate",               "ARCHIFLOW_MIGRATE",                 true,              0, false },
+        { "journal/path",                  "ARCHIFLOW_JOURNAL_PATH",            QString(),         0, false },
+
+        { "journal/maxBatch",              "ARCHIFLOW_JOURNAL_MAX_BATCH",       256,               1, true },
+        { "journal/retryMinMs",            "ARCHIFLOW_JOURNAL_RETRY_MIN_MS",    2000,              100, true },
+        { "journal/retryMaxMs",            "ARCHIFLOW_JOURNAL_RETRY_MAX_MS",    30000,             100, true },
+        { "journal/flushDelayMs",          "ARCHIFLOW_FLUSH_DELAY_MS",          50,                0, true },
+        { "storage/passwordHashScanRows",  "ARCHIFLOW_PASSWORD_SCAN_ROWS",      2048,              1, true },
+        { "import/hashChunkRows",          "ARCHIFLOW_IMPORT_CHUNK_ROWS",       1024,              1, true },
+
+        { "scheduler/workers",             "ARCHIFLOW_WORKERS",                 0,                 0, false },
+        { "scheduler/loadLimit",           "ARCHIFLOW_LOAD_LIMIT",              2,                 1, true },
+        { "scheduler/exportLimit",         "ARCHIFLOW_EXPORT_LIMIT",            1,                 1, true },
+        { "scheduler/backgroundLimit",     "ARCHIFLOW_BACKGROUND_LIMIT",        1,                 1, true },
+        { "analytics/minPartitionRows",    "ARCHIFLOW_PARTITION_ROWS",          4096,              1, true },
+
+        { "ui/clockIntervalMs",            "ARCHIFLOW_CLOCK_MS",                1000,              50, true },
+        { "ui/statusSnapshotMs",           "ARCHIFLOW_STATUS_SNAPSHOT_MS",      60000,             1000, true },
+        { "ui/statusHistoryPoints",        "ARCHIFLOW_STATUS_HISTORY",          50,                2, true },
+        { "ui/activityChartDelayMs",       "ARCHIFLOW_CHART_DELAY_MS",          100,               0, true },
+        { "ui/analyticsDebounceMs",        "ARCHIFLOW_ANALYTICS_DEBOUNCE_MS",   300,               0, true },
+        { "presence/heartbeatMs",          "ARCHIFLOW_HEARTBEAT_MS",            30000,             1000, true },
+        { "presence/minWriteMs",           "ARCHIFLOW_PRESENCE_MIN_WRITE_MS",   5000,              0, true },
+        { "presence/pollMs",               "ARCHIFLOW_PRESENCE_POLL_MS",        15000,             1000, true },
+        { "session/validityHours",         "ARCHIFLOW_SESSION_HOURS",           7 * 24,            1, true },
+        { "export/pdfResolution",          "ARCHIFLOW_PDF_RESOLUTION",          300,               72, true },
+        { "ui/shadowMode",                 "ARCHIFLOW_SHADOWS",                 QString("cached"), 0, false },
+        { "diagnostics/trace",             "ARCHIFLOW_TRACE",                   true,              0, false },
+        { "diagnostics/traceBufferEvents", "ARCHIFLOW_TRACE_BUFFER",            1 << 14,           256, false },
+        { "diagnostics/stallThresholdMs",  "ARCHIFLOW_STALL_MS",                50,                0, true },
+        { "diagnostics/stallReport",       "ARCHIFLOW_STALL_REPORT",            QString(),         0, true },
+
+        { "cache/sharedDirectory",         "ARCHIFLOW_SHARED_CACHE",            false,             0, false },
+        { "cache/sharedMaxAgeMs",          "ARCHIFLOW_SHARED_CACHE_MAX_AGE_MS", 30000,             0, true },
+        { "cache/sharedDirectoryBytes",    "ARCHIFLOW_SHARED_CACHE_BYTES",      16 << 20,          65536, false },
+        { "cache/lookupEntries",           "ARCHIFLOW_LOOKUP_CACHE_ENTRIES",    4096,              0, true },
+        { "cache/lookupNegativeTtlMs",     "ARCHIFLOW_LOOKUP_NEGATIVE_TTL_MS",  5000,              0, true },
+    };
+    static_assert(sizeof(table) / sizeof(table[0]) == AppConfig::SettingCount,
+                  "one definition per AppConfig::Setting");
+    return table[setting];
+}
+
+bool parse(const Definition &def, const QVariant &raw, QVariant *value)
+{
+    const QString text = raw.toString().trimmed();
+    switch (def.fallback.typeId()) {
+    case QMetaType::Bool: {
+        const QString lower = text.toLower();
+        *value = !(lower == QLatin1String("0") || lower == QLatin1String("false")
+                   || lower == QLatin1String("no") || lower == QLatin1String("off"));
+        return !text.isEmpty();
+    }
+    case QMetaType::Int: {
+        bool ok = false;
+        const int number = text.toInt(&ok);
+        *value = number;
+        return ok && number >= def.minimum;
+    }
+    default:
+        *value = text;
+        return true;
+    }
+}
+
+} // namespace
+
+AppConfig::AppConfig()
+{
+    m_filePath = qEnvironmentVariable("ARCHIFLOW_CONFIG");
+    if (m_filePath.isEmpty()) {
+        const QString dir = QCoreApplication::instance() ? QCoreApplication::applicationDirPath()
+                                                         : QDir::currentPath();
+        m_filePath = QDir(dir).filePath("archiflow.ini");
+    }
+    m_filePath = QFileInfo(m_filePath).absoluteFilePath();
+    reload();
+}
+
+AppConfig &AppConfig::instance()
+{
+    // Never destroyed: scheduler workers may still read settings during shutdown.
+    static AppConfig *config = [] {
+        auto *created = new AppConfig;
+        // The first read may come from a scheduler worker; the watcher belongs on the
+        // GUI thread, so it is set up there.
+        if (QCoreApplication *app = QCoreApplication::instance()) {
+            created->moveToThread(app->thread());
+            QMetaObject::invokeMethod(created, [created]() { created->watchFile(); }, Qt::QueuedConnection);
+        }
+        return created;
+    }();
+    return *config;
+}
+
+int AppConfig::intValue(Setting setting)
+{
+    return instance().value(setting).toInt();
+}
+
+bool AppConfig::boolValue(Setting setting)
+{
+    return instance().value(setting).toBool();
+}
+
+QString AppConfig::stringValue(Setting setting)
+{
+    return instance().value(setting).toString();
+}
+
+QString AppConfig::key(Setting setting)
+{
+    return QString::fromLatin1(definition(setting).key);
+}
+
+QString AppConfig::environmentVariable(Setting setting)
+{
+    return QString::fromLatin1(definition(setting).env);
+}
+
+bool AppConfig::isLive(Setting setting)
+{
+    return definition(setting).live;
+}
+
+QVariant AppConfig::value(Setting setting) const
+{
+    QReadLocker locker(&m_lock);
+    return m_values[setting].value;
+}
+
+AppConfig::Source AppConfig::source(Setting setting) const
+{
+    QReadLocker locker(&m_lock);
+    return m_values[setting].source;
+}
+
+QString AppConfig::sourceName(Source source)
+{
+    switch (source) {
+    case Source::Default:     return QStringLiteral("default");
+    case Source::File:        return QStringLiteral("file");
+    case Source::User:        return QStringLiteral("user");
+    case Source::Environment: return QStringLiteral("environment");
+    }
+    return QString();
+}
+
+void AppConfig::setUserValue(Setting setting, const QVariant &value)
+{
+    {
+        QSettings settings("Archiflow", "Archiflow");
+        settings.setValue(key(setting), value);
+    }
+    reload();
+}
+
+void AppConfig::reload()
+{
+    QSettings user("Archiflow", "Archiflow");
+    std::unique_ptr<QSettings> file;
+    if (QFileInfo::exists(m_filePath)) {
+        file = std::make_unique<QSettings>(m_filePath, QSettings::IniFormat);
+        if (file->status() != QSettings::NoError) {
+            qWarning() << "Cannot read configuration file" << m_filePath;
+            file.reset();
+        }
+    }
+
+    Resolved fresh[SettingCount];
+    for (int i = 0; i < SettingCount; ++i) {
+        const Definition &def = definition(Setting(i));
+        const QString key = QString::fromLatin1(def.key);
+        const QString env = qEnvironmentVariable(def.env);
+
+        struct Candidate { Source source; bool present; QVariant raw; };
+        const Candidate candidates[] = {
+            { Source::Environment, !env.isEmpty(), env },
+            { Source::User, user.contains(key), user.value(key) },
+            { Source::File, file && file->contains(key), file ? file->value(key) : QVariant() },
+        };
+
+        fresh[i].value = def.fallback;
+        for (const Candidate &candidate : candidates) {
+            if (!candidate.present)
+                continue;
+            QVariant parsed;
+            if (parse(def, candidate.raw, &parsed)) {
+                fresh[i] = { parsed, candidate.source };
+                break;
+            }
+            qWarning() << "Ignoring invalid" << key << "=" << candidate.raw.toString()
+                       << "from" << sourceName(candidate.source);
+        }
+    }
+
+    QList<Setting> changedSettings;
+    {
+        QWriteLocker locker(&m_lock);
+        for (int i = 0; i < SettingCount; ++i) {
+            const Setting setting = Setting(i);
+            if (!m_loaded || fresh[i].value == m_values[i].value) {
+                m_values[i] = fresh[i];
+                continue;
+            }
+            if (!isLive(setting)) {
+                qWarning() << "Configuration" << key(setting) << "changed; it takes effect after a restart.";
+                continue;
+            }
+            m_values[i] = fresh[i];
+            changedSettings.append(setting);
+        }
+        m_loaded = true;
+    }
+
+    for (Setting setting : changedSettings) {
+        qDebug() << "Configuration" << key(setting) << "is now" << value(setting).toString();
+        emit changed(setting);
+    }
+}
+
+void AppConfig::watchFile()
+{
+    if (!m_watcher) {
+        m_watcher = new QFileSystemWatcher(this);
+        // Editors often replace the file instead of rewriting it; let the write
+        // settle, then reload and watch whatever file is there now.
+        m_reloadTimer = new QTimer(this);
+        m_reloadTimer->setSingleShot(true);
+        m_reloadTimer->setInterval(200);
+        connect(m_reloadTimer, &QTimer::timeout, this, [this]() {
+            reload();
+            watchFile();
+        });
+        auto scheduleReload = [this]() { m_reloadTimer->start(); };
+        connect(m_watcher, &QFileSystemWatcher::fileChanged, this, scheduleReload);
+        connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, scheduleReload);
+    }
+
+    // The directory is watched too, so a file created after startup is picked up.
+    const QFileInfo info(m_filePath);
+    if (info.dir().exists() && !m_watcher->directories().contains(info.absolutePath()))
+        m_watcher->addPath(info.absolutePath());
+    if (info.exists() && !m_watcher->files().contains(m_filePath))
+        m_watcher->addPath(m_filePath);
+}
@@ -0,0 +1,134 @@
+#ifndef APPCONFIG_H
+#define APPCONFIG_H
+
+#include <QObject>
+#include <QString>
+#include <QVariant>
+#include <QReadWriteLock>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Runtime configuration: connection settings, batch and fetch sizes, scheduler
+// workers and lane limits, timer intervals and capacities, in one place.
+//
+// Every setting resolves, first match wins:
+//   1. its environment variable (ARCHIFLOW_FETCH_SIZE, ...)
+//   2. the per-user settings (QSettings "Archiflow"/"Archiflow", same key)
+//   3. the deployment file: ARCHIFLOW_CONFIG, else archiflow.ini next to the
+//      executable (an INI file with the keys below, e.g. [ui] clockIntervalMs=500)
+//   4. the built-in default
+// A value that does not parse, or falls below the setting's minimum, is reported
+// and skipped in favour of the next source.
+//
+// The deployment file is watched. On a change the settings are resolved again and
+// changed() is emitted for every live setting whose value moved; the owners of
+// those settings either read them at each use or re-arm their timers. Settings
+// that are not live (the backend, the scheduler's worker count, ...) keep the value
+// they had at startup and take effect after a restart.
+//
+// Reads are thread-safe; the instance and its file watcher live on the GUI thread.
+class AppConfig : public QObject
+{
+    Q_OBJECT
+public:
+    enum Setting {
+        // Connection
+        StorageBackendKind,        // storage/backend                  oracle | sqlite
+        OdbcConnectionString,      // storage/odbcConnectionString     empty: built-in DSN
+        SqlitePath,                // storage/sqlitePath               empty: app data dir
+        FetchSize,                 // storage/fetchSize
+        MigrateSchema,             // storage/migrate
+        JournalPath,               // journal/path                     empty: app data dir
+
+        // Batches
+        JournalMaxBatch,           // journal/maxBatch                 live
+        JournalRetryMinMs,         // journal/retryMinMs               live
+        JournalRetryMaxMs,         // journal/retryMaxMs               live
+        WriteFlushDelayMs,         // journal/flushDelayMs             live
+        PasswordHashScanRows,      // storage/passwordHashScanRows     live
+        ImportHashChunkRows,       // import/hashChunkRows             live
+
+        // Workers
+        SchedulerWorkers,          // scheduler/workers                0: one per core
+        LoadLaneLimit,             // scheduler/loadLimit              live
+        ExportLaneLimit,           // scheduler/exportLimit            live
+        BackgroundLaneLimit,       // scheduler/backgroundLimit        live
+        AnalyticsPartitionRows,    // analytics/minPartitionRows       live
+
+        // Timers and capacities
+        ClockIntervalMs,           // ui/clockIntervalMs               live
+        StatusSnapshotMs,          // ui/statusSnapshotMs              live
+        StatusHistoryPoints,       // ui/statusHistoryPoints           live
+        ActivityChartDelayMs,      // ui/activityChartDelayMs          live
+        AnalyticsDebounceMs,       // ui/analyticsDebounceMs           live
+        PresenceHeartbeatMs,       // presence/heartbeatMs             live
+        PresenceMinWriteMs,        // presence/minWriteMs              live
+        PresencePollMs,            // presence/pollMs                  live
+        SessionValidityHours,      // session/validityHours            live
+        PdfResolution,             // export/pdfResolution             live (dpi)
+        ShadowMode,                // ui/shadowMode                    effect | cached | off
+        TraceEnabled,              // diagnostics/trace
+        TraceBufferEvents,         // diagnostics/traceBufferEvents    per thread
+        StallThresholdMs,          // diagnostics/stallThresholdMs     live, 0: off
+        StallReportPath,           // diagnostics/stallReport          live; empty: app data dir
+
+        // Caches
+        SharedDirectoryEnabled,    // cache/sharedDirectory            per host, off by default
+        SharedDirectoryMaxAgeMs,   // cache/sharedMaxAgeMs             live, 0: always query
+        SharedDirectoryBytes,      // cache/sharedDirectoryBytes       segment payload size
+        LookupCacheEntries,        // cache/lookupEntries              live, 0: off
+        LookupCacheNegativeTtlMs,  // cache/lookupNegativeTtlMs        live
+
+        SettingCount
+    };
+    Q_ENUM(Setting)
+
+    enum class Source { Default, File, User, Environment };
+
+    static AppConfig &instance();
+
+    static int intValue(Setting setting);
+    static bool boolValue(Setting setting);
+    static QString stringValue(Setting setting);
+
+    static QString key(Setting setting);
+    static QString environmentVariable(Setting setting);
+    static bool isLive(Setting setting);
+
+    QVariant value(Setting setting) const;
+    Source source(Setting setting) const;
+    static QString sourceName(Source source);
+
+    // The deployment file, whether or not it exists.
+    QString filePath() const { return m_filePath; }
+
+    // Stores a per-user value (QSettings) and resolves the setting again.
+    void setUserValue(Setting setting, const QVariant &value);
+
+    // Resolves every setting again; called by the watcher, callable by hand.
+    void reload();
+
+signals:
+    void changed(AppConfig::Setting setting);
+
+private:
+    AppConfig();
+
+    struct Resolved {
+        QVariant value;
+        Source source = Source::Default;
+    };
+
+    void watchFile();
+
+    QString m_filePath;
+    mutable QReadWriteLock m_lock;
+    Resolved m_values[SettingCount];
+    bool m_loaded = false;
+
+    QFileSystemWatcher *m_watcher = nullptr;
+    QTimer *m_reloadTimer = nullptr;
+};
+
+#endif // APPCONFIG_H
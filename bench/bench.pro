@@ -0,0 +1,50 @@
+QT       += core gui widgets sql printsupport
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = archiflow-bench
+
+# Reuse the application's worker classes directly.
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../allocationstats.cpp \
+    ../appconfig.cpp \
+    ../dashboardanalytics.cpp \
+    ../dashboardviews.cpp \
+    ../employeemodel.cpp \
+    ../lookupcache.cpp \
+    ../schemamigrator.cpp \
+    ../sha256batch.cpp \
+    ../shareddirectorycache.cpp \
+    ../shadowmanager.cpp \
+    ../storagebackend.cpp \
+    ../taskscheduler.cpp \
+    ../tracing.cpp \
+    ../userrepository.cpp \
+    benchmain.cpp \
+    syntheticdata.cpp
+
+HEADERS += \
+    ../allocationstats.h \
+    ../appconfig.h \
+    ../dashboardanalytics.h \
+    ../dashboardviews.h \
+    ../databaseloader.h \
+    ../employeemodel.h \
+    ../employeerecord.h \
+    ../lookupcache.h \
+    ../pdfexportworker.h \
+    ../schema.h \
+    ../schemamigrator.h \
+    ../sha256batch.h \
+    ../shareddirectorycache.h \
+    ../shadowmanager.h \
+    ../statements.h \
+    ../storagebackend.h \
+    ../taskscheduler.h \
+    ../tracing.h \
+    ../userrepository.h \
+    benchreport.h \
+    syntheticdata.h
@@ -0,0 +1,409 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QTextStream>
+#include <QTableView>
+#include <QScrollBar>
+#include <QTableWidget>
+#include <QSqlDatabase>
+#include <QCryptographicHash>
+#include <QDebug>
+
+#include "benchreport.h"
+#include "allocationstats.h"
+#include "syntheticdata.h"
+#include "dashboardanalytics.h"
+#include "dashboardviews.h"
+#include "databaseloader.h"
+#include "employeemodel.h"
+#include "pdfexportworker.h"
+#include "sha256batch.h"
+#include "shadowmanager.h"
+#include "storagebackend.h"
+#include "userrepository.h"
+
+// The widget-level benchmarks call the code home runs (EmployeeModel,
+// dashboardviews), so that the numbers track the cost the admin window pays.
+
+namespace {
+
+QList<EmployeeRecord> loadRecords(const StorageBackend &backend, QString *errorText,
+                                  bool includePasswordHash = true)
+{
+    QList<EmployeeRecord> loaded;
+    DatabaseLoader loader(&backend);
+    loader.setIncludePasswordHash(includePasswordHash);
+    QObject::connect(&loader, &DatabaseLoader::finished, [&](const QList<EmployeeRecord> &records) {
+        loaded = records;
+    });
+    QObject::connect(&loader, &DatabaseLoader::error, [&](const QString &errMsg) {
+        if (errorText)
+            *errorText = errMsg;
+    });
+    loader.process();
+    return loaded;
+}
+
+// First load into an empty table.
+void populateTable(EmployeeModel *model, const QList<EmployeeRecord> &records)
+{
+    model->setRecords(records);
+}
+
+// Mirrors home::updateEmployeeTable: a reload patched into the loaded rows.
+void refreshTable(EmployeeModel *model, const QList<EmployeeRecord> &records)
+{
+    model->mergeRecords(records);
+}
+
+// 'records' with 'count' rows, spread over the table, edited as another client would.
+QList<EmployeeRecord> withChangedRows(QList<EmployeeRecord> records, int count)
+{
+    const int step = qMax(1, int(records.size()) / qMax(1, count));
+    for (int row = 0, changed = 0; row < records.size() && changed < count; row += step, ++changed) {
+        EmployeeRecord &record = records[row];
+        record.status = record.status == QLatin1String("Online") ? "Offline" : "Online";
+        ++record.rowVersion;
+    }
+    return records;
+}
+
+// Mirrors scrolling the dashboard's employee table with a shadow behind it: each
+// sample is one scroll step plus the frame it causes, painted by the offscreen
+// backing store.
+QList<qint64> measureScrollFrames(EmployeeModel *model, ShadowManager::Mode mode, int frames)
+{
+    QWidget window;
+    window.resize(1000, 700);
+    QTableView *table = new QTableView(&window);
+    table->setModel(model);
+    table->setGeometry(20, 20, 640, 560);
+    ShadowManager shadows(mode);
+    shadows.add(table);
+    window.show();
+    QCoreApplication::processEvents();
+
+    QScrollBar *scrollBar = table->verticalScrollBar();
+    QList<qint64> samples;
+    samples.reserve(frames);
+    for (int i = 0; i < frames; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        scrollBar->setValue(scrollBar->value() < scrollBar->maximum() ? scrollBar->value() + 1 : 0);
+        QCoreApplication::processEvents();
+        samples.append(timer.nsecsElapsed());
+    }
+    return samples;
+}
+
+// Loader throughput at different fetch sizes; meaningful against Oracle, where each
+// fetch is a network round trip.
+void measureFetchSizes(BenchReport &report, StorageBackend &backend, const QList<int> &fetchSizes,
+                       int iterations, const QString &source)
+{
+    const int original = backend.fetchSize();
+    for (int fetchSize : fetchSizes) {
+        backend.setFetchSize(fetchSize);
+        QString errorText;
+        qint64 rows = 0;
+        QList<qint64> samples;
+        for (int i = 0; i < iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            rows = loadRecords(backend, &errorText).size();
+            samples.append(timer.nsecsElapsed());
+        }
+        if (!errorText.isEmpty()) {
+            report.skip("database_loader_fetch_size", 0, errorText);
+            continue;
+        }
+        QJsonObject extra;
+        extra["fetch_size"] = fetchSize;
+        extra["source"] = source;
+        report.add("database_loader_fetch_size", rows, samples, extra);
+    }
+    backend.setFetchSize(original);
+}
+
+// Messages that reach every padding case and, in mixed batches, lanes that retire
+// before the others of their pass: the length fits in the last block (55), just
+// does not (56, 63), fills it exactly (64), and the same around two blocks.
+QList<QByteArray> sha256ConformanceInputs()
+{
+    auto message = [](int length, int seed) {
+        QByteArray bytes(length, Qt::Uninitialized);
+        for (int i = 0; i < length; ++i)
+            bytes[i] = char((i * 131 + seed * 17) & 0xff);
+        return bytes;
+    };
+
+    QList<QByteArray> inputs;
+    const int edges[] = { 0, 1, 55, 56, 63, 64, 65, 119, 120, 127, 128, 1000 };
+    for (int length : edges)
+        inputs.append(message(length, length));
+    // Nine of one length: a full pass of eight lanes and one left over.
+    for (int i = 0; i < 9; ++i)
+        inputs.append(message(120, i));
+    for (int i = 0; i < 101; ++i)
+        inputs.append(message((i * 37) % 260, i));
+    return inputs;
+}
+
+// Every engine this CPU has must give the digests QCryptographicHash gives; a wrong
+// one would lock out every user whose password it hashes. With 'singly', each
+// message is also hashed in a batch of its own and through hex(QByteArray).
+bool verifySha256Engines(const QList<QByteArray> &inputs, bool singly, QString *errorText)
+{
+    QStringList expected;
+    expected.reserve(inputs.size());
+    for (const QByteArray &input : inputs)
+        expected.append(QString(QCryptographicHash::hash(input, QCryptographicHash::Sha256).toHex()));
+
+    for (Sha256Batch::Engine engine : { Sha256Batch::Engine::Auto, Sha256Batch::Engine::Scalar,
+                                        Sha256Batch::Engine::Avx2, Sha256Batch::Engine::ShaNi }) {
+        if (!Sha256Batch::isSupported(engine))
+            continue;
+        const QStringList batch = Sha256Batch::hex(inputs, engine);
+        for (qsizetype i = 0; i < inputs.size(); ++i) {
+            const bool wrong = batch.value(i) != expected.at(i)
+                || (singly && Sha256Batch::hex(QList<QByteArray>{ inputs.at(i) }, engine).value(0) != expected.at(i));
+            if (wrong) {
+                *errorText = QString("%1 engine: wrong digest for a %2-byte message (#%3)")
+                                 .arg(Sha256Batch::engineName(engine)).arg(inputs.at(i).size()).arg(i);
+                return false;
+            }
+        }
+    }
+    for (qsizetype i = 0; singly && i < inputs.size(); ++i) {
+        if (Sha256Batch::hex(inputs.at(i)) != expected.at(i)) {
+            *errorText = QString("Sha256Batch::hex: wrong digest for a %1-byte message (#%2)")
+                             .arg(inputs.at(i).size()).arg(i);
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<int> parseSizes(const QString &text)
+{
+    QList<int> sizes;
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        int value = part.trimmed().toInt(&ok);
+        if (ok && value > 0)
+            sizes.append(value);
+    }
+    return sizes;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Table population needs real widgets but no display.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", QByteArray("offscreen"));
+
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("archiflow-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Archiflow benchmark suite (SQLite stand-in for Oracle XE).");
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes", "Comma-separated dataset sizes.", "list", "1000,10000,100000,1000000");
+    QCommandLineOption iterationsOption("iterations", "Timed iterations per benchmark.", "n", "3");
+    QCommandLineOption widgetLimitOption("widget-limit", "Largest dataset used for widget benchmarks.", "rows", "100000");
+    QCommandLineOption pdfLimitOption("pdf-limit", "Largest dataset used for the PDF export.", "rows", "10000");
+    QCommandLineOption outputOption("output", "Write the JSON report to this file instead of stdout.", "path");
+    QCommandLineOption workdirOption("workdir", "Directory for the generated SQLite files.", "path");
+    QCommandLineOption fetchSizesOption("fetch-sizes", "Comma-separated loader fetch sizes (rows).", "list",
+                                        "1,16,64,256,1024,4096");
+    QCommandLineOption fetchConfiguredOption("fetch-configured",
+                                             "Also sweep fetch sizes against the configured backend (read-only).");
+    parser.addOptions({ sizesOption, iterationsOption, widgetLimitOption, pdfLimitOption,
+                        outputOption, workdirOption, fetchSizesOption, fetchConfiguredOption });
+    parser.process(app);
+
+    const QList<int> sizes = parseSizes(parser.value(sizesOption));
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const int widgetLimit = parser.value(widgetLimitOption).toInt();
+    const int pdfLimit = parser.value(pdfLimitOption).toInt();
+    const QList<int> fetchSizes = parseSizes(parser.value(fetchSizesOption));
+
+    QTemporaryDir tempDir;
+    const QString workdir = parser.isSet(workdirOption) ? parser.value(workdirOption) : tempDir.path();
+
+    BenchReport report;
+
+    // Timings of an engine that hashes wrongly are worthless; refuse to report them.
+    QString hashError;
+    if (!verifySha256Engines(sha256ConformanceInputs(), true, &hashError)) {
+        qCritical() << "SHA-256 check failed:" << hashError;
+        return 1;
+    }
+
+    for (int rows : sizes) {
+        const QString dbPath = QString("%1/bench_%2.sqlite").arg(workdir).arg(rows);
+        QFile::remove(dbPath);
+        QFile::remove(dbPath + "-wal");
+        QFile::remove(dbPath + "-shm");
+
+        QString errorText;
+        AllocationStats::clear();
+        {
+            SqliteBackend backend(dbPath);
+            QSqlDatabase db = backend.open("BenchConnection", &errorText);
+            if (!db.isOpen()) {
+                qCritical() << "Cannot open" << dbPath << errorText;
+                return 1;
+            }
+
+            QList<qint64> generation;
+            QElapsedTimer timer;
+            timer.start();
+            if (!SyntheticData().generate(db, rows, &errorText)) {
+                qCritical() << "Dataset generation failed:" << errorText;
+                return 1;
+            }
+            generation.append(timer.nsecsElapsed());
+            report.add("generate_dataset", rows, generation);
+
+            QList<EmployeeRecord> records;
+            report.measure("database_loader", rows, iterations, [&]() {
+                records = loadRecords(backend, &errorText);
+            });
+            if (records.size() != rows) {
+                qCritical() << "Loader returned" << records.size() << "rows, expected" << rows << errorText;
+                return 1;
+            }
+            measureFetchSizes(report, backend, fetchSizes, iterations, "sqlite");
+
+            // What the dashboard loads while the password column is hidden.
+            report.measure("database_loader_no_password", rows, iterations, [&]() {
+                loadRecords(backend, &errorText, false);
+            });
+
+            // What the sort task does off the GUI thread for a role, then user ID, header sort.
+            const QList<EmployeeModel::SortKey> sortKeys = {
+                {EmployeeModel::RoleColumn, Qt::AscendingOrder},
+                {EmployeeModel::UserIdColumn, Qt::DescendingOrder}
+            };
+            report.measure("sort_multi_column", rows, iterations, [&]() {
+                EmployeeModel::sortedOrder(records, sortKeys);
+            });
+
+            // The presence poll behind the dashboard's Online/Offline totals.
+            report.measure("update_user_counts", rows, iterations, [&]() {
+                UserRepository::StatusCounts counts;
+                UserRepository::statusCounts(db, &counts, &errorText, UserRepository::presenceCutoff());
+            });
+
+            // The dashboard aggregates, in one pass and split across the scheduler's workers.
+            const QDateTime analyticsNow = QDateTime::currentDateTimeUtc();
+            report.measure("analytics_sequential", rows, iterations, [&]() {
+                DashboardAnalytics::computeSequential(records, analyticsNow);
+            });
+            report.measure("analytics_parallel", rows, iterations, [&]() {
+                DashboardAnalytics::computeParallel(records, analyticsNow);
+            });
+
+            // Hashing one message per row, as the import and whitelist paths do: the
+            // per-call QCryptographicHash baseline against each batch engine this CPU has.
+            QList<QByteArray> hashInputs;
+            hashInputs.reserve(records.size());
+            for (const EmployeeRecord &record : records)
+                hashInputs.append(record.hwid.toUtf8());
+            if (!verifySha256Engines(hashInputs, false, &errorText)) {
+                qCritical() << "SHA-256 check failed:" << errorText;
+                return 1;
+            }
+            report.measure("sha256_qcryptographichash", rows, iterations, [&]() {
+                QStringList digests;
+                digests.reserve(hashInputs.size());
+                for (const QByteArray &input : hashInputs)
+                    digests.append(QString(QCryptographicHash::hash(input, QCryptographicHash::Sha256).toHex()));
+            });
+            for (Sha256Batch::Engine engine : { Sha256Batch::Engine::Scalar, Sha256Batch::Engine::Avx2,
+                                                Sha256Batch::Engine::ShaNi }) {
+                const QString name = "sha256_batch_" + Sha256Batch::engineName(engine).remove('-');
+                if (!Sha256Batch::isSupported(engine)) {
+                    report.skip(name, rows, "not supported by this CPU");
+                    continue;
+                }
+                report.measure(name, rows, iterations, [&]() {
+                    Sha256Batch::hex(hashInputs, engine);
+                });
+            }
+
+            if (rows <= widgetLimit) {
+                EmployeeModel model;
+                QTableView table;
+                table.setModel(&model);
+                report.measure("table_population", rows, iterations, [&]() {
+                    populateTable(&model, records);
+                });
+                // Alternates between two snapshots five rows apart, so every run patches five rows.
+                const QList<EmployeeRecord> edited = withChangedRows(records, 5);
+                int refreshRun = 0;
+                report.measure("table_refresh", rows, iterations, [&]() {
+                    refreshTable(&model, ++refreshRun % 2 ? edited : records);
+                });
+                populateTable(&model, records);
+                report.measure("search", rows, iterations, [&]() {
+                    dashboardviews::applySearch(&table, model.records(), "ab", EmployeeModel::UserIdColumn,
+                                                0, model.rowCount() - 1);
+                });
+                for (ShadowManager::Mode mode : {ShadowManager::Effect, ShadowManager::Cached, ShadowManager::Off}) {
+                    QJsonObject extra;
+                    extra["shadow_mode"] = ShadowManager::modeName(mode);
+                    report.add("scroll_frame", rows, measureScrollFrames(&model, mode, 100), extra);
+                }
+                QTableWidget whitelist(0, 2);
+                report.measure("whitelist_refresh", rows, iterations, [&]() {
+                    dashboardviews::fillWhitelistTable(&whitelist, db);
+                });
+
+                if (rows <= pdfLimit) {
+                    const QString html = dashboardviews::employeeExportHtml(model.records());
+                    const QString pdfPath = QString("%1/bench_%2.pdf").arg(workdir).arg(rows);
+                    report.measure("pdf_export", rows, iterations, [&]() {
+                        PdfExportWorker(pdfPath, html, true).process();
+                    });
+                } else {
+                    report.skip("pdf_export", rows, "above --pdf-limit");
+                }
+            } else {
+                for (const char *name : { "table_population", "table_refresh", "search", "scroll_frame", "whitelist_refresh", "pdf_export" })
+                    report.skip(name, rows, "above --widget-limit");
+            }
+
+            db.close();
+        }
+        QSqlDatabase::removeDatabase("BenchConnection");
+
+        // Last run of each instrumented operation at this size: a steady-state refresh
+        // should need the same number of heap blocks at every size.
+        for (const AllocationStats::Stats &entry : AllocationStats::statistics())
+            report.addAllocations(entry.name, rows, entry.last.allocations, entry.last.bytes, entry.last.peakBytes);
+        AllocationStats::clear();
+    }
+
+    if (parser.isSet(fetchConfiguredOption)) {
+        std::unique_ptr<StorageBackend> configured = StorageBackend::createConfigured();
+        measureFetchSizes(report, *configured, fetchSizes, iterations, configured->name());
+    }
+
+    const QByteArray json = report.toJson();
+    if (parser.isSet(outputOption)) {
+        QFile out(parser.value(outputOption));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "Cannot write" << out.fileName();
+            return 1;
+        }
+        out.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QElapsedTimer>
+#include <QList>
+#include <algorithm>
+#include <functional>
+
+#include "allocationstats.h"
+
+// Collects timing samples and serialises them as one JSON document per run,
+// so results can be diffed release to release.
+class BenchReport
+{
+public:
+    // Runs 'body' 'iterations' times (after 'setup' each time, untimed) and records the samples.
+    void measure(const QString &name, qint64 rows, int iterations,
+                 const std::function<void()> &body,
+                 const std::function<void()> &setup = {},
+                 const QJsonObject &extra = {})
+    {
+        QList<qint64> samples;
+        samples.reserve(iterations);
+        for (int i = 0; i < iterations; ++i) {
+            if (setup)
+                setup();
+            QElapsedTimer timer;
+            timer.start();
+            body();
+            samples.append(timer.nsecsElapsed());
+        }
+        add(name, rows, samples, extra);
+    }
+
+    void add(const QString &name, qint64 rows, QList<qint64> samples, const QJsonObject &extra = {})
+    {
+        if (samples.isEmpty())
+            return;
+        std::sort(samples.begin(), samples.end());
+        qint64 total = 0;
+        for (qint64 s : samples)
+            total += s;
+        const double medianMs = samples.at(samples.size() / 2) / 1e6;
+
+        QJsonObject result = extra;
+        result["name"] = name;
+        result["rows"] = rows;
+        result["iterations"] = samples.size();
+        result["min_ms"] = samples.first() / 1e6;
+        result["median_ms"] = medianMs;
+        result["mean_ms"] = total / 1e6 / samples.size();
+        result["max_ms"] = samples.last() / 1e6;
+        if (rows > 0 && medianMs > 0)
+            result["rows_per_sec"] = rows / (medianMs / 1000.0);
+        m_results.append(result);
+    }
+
+    void skip(const QString &name, qint64 rows, const QString &reason)
+    {
+        QJsonObject result;
+        result["name"] = name;
+        result["rows"] = rows;
+        result["skipped"] = reason;
+        m_results.append(result);
+    }
+
+    // Heap allocations of one run of an operation at a dataset size.
+    void addAllocations(const QString &name, qint64 rows, quint64 allocations, quint64 bytes, quint64 peakBytes)
+    {
+        QJsonObject result;
+        result["name"] = name;
+        result["rows"] = rows;
+        result["allocations"] = qint64(allocations);
+        result["bytes"] = qint64(bytes);
+        result["peak_bytes"] = qint64(peakBytes);
+        result["counted"] = QLatin1String(AllocationStats::Coverage);
+        m_allocations.append(result);
+    }
+
+    QByteArray toJson() const
+    {
+        QJsonObject root;
+        root["suite"] = "archiflow-bench";
+        root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+        root["qt_version"] = QString::fromLatin1(qVersion());
+        root["platform"] = QSysInfo::prettyProductName();
+        root["cpu_arch"] = QSysInfo::currentCpuArchitecture();
+        root["results"] = m_results;
+        root["allocations"] = m_allocations;
+        return QJsonDocument(root).toJson(QJsonDocument::Indented);
+    }
+
+private:
+    QJsonArray m_results;
+    QJsonArray m_allocations;
+};
+
+#endif // BENCHREPORT_H
@@ -0,0 +1,95 @@
+#include "syntheticdata.h"
+#include "userrepository.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QDateTime>
+
+namespace {
+
+QString randomHex(QRandomGenerator &rng, int length)
+{
+    static const char digits[] = "0123456789abcdef";
+    QString out(length, Qt::Uninitialized);
+    for (int i = 0; i < length; ++i)
+        out[i] = QLatin1Char(digits[rng.bounded(16)]);
+    return out;
+}
+
+bool execAll(QSqlDatabase &db, const QStringList &statements, QString *errorText)
+{
+    QSqlQuery query(db);
+    for (const QString &sql : statements) {
+        if (!query.exec(sql)) {
+            if (errorText)
+                *errorText = QString("%1: %2").arg(sql, query.lastError().text());
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool SyntheticData::generate(QSqlDatabase &db, int rows, QString *errorText) const
+{
+    // Fast bulk load: durability does not matter for throwaway fixtures.
+    if (!execAll(db, { "PRAGMA synchronous = OFF" }, errorText))
+        return false;
+
+    static const char *const roles[] = { "User", "Admin", "Manager", "Viewer" };
+
+    QRandomGenerator rng(m_seed);
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    if (!db.transaction()) {
+        if (errorText)
+            *errorText = db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery userInsert(db);
+    userInsert.prepare("INSERT INTO empl (user_id, hwid, role, status, password_hash, last_seen, created_at) "
+                       "VALUES (?, ?, ?, ?, ?, ?, ?)");
+    QSqlQuery whitelistInsert(db);
+    whitelistInsert.prepare("INSERT INTO WHITELISTED_USERS (HWID, PERMISSION) VALUES (?, ?)");
+
+    for (int i = 0; i < rows; ++i) {
+        const QString hwid = randomHex(rng, 64);
+        // Same derivation as convertHwidToFriendlyId, plus the row index so ids stay unique.
+        QString userId = hwid.right(6) + QString::number(i, 16).rightJustified(4, '0');
+
+        userInsert.addBindValue(userId);
+        userInsert.addBindValue(hwid);
+        userInsert.addBindValue(QString::fromLatin1(roles[rng.bounded(4)]));
+        userInsert.addBindValue(rng.bounded(2) ? QStringLiteral("Online") : QStringLiteral("Offline"));
+        userInsert.addBindValue(randomHex(rng, 64));
+        // Heartbeats spread over two presence TTLs, so about half the Online rows have expired.
+        userInsert.addBindValue(now.addSecs(-qint64(rng.bounded(int(2 * UserRepository::presenceTtlMs() / 1000)))));
+        // Registrations spread over the last 120 days.
+        userInsert.addBindValue(now.addSecs(-qint64(rng.bounded(120 * 24 * 3600))));
+        if (!userInsert.exec()) {
+            if (errorText)
+                *errorText = userInsert.lastError().text();
+            db.rollback();
+            return false;
+        }
+
+        whitelistInsert.addBindValue(hwid);
+        whitelistInsert.addBindValue(1 + rng.bounded(2));
+        if (!whitelistInsert.exec()) {
+            if (errorText)
+                *errorText = whitelistInsert.lastError().text();
+            db.rollback();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        if (errorText)
+            *errorText = db.lastError().text();
+        return false;
+    }
+    return execAll(db, { "PRAGMA synchronous = NORMAL", "ANALYZE" }, errorText);
+}
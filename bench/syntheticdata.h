@@ -0,0 +1,23 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QString>
+#include <QSqlDatabase>
+
+// Fills deterministic 'empl' and WHITELISTED_USERS fixtures into a fresh SQLite
+// database (schema created by SqliteBackend) so the benchmarks can run without
+// the Oracle XE instance.
+class SyntheticData
+{
+public:
+    explicit SyntheticData(quint32 seed = 20250313) : m_seed(seed) {}
+
+    // Inserts 'rows' users and as many whitelist entries. Returns false and fills
+    // errorText on failure.
+    bool generate(QSqlDatabase &db, int rows, QString *errorText = nullptr) const;
+
+private:
+    quint32 m_seed;
+};
+
+#endif // SYNTHETICDATA_H
@@ -0,0 +1,36 @@
+QT       = core sql
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = archiflow-cli
+
+# Same data-access code as the GUI, without widgets.
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../allocationstats.cpp \
+    ../appconfig.cpp \
+    ../lookupcache.cpp \
+    ../schemamigrator.cpp \
+    ../sha256batch.cpp \
+    ../shareddirectorycache.cpp \
+    ../storagebackend.cpp \
+    ../tracing.cpp \
+    ../userrepository.cpp \
+    climain.cpp
+
+HEADERS += \
+    ../allocationstats.h \
+    ../appconfig.h \
+    ../databaseloader.h \
+    ../employeerecord.h \
+    ../lookupcache.h \
+    ../schema.h \
+    ../schemamigrator.h \
+    ../sha256batch.h \
+    ../shareddirectorycache.h \
+    ../statements.h \
+    ../storagebackend.h \
+    ../tracing.h \
+    ../userrepository.h
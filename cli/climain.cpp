@@ -0,0 +1,479 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+
+#include "appconfig.h"
+#include "databaseloader.h"
+#include "schemamigrator.h"
+#include "statements.h"
+#include "storagebackend.h"
+#include "tracing.h"
+#include "userrepository.h"
+
+// archiflow-cli: the dashboard's batch operations without the widget stack.
+//
+//   archiflow-cli export [--format csv|json] [--include-hashes] [--output FILE]
+//   archiflow-cli import FILE.csv              (columns: hwid,role,password)
+//   archiflow-cli whitelist add HWID... [--permission N]
+//   archiflow-cli stats [--json]
+//   archiflow-cli schema [--json]               (version and hot-path query plans)
+//   archiflow-cli migrate                       (for ARCHIFLOW_MIGRATE=0 setups)
+//   archiflow-cli config [--json]               (effective settings and their source)
+//
+// The backend is selected exactly like the GUI (AppConfig: ARCHIFLOW_BACKEND etc.).
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+QTextStream &err()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+QString csvField(const QString &value)
+{
+    if (!value.contains(QLatin1Char(',')) && !value.contains(QLatin1Char('"'))
+        && !value.contains(QLatin1Char('\n')))
+        return value;
+    QString escaped = value;
+    escaped.replace(QLatin1String("\""), QLatin1String("\"\""));
+    return QLatin1Char('"') + escaped + QLatin1Char('"');
+}
+
+QStringList parseCsvLine(const QString &line)
+{
+    QStringList fields;
+    QString current;
+    bool quoted = false;
+    for (int i = 0; i < line.size(); ++i) {
+        const QChar c = line.at(i);
+        if (quoted) {
+            if (c == QLatin1Char('"') && i + 1 < line.size() && line.at(i + 1) == QLatin1Char('"')) {
+                current.append(c);
+                ++i;
+            } else if (c == QLatin1Char('"')) {
+                quoted = false;
+            } else {
+                current.append(c);
+            }
+        } else if (c == QLatin1Char('"')) {
+            quoted = true;
+        } else if (c == QLatin1Char(',')) {
+            fields.append(current.trimmed());
+            current.clear();
+        } else {
+            current.append(c);
+        }
+    }
+    fields.append(current.trimmed());
+    return fields;
+}
+
+int runExport(const QString &format, bool includeHashes, const QString &outputPath)
+{
+    QList<EmployeeRecord> records;
+    QString loadError;
+    DatabaseLoader loader;
+    loader.setIncludePasswordHash(includeHashes);
+    QObject::connect(&loader, &DatabaseLoader::finished, [&](const QList<EmployeeRecord> &loaded) {
+        records = loaded;
+    });
+    QObject::connect(&loader, &DatabaseLoader::error, [&](const QString &errMsg) {
+        loadError = errMsg;
+    });
+    loader.process();
+    if (!loadError.isEmpty()) {
+        err() << loadError << Qt::endl;
+        return 1;
+    }
+
+    QByteArray payload;
+    if (format == QLatin1String("json")) {
+        QJsonArray users;
+        for (const EmployeeRecord &record : records) {
+            QJsonObject user;
+            user["user_id"] = record.userId;
+            user["hwid"] = record.hwid;
+            user["role"] = record.role;
+            user["status"] = record.status;
+            if (includeHashes)
+                user["password_hash"] = record.passwordHash;
+            users.append(user);
+        }
+        payload = QJsonDocument(users).toJson(QJsonDocument::Indented);
+    } else if (format == QLatin1String("csv")) {
+        QString text = includeHashes ? "user_id,hwid,role,status,password_hash\n"
+                                     : "user_id,hwid,role,status\n";
+        for (const EmployeeRecord &record : records) {
+            text += csvField(record.userId) + ',' + csvField(record.hwid)
+                    + ',' + csvField(record.role) + ',' + csvField(record.status);
+            if (includeHashes)
+                text += ',' + csvField(record.passwordHash);
+            text += '\n';
+        }
+        payload = text.toUtf8();
+    } else {
+        err() << "Unknown export format: " << format << Qt::endl;
+        return 2;
+    }
+
+    if (outputPath.isEmpty()) {
+        out() << QString::fromUtf8(payload);
+        out().flush();
+    } else {
+        QFile file(outputPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err() << "Cannot write " << outputPath << ": " << file.errorString() << Qt::endl;
+            return 1;
+        }
+        file.write(payload);
+        err() << "Exported " << records.size() << " users to " << outputPath << Qt::endl;
+    }
+    return 0;
+}
+
+int runImport(QSqlDatabase &db, const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        err() << "Cannot read " << path << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    QTextStream in(&file);
+    const QStringList header = parseCsvLine(in.readLine());
+    const int hwidColumn = header.indexOf("hwid");
+    const int roleColumn = header.indexOf("role");
+    const int passwordColumn = header.indexOf("password");
+    if (hwidColumn < 0 || roleColumn < 0 || passwordColumn < 0) {
+        err() << "Expected a header with hwid,role,password columns." << Qt::endl;
+        return 2;
+    }
+
+    if (!db.transaction()) {
+        err() << "Failed to start database transaction." << Qt::endl;
+        return 1;
+    }
+
+    int created = 0;
+    int duplicates = 0;
+    int invalid = 0;
+
+    // Rows are hashed a chunk at a time in one Sha256Batch pass per column, then
+    // inserted in file order. Same derivation as Register::on_registerbtn_clicked.
+    const int hashChunkRows = AppConfig::intValue(AppConfig::ImportHashChunkRows);
+    QList<int> lineNumbers;
+    QStringList rawHwids;
+    QStringList roles;
+    QStringList passwords;
+    auto flush = [&]() -> bool {
+        const QStringList hwids = UserRepository::sha256Hex(rawHwids);
+        const QStringList passwordHashes = UserRepository::sha256Hex(passwords);
+        for (qsizetype i = 0; i < hwids.size(); ++i) {
+            const QString userId = UserRepository::friendlyIdFromHwid(hwids.at(i));
+            QString errorText;
+            switch (UserRepository::createUser(db, userId, hwids.at(i), roles.at(i), passwordHashes.at(i),
+                                               &errorText)) {
+            case UserRepository::CreateResult::Created:
+                ++created;
+                break;
+            case UserRepository::CreateResult::AlreadyExists:
+                ++duplicates;
+                break;
+            case UserRepository::CreateResult::NotWhitelisted:
+            case UserRepository::CreateResult::Failed:
+                db.rollback();
+                err() << path << ':' << lineNumbers.at(i) << ": " << errorText << Qt::endl;
+                return false;
+            }
+        }
+        lineNumbers.clear();
+        rawHwids.clear();
+        roles.clear();
+        passwords.clear();
+        return true;
+    };
+
+    int lineNumber = 1;
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        ++lineNumber;
+        if (line.trimmed().isEmpty())
+            continue;
+
+        const QStringList fields = parseCsvLine(line);
+        const int needed = qMax(hwidColumn, qMax(roleColumn, passwordColumn));
+        if (fields.size() <= needed || fields.at(hwidColumn).isEmpty()
+            || fields.at(roleColumn).isEmpty() || fields.at(passwordColumn).isEmpty()) {
+            err() << path << ':' << lineNumber << ": skipped incomplete row" << Qt::endl;
+            ++invalid;
+            continue;
+        }
+
+        lineNumbers.append(lineNumber);
+        rawHwids.append(fields.at(hwidColumn));
+        roles.append(fields.at(roleColumn));
+        passwords.append(fields.at(passwordColumn));
+        if (rawHwids.size() >= hashChunkRows && !flush())
+            return 1;
+    }
+    if (!flush())
+        return 1;
+
+    if (!db.commit()) {
+        err() << "Failed to commit transaction: " << db.lastError().text() << Qt::endl;
+        return 1;
+    }
+    out() << "created " << created << ", already existing " << duplicates
+          << ", invalid " << invalid << Qt::endl;
+    return 0;
+}
+
+int runWhitelistAdd(QSqlDatabase &db, const QStringList &rawHwids, int permission)
+{
+    if (rawHwids.isEmpty()) {
+        err() << "whitelist add: expected at least one HWID." << Qt::endl;
+        return 2;
+    }
+    if (!db.transaction()) {
+        err() << "Failed to start database transaction." << Qt::endl;
+        return 1;
+    }
+    // Hashed exactly like home::on_whitelist_user_clicked, all in one batch.
+    QStringList trimmed;
+    trimmed.reserve(rawHwids.size());
+    for (const QString &raw : rawHwids)
+        trimmed.append(raw.trimmed());
+    const QStringList hwids = UserRepository::sha256Hex(trimmed);
+    for (qsizetype i = 0; i < hwids.size(); ++i) {
+        QString errorText;
+        if (!UserRepository::whitelistHwid(db, hwids.at(i), permission, &errorText)) {
+            db.rollback();
+            err() << rawHwids.at(i) << ": " << errorText << Qt::endl;
+            return 1;
+        }
+    }
+    if (!db.commit()) {
+        err() << "Failed to commit transaction: " << db.lastError().text() << Qt::endl;
+        return 1;
+    }
+    out() << "whitelisted " << rawHwids.size() << " HWID(s) with permission " << permission << Qt::endl;
+    return 0;
+}
+
+int runStats(QSqlDatabase &db, bool asJson)
+{
+    UserRepository::StatusCounts counts;
+    QString errorText;
+    if (!UserRepository::statusCounts(db, &counts, &errorText, UserRepository::presenceCutoff())) {
+        err() << errorText << Qt::endl;
+        return 1;
+    }
+
+    QSqlQuery query(db);
+    int whitelisted = 0;
+    if (schema::run(query, statements::whitelistCount) && query.next())
+        whitelisted = schema::read(query, statements::whitelistCount).count;
+
+    if (asJson) {
+        QJsonObject stats;
+        stats["online"] = counts.online;
+        stats["offline"] = counts.offline;
+        stats["other"] = counts.other;
+        stats["total"] = counts.online + counts.offline + counts.other;
+        stats["whitelisted"] = whitelisted;
+        out() << QJsonDocument(stats).toJson(QJsonDocument::Indented);
+    } else {
+        out() << "online      " << counts.online << '\n'
+              << "offline     " << counts.offline << '\n'
+              << "other       " << counts.other << '\n'
+              << "whitelisted " << whitelisted << Qt::endl;
+    }
+    return 0;
+}
+
+int runSchema(QSqlDatabase &db, bool asJson)
+{
+    SchemaMigrator migrator(db, StorageBackend::instance().kind());
+    QString errorText;
+    const int version = migrator.currentVersion(&errorText);
+    if (version < 0) {
+        err() << errorText << Qt::endl;
+        return 1;
+    }
+    const QList<SchemaMigrator::PlanCheck> checks = migrator.checkPlans(&errorText);
+    if (!errorText.isEmpty())
+        err() << "Query plan check incomplete: " << errorText << Qt::endl;
+
+    bool allIndexed = true;
+    for (const SchemaMigrator::PlanCheck &check : checks)
+        allIndexed = allIndexed && check.indexed;
+
+    if (asJson) {
+        QJsonArray plans;
+        for (const SchemaMigrator::PlanCheck &check : checks) {
+            QJsonObject plan;
+            plan["statement"] = check.statement;
+            plan["table"] = check.table;
+            plan["indexed"] = check.indexed;
+            plan["plan"] = QJsonArray::fromStringList(check.plan.split('\n'));
+            plans.append(plan);
+        }
+        QJsonObject schema;
+        schema["version"] = version;
+        schema["latest"] = SchemaMigrator::latestVersion();
+        schema["plans"] = plans;
+        out() << QJsonDocument(schema).toJson(QJsonDocument::Indented);
+    } else {
+        out() << "schema version " << version << " of " << SchemaMigrator::latestVersion() << '\n';
+        for (const SchemaMigrator::PlanCheck &check : checks) {
+            out() << (check.indexed ? "indexed     " : "FULL SCAN   ") << check.statement << '\n';
+            if (!check.indexed) {
+                for (const QString &line : check.plan.split('\n'))
+                    out() << "            " << line << '\n';
+            }
+        }
+        out().flush();
+    }
+    return version == SchemaMigrator::latestVersion() && allIndexed ? 0 : 3;
+}
+
+// Setting values for display; the DSN's password is masked.
+QVariant displayedValue(const AppConfig &config, AppConfig::Setting setting)
+{
+    const QVariant value = config.value(setting);
+    if (setting != AppConfig::OdbcConnectionString)
+        return value;
+    static const QRegularExpression password("((?:PWD|Password)=)[^;]*",
+                                             QRegularExpression::CaseInsensitiveOption);
+    return value.toString().replace(password, "\\1***");
+}
+
+int runConfig(bool asJson)
+{
+    const AppConfig &config = AppConfig::instance();
+    if (asJson) {
+        QJsonArray settings;
+        for (int i = 0; i < AppConfig::SettingCount; ++i) {
+            const auto setting = AppConfig::Setting(i);
+            QJsonObject entry;
+            entry["key"] = AppConfig::key(setting);
+            entry["env"] = AppConfig::environmentVariable(setting);
+            entry["value"] = QJsonValue::fromVariant(displayedValue(config, setting));
+            entry["source"] = AppConfig::sourceName(config.source(setting));
+            entry["live"] = AppConfig::isLive(setting);
+            settings.append(entry);
+        }
+        QJsonObject root;
+        root["file"] = config.filePath();
+        root["settings"] = settings;
+        out() << QJsonDocument(root).toJson(QJsonDocument::Indented);
+    } else {
+        out() << "file " << config.filePath() << '\n';
+        for (int i = 0; i < AppConfig::SettingCount; ++i) {
+            const auto setting = AppConfig::Setting(i);
+            out() << AppConfig::key(setting).leftJustified(32) << ' '
+                  << AppConfig::sourceName(config.source(setting)).leftJustified(12) << ' '
+                  << displayedValue(config, setting).toString() << '\n';
+        }
+        out().flush();
+    }
+    return 0;
+}
+
+int runMigrate(QSqlDatabase &db)
+{
+    SchemaMigrator migrator(db, StorageBackend::instance().kind());
+    QString errorText;
+    if (!migrator.migrate(&errorText)) {
+        err() << errorText << Qt::endl;
+        return 1;
+    }
+    for (const QString &description : migrator.applied())
+        out() << "applied " << description << '\n';
+    out() << "schema version " << migrator.currentVersion() << Qt::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("archiflow-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless batch operations for Archiflow.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "export | import | whitelist add | stats | schema | migrate | config");
+    QCommandLineOption formatOption("format", "Export format: csv or json.", "format", "csv");
+    QCommandLineOption outputOption("output", "Write the export to FILE instead of stdout.", "file");
+    QCommandLineOption hashesOption("include-hashes", "Include password hashes in the export.");
+    QCommandLineOption permissionOption("permission", "Whitelist permission (1 user, 2 admin).", "n", "1");
+    QCommandLineOption jsonOption("json", "Print stats, schema or config as JSON.");
+    QCommandLineOption traceOption("trace", "Write a Chrome trace of the run to FILE.", "file");
+    parser.addOptions({ formatOption, outputOption, hashesOption, permissionOption, jsonOption, traceOption });
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.isEmpty())
+        parser.showHelp(2);
+
+    const QString command = args.first();
+    int status = 2;
+
+    if (command == QLatin1String("config")) {
+        status = runConfig(parser.isSet(jsonOption));
+    } else if (command == QLatin1String("export")) {
+        status = runExport(parser.value(formatOption), parser.isSet(hashesOption), parser.value(outputOption));
+    } else {
+        QString errorText;
+        QSqlDatabase db = StorageBackend::instance().open(QString(), &errorText);
+        if (!db.isOpen()) {
+            err() << "Database connection error: " << errorText << Qt::endl;
+            return 1;
+        }
+
+        if (command == QLatin1String("import") && args.size() == 2) {
+            status = runImport(db, args.at(1));
+        } else if (command == QLatin1String("whitelist") && args.value(1) == QLatin1String("add")) {
+            bool ok = false;
+            const int permission = parser.value(permissionOption).toInt(&ok);
+            if (!ok) {
+                err() << "--permission must be an integer." << Qt::endl;
+                return 2;
+            }
+            status = runWhitelistAdd(db, args.mid(2), permission);
+        } else if (command == QLatin1String("stats")) {
+            status = runStats(db, parser.isSet(jsonOption));
+        } else if (command == QLatin1String("schema")) {
+            status = runSchema(db, parser.isSet(jsonOption));
+        } else if (command == QLatin1String("migrate")) {
+            status = runMigrate(db);
+        } else {
+            err() << "Unknown command: " << args.join(' ') << Qt::endl;
+            parser.showHelp(2);
+        }
+    }
+
+    if (parser.isSet(traceOption)) {
+        QString errorText;
+        if (!Tracer::exportChromeTrace(parser.value(traceOption), &errorText))
+            err() << "Cannot write trace: " << errorText << Qt::endl;
+    }
+    return status;
+}
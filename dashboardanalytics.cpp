@@ -0,0 +1,248 @@
+#include "dashboardanalytics.h"
+#include "appconfig.h"
+#include "userrepository.h"
+#include "tracing.h"
+
+#include <QHash>
+#include <QPointer>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using SeenUser = std::pair<QDateTime, QString>;
+
+// Never seen (null) sorts first, then least recent.
+bool seenEarlier(const SeenUser &a, const SeenUser &b)
+{
+    if (a.first.isValid() != b.first.isValid())
+        return !a.first.isValid();
+    if (a.first != b.first)
+        return a.first < b.first;
+    return a.second < b.second;
+}
+
+void keepOldest(std::vector<SeenUser> &users, std::size_t count)
+{
+    if (users.size() <= count)
+        return;
+    std::partial_sort(users.begin(), users.begin() + count, users.end(), seenEarlier);
+    users.resize(count);
+}
+
+} // namespace
+
+// Aggregates of one contiguous row range; only its own task writes to it.
+struct DashboardAnalytics::Partial {
+    QHash<QString, QHash<QString, int>> statusByRole;
+    QHash<qint64, int> registrations;   // by Julian day
+    int registrationsUnknown = 0;
+    int stale = 0;
+    std::vector<SeenUser> oldest;
+    bool complete = false;
+};
+
+struct DashboardAnalytics::Run {
+    QList<EmployeeRecord> records;
+    QDateTime now;
+    std::vector<Partial> partials;
+    std::atomic<int> remaining{0};
+    TaskHandle task;
+    bool started = false;
+    qint64 startNs = 0;
+    // Called once; empty when the run was cancelled or cut short by shutdown.
+    std::function<void(std::optional<Result>)> done;
+};
+
+DashboardAnalytics::DashboardAnalytics(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void DashboardAnalytics::refresh(const QList<EmployeeRecord> &records)
+{
+    m_task.cancel();
+    const quint64 generation = ++m_generation;
+
+    auto run = std::make_shared<Run>();
+    run->records = records;
+    run->now = QDateTime::currentDateTimeUtc();
+
+    QPointer<DashboardAnalytics> self(this);
+    run->done = [self, generation](std::optional<Result> result) {
+        if (!result)
+            return;
+        QMetaObject::invokeMethod(self.data(), [self, generation, published = *result]() {
+            if (self && self->m_generation == generation)
+                emit self->updated(published);
+        }, Qt::QueuedConnection);
+    };
+    m_task = start(run);
+}
+
+TaskHandle DashboardAnalytics::start(const std::shared_ptr<Run> &run)
+{
+    return TaskScheduler::instance().submit(TaskScheduler::Load, "analytics.refresh",
+        [run](const TaskHandle &task) {
+            run->task = task;
+            run->started = true;
+            run->startNs = Tracer::nowNs();
+
+            const int rows = run->records.size();
+            const int workers = TaskScheduler::instance().workerCount();
+            const int minRows = AppConfig::intValue(AppConfig::AnalyticsPartitionRows);
+            const int partitions = qBound(1, (rows + minRows - 1) / minRows, workers);
+            run->partials.resize(partitions);
+            run->remaining.store(partitions);
+
+            // Submitted from inside a task, the partitions are child tasks: idle
+            // workers steal them while this one computes the first. Counting down
+            // in the cleanup also covers a partition skipped at shutdown.
+            for (int p = 1; p < partitions; ++p) {
+                TaskScheduler::instance().submit(TaskScheduler::Load, "analytics.partition",
+                    [run, p](const TaskHandle &) { computePartition(*run, p); },
+                    [run]() { finishPartition(run); });
+            }
+            computePartition(*run, 0);
+            finishPartition(run);
+        },
+        [run]() {
+            if (!run->started)
+                run->done(std::nullopt);
+        });
+}
+
+void DashboardAnalytics::computePartition(Run &run, int partition)
+{
+    if (run.task.isCancelled())
+        return;
+
+    const int rows = run.records.size();
+    const int partitions = int(run.partials.size());
+    const int begin = int(qint64(rows) * partition / partitions);
+    const int end = int(qint64(rows) * (partition + 1) / partitions);
+
+    TraceSpan span("task", "DashboardAnalytics::computePartition");
+    span.setRows(end - begin);
+
+    const QDateTime presenceCutoff = run.now.addMSecs(-UserRepository::presenceTtlMs());
+    const QDateTime staleCutoff = run.now.addDays(-StaleDays);
+    const qint64 firstDay = run.now.date().addDays(-(RegistrationDays - 1)).toJulianDay();
+    const QString online = QStringLiteral("Online");
+    const QString offline = QStringLiteral("Offline");
+
+    Partial &partial = run.partials[partition];
+    for (int row = begin; row < end; ++row) {
+        const EmployeeRecord &record = run.records.at(row);
+
+        const bool expired = !record.lastSeen.isValid() || record.lastSeen < presenceCutoff;
+        const QString &status = (record.status == online && expired) ? offline : record.status;
+        ++partial.statusByRole[record.role][status];
+
+        if (record.createdAt.isValid()) {
+            const qint64 day = record.createdAt.toUTC().date().toJulianDay();
+            if (day >= firstDay)
+                ++partial.registrations[day];
+        } else {
+            ++partial.registrationsUnknown;
+        }
+
+        if (!record.lastSeen.isValid() || record.lastSeen < staleCutoff) {
+            ++partial.stale;
+            partial.oldest.emplace_back(record.lastSeen, record.userId);
+            // Trimmed in bulk so the candidate list stays small without sorting per row.
+            if (partial.oldest.size() >= std::size_t(8 * OldestShown))
+                keepOldest(partial.oldest, OldestShown);
+        }
+    }
+    keepOldest(partial.oldest, OldestShown);
+    partial.complete = true;
+}
+
+void DashboardAnalytics::finishPartition(const std::shared_ptr<Run> &run)
+{
+    if (run->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    const bool complete = std::all_of(run->partials.begin(), run->partials.end(),
+                                      [](const Partial &partial) { return partial.complete; });
+    if (run->task.isCancelled() || !complete) {
+        run->done(std::nullopt);
+        return;
+    }
+
+    Result result = merge(run->partials, run->now, run->records.size());
+    result.elapsedNs = Tracer::nowNs() - run->startNs;
+    run->done(std::move(result));
+}
+
+DashboardAnalytics::Result DashboardAnalytics::merge(const std::vector<Partial> &partials,
+                                                     const QDateTime &now, int rows)
+{
+    TraceSpan span("task", "DashboardAnalytics::merge");
+    Result result;
+    result.users = rows;
+    result.partitions = int(partials.size());
+
+    const QDate firstDay = now.date().addDays(-(RegistrationDays - 1));
+    for (int day = 0; day < RegistrationDays; ++day)
+        result.registrationsPerDay.insert(firstDay.addDays(day), 0);
+
+    std::vector<SeenUser> oldest;
+    for (const Partial &partial : partials) {
+        for (auto role = partial.statusByRole.cbegin(); role != partial.statusByRole.cend(); ++role) {
+            QMap<QString, int> &statuses = result.statusByRole[role.key()];
+            for (auto status = role.value().cbegin(); status != role.value().cend(); ++status) {
+                statuses[status.key()] += status.value();
+                result.roles[role.key()] += status.value();
+            }
+        }
+        for (auto day = partial.registrations.cbegin(); day != partial.registrations.cend(); ++day)
+            result.registrationsPerDay[QDate::fromJulianDay(day.key())] += day.value();
+        result.registrationsUnknown += partial.registrationsUnknown;
+        result.stale += partial.stale;
+        oldest.insert(oldest.end(), partial.oldest.begin(), partial.oldest.end());
+    }
+
+    keepOldest(oldest, OldestShown);
+    std::sort(oldest.begin(), oldest.end(), seenEarlier);
+    for (const SeenUser &user : oldest)
+        result.oldestSeen.append(qMakePair(user.first, user.second));
+    return result;
+}
+
+DashboardAnalytics::Result DashboardAnalytics::computeSequential(const QList<EmployeeRecord> &records,
+                                                                 const QDateTime &now)
+{
+    Run run;
+    run.records = records;
+    run.now = now;
+    run.partials.resize(1);
+
+    const qint64 startNs = Tracer::nowNs();
+    computePartition(run, 0);
+    Result result = merge(run.partials, now, records.size());
+    result.elapsedNs = Tracer::nowNs() - startNs;
+    return result;
+}
+
+DashboardAnalytics::Result DashboardAnalytics::computeParallel(const QList<EmployeeRecord> &records,
+                                                               const QDateTime &now)
+{
+    auto run = std::make_shared<Run>();
+    run->records = records;
+    run->now = now;
+
+    std::promise<Result> promise;
+    std::future<Result> future = promise.get_future();
+    run->done = [&promise](std::optional<Result> result) {
+        promise.set_value(result ? std::move(*result) : Result());
+    };
+    start(run);
+    return future.get();
+}
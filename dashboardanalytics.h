@@ -0,0 +1,74 @@
+#ifndef DASHBOARDANALYTICS_H
+#define DASHBOARDANALYTICS_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QDate>
+#include <QDateTime>
+
+#include <memory>
+#include <vector>
+
+#include "employeerecord.h"
+#include "taskscheduler.h"
+
+// Directory aggregates behind the dashboard charts, computed off the GUI thread.
+//
+// refresh() takes an implicitly shared snapshot of the loaded rows and splits it
+// into one partition per scheduler worker (at least "analytics/minPartitionRows"
+// each, see AppConfig). Each partition fills its own partial aggregate without
+// locking; the scheduler has no join, so whichever partition finishes last merges
+// the partials and posts the result to the GUI thread. A newer refresh supersedes a pending one.
+//
+// Status follows the presence rule used for the Online/Offline totals: an Online
+// row whose last heartbeat is older than UserRepository::presenceTtlMs() counts
+// as Offline.
+class DashboardAnalytics : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int StaleDays = 30;          // no heartbeat for this long
+    static constexpr int RegistrationDays = 30;   // window of the per-day series
+    static constexpr int OldestShown = 10;
+
+    struct Result {
+        int users = 0;
+        QMap<QString, int> roles;                         // role -> users
+        QMap<QString, QMap<QString, int>> statusByRole;   // role -> status -> users
+        QMap<QDate, int> registrationsPerDay;             // every UTC day of the window, oldest first
+        int registrationsUnknown = 0;                     // rows without created_at
+        int stale = 0;                                    // never seen, or not within StaleDays
+        QList<QPair<QDateTime, QString>> oldestSeen;      // least recent stale users; null = never seen
+        int partitions = 0;
+        qint64 elapsedNs = 0;
+    };
+
+    explicit DashboardAnalytics(QObject *parent = nullptr);
+
+    void refresh(const QList<EmployeeRecord> &records);
+
+    // Synchronous variants for the benchmarks. computeParallel() blocks the caller,
+    // must not run inside a scheduler task, and returns an empty Result if the
+    // scheduler shuts down meanwhile.
+    static Result computeSequential(const QList<EmployeeRecord> &records, const QDateTime &now);
+    static Result computeParallel(const QList<EmployeeRecord> &records, const QDateTime &now);
+
+signals:
+    void updated(const DashboardAnalytics::Result &result);
+
+private:
+    struct Partial;
+    struct Run;
+
+    static TaskHandle start(const std::shared_ptr<Run> &run);
+    static void computePartition(Run &run, int partition);
+    static void finishPartition(const std::shared_ptr<Run> &run);
+    static Result merge(const std::vector<Partial> &partials, const QDateTime &now, int rows);
+
+    quint64 m_generation = 0;
+    TaskHandle m_task;
+};
+
+#endif // DASHBOARDANALYTICS_H
@@ -0,0 +1,89 @@
+#include "dashboardviews.h"
+#include "employeemodel.h"
+#include "shareddirectorycache.h"
+#include "statements.h"
+#include "tracing.h"
+
+#include <QTableView>
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QSqlQuery>
+#include <QSqlError>
+
+#include <utility>
+
+namespace dashboardviews {
+
+void applySearch(QTableView *view, const QList<EmployeeRecord> &records, const QString &text, int column,
+                 int firstRow, int lastRow)
+{
+    for (int row = firstRow; row <= lastRow; ++row) {
+        bool match = EmployeeModel::columnText(records.at(row), column).contains(text, Qt::CaseInsensitive);
+        view->setRowHidden(row, !match);
+    }
+}
+
+bool fillWhitelistTable(QTableWidget *table, QSqlDatabase &db, QString *errorText)
+{
+    table->blockSignals(true);
+    table->setRowCount(0);
+
+    auto addRow = [table](const statements::WhitelistRow &entry) {
+        int row = table->rowCount();
+        table->insertRow(row);
+        table->setItem(row, 0, new QTableWidgetItem(entry.hwid));
+        table->setItem(row, 1, new QTableWidgetItem(QString::number(entry.permission)));
+    };
+
+    bool ok = true;
+    // A fresh snapshot from another instance on this host saves the query.
+    SharedDirectoryCache::Snapshot snapshot;
+    SharedDirectoryCache *shared = SharedDirectoryCache::configured();
+    if (shared && shared->read(&snapshot, SharedDirectoryCache::Whitelist)) {
+        for (const statements::WhitelistRow &entry : std::as_const(snapshot.whitelist))
+            addRow(entry);
+    } else {
+        QSqlQuery query(db);
+        if (schema::run(query, statements::whitelistSelectAll)) {
+            TraceSpan fetchSpan("sql.fetch", "whitelist.select_all");
+            while (query.next())
+                addRow(schema::read(query, statements::whitelistSelectAll));
+            fetchSpan.setRows(table->rowCount());
+        } else {
+            if (errorText)
+                *errorText = query.lastError().text();
+            ok = false;
+        }
+    }
+
+    table->blockSignals(false);
+    return ok;
+}
+
+QString employeeExportHtml(const QList<EmployeeRecord> &records)
+{
+    QString html;
+    html.append("<html><head><meta charset='UTF-8'></head><body>");
+    html.append("<h2>Employee Data</h2>");
+    html.append("<table border='1' cellspacing='0' cellpadding='2'>");
+    html.append("<tr>");
+
+    QStringList headers = {"User ID", "Role", "Status", "Password", "Actions"};
+    for (const QString &header : headers) {
+        html.append("<th>" + header + "</th>");
+    }
+    html.append("</tr>");
+
+    for (const EmployeeRecord &record : records) {
+        html.append("<tr>");
+        for (int j = 0; j < EmployeeModel::ColumnCount; ++j) {
+            QString cellText = EmployeeModel::columnText(record, j);
+            html.append("<td>" + cellText + "</td>");
+        }
+        html.append("</tr>");
+    }
+    html.append("</table></body></html>");
+    return html;
+}
+
+} // namespace dashboardviews
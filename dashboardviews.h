@@ -0,0 +1,32 @@
+#ifndef DASHBOARDVIEWS_H
+#define DASHBOARDVIEWS_H
+
+#include <QString>
+#include <QList>
+#include <QSqlDatabase>
+
+#include "employeerecord.h"
+
+class QTableView;
+class QTableWidget;
+
+// What the admin dashboard does to fill and filter its views, kept out of home so
+// that the benchmark suite times this code rather than a copy of it.
+namespace dashboardviews {
+
+// Hides the rows firstRow..lastRow of 'view' whose text in 'column' does not
+// contain 'text' (case-insensitive) and shows the others.
+void applySearch(QTableView *view, const QList<EmployeeRecord> &records, const QString &text, int column,
+                 int firstRow, int lastRow);
+
+// Refills the whitelist table (HWID, permission) with its signals blocked: from a
+// fresh SharedDirectoryCache snapshot when there is one, else from
+// WHITELISTED_USERS. False when the query fails; the table is then left empty.
+bool fillWhitelistTable(QTableWidget *table, QSqlDatabase &db, QString *errorText = nullptr);
+
+// The document the PDF export renders: one table row per record, every column.
+QString employeeExportHtml(const QList<EmployeeRecord> &records);
+
+} // namespace dashboardviews
+
+#endif // DASHBOARDVIEWS_H
@@ -2,64 +2,149 @@
 #define DATABASELOADER_H
 
 #include <QObject>
-#include <QVariantMap>
 #include <QList>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QDebug>
+
+#include "allocationstats.h"
+#include "employeerecord.h"
+#include "shareddirectorycache.h"
+#include "statements.h"
+#include "storagebackend.h"
+#include "tracing.h"
 
 class DatabaseLoader : public QObject
 {
     Q_OBJECT
 public:
-    explicit DatabaseLoader(QObject *parent = nullptr) : QObject(parent) {}
+    explicit DatabaseLoader(QObject *parent = nullptr)
+        : QObject(parent), m_backend(&StorageBackend::instance()) {}
+
+    // Lets the benchmarks point the loader at a specific backend (e.g. an SQLite file).
+    explicit DatabaseLoader(const StorageBackend *backend, QObject *parent = nullptr)
+        : QObject(parent), m_backend(backend) {}
+
+    // Without password_hash the rows come back with passwordHashLoaded = false and
+    // the hashes are fetched later for the rows that show them
+    // (UserRepository::passwordHashes). On by default.
+    void setIncludePasswordHash(bool include) { m_includePasswordHash = include; }
+
+    // Loads without password hashes go through the host's SharedDirectoryCache
+    // when it is configured: a fresh snapshot is decoded instead of queried, and a
+    // load that refreshes it also reads the whitelist and publishes both. Off by
+    // default.
+    void setUseSharedCache(bool use) { m_useSharedCache = use; }
 
 public slots:
     void process() {
-        // Use a unique connection name for the worker thread
-        QSqlDatabase db = QSqlDatabase::addDatabase("QODBC", "WorkerConnection");
-        db.setDatabaseName("DRIVER={Oracle in XE};DBQ=XE;UID=DALI;PWD=dali;");
-        QList<QVariantMap> records;
-
-        if (!db.open()) {
-            emit error(QString("Database connection error: %1")
-                           .arg(db.lastError().text()));
+        TraceSpan taskSpan("task", "DatabaseLoader::process");
+
+        SharedDirectoryCache *shared = m_useSharedCache && !m_includePasswordHash
+                                           ? SharedDirectoryCache::configured() : nullptr;
+        bool refreshing = false;
+        if (shared) {
+            SharedDirectoryCache::Snapshot snapshot;
+            if (shared->acquire(&snapshot, &refreshing)) {
+                emit finished(snapshot.employees);
+                return;
+            }
+        }
+
+        // Scheduler threads may run several loads at once; each needs its own connection.
+        const QString connectionName = StorageBackend::threadConnectionName("WorkerConnection");
+
+        QList<EmployeeRecord> records;
+        QList<statements::WhitelistRow> whitelist;
+        QString errorText;
+        const bool ok = load(connectionName, &records, refreshing ? &whitelist : nullptr, &errorText);
+
+        // The query and connection handles are gone by now, so this is a clean removal.
+        QSqlDatabase::removeDatabase(connectionName);
+
+        if (refreshing) {
+            QString publishError;
+            if (!ok)
+                shared->abandonRefresh();
+            else if (!shared->publish(records, whitelist, &publishError))
+                qWarning() << "Shared directory snapshot not published:" << publishError;
+        }
+
+        if (!ok) {
+            emit error(errorText);
             return;
         }
 
-        // Adjust the SELECT columns to match your 'empl' table.
-        // For example, here we select user_id, hwid, role, status, password_hash.
+        // Signal that we have finished loading
+        emit finished(records);
+    }
+
+signals:
+    void finished(const QList<EmployeeRecord> &records);
+    void error(const QString &errMsg);
+
+private:
+    // 'whitelist' is filled too when it is not null.
+    bool load(const QString &connectionName, QList<EmployeeRecord> *records,
+              QList<statements::WhitelistRow> *whitelist, QString *errorText) {
+        // Counts the loader's own objects; the rows' QString payloads are not included.
+        AllocationScope allocations("employees.load");
+        QSqlDatabase db = m_backend->open(connectionName, errorText);
+        if (!db.isOpen()) {
+            *errorText = QString("Database connection error: %1").arg(*errorText);
+            return false;
+        }
+
+        // Forward-only lets the driver stream array fetches (sized by the backend's
+        // fetch size) instead of keeping a scrollable cursor.
         QSqlQuery query(db);
-        if (!query.exec("SELECT user_id, hwid, role, status, password_hash FROM empl")) {
-            emit error(QString("Database query error: %1")
-                           .arg(query.lastError().text()));
+        query.setForwardOnly(true);
+        const bool ok = m_includePasswordHash ? schema::run(query, statements::emplLoadAll)
+                                              : schema::run(query, statements::emplLoadDirectory);
+        if (!ok) {
+            *errorText = QString("Database query error: %1").arg(query.lastError().text());
             db.close();
-            QSqlDatabase::removeDatabase("WorkerConnection");
-            return;
+            return false;
         }
 
-        // Read the results into a list of QVariantMaps
+        if (query.size() > 0)
+            records->reserve(query.size());
+
+        // Columns are decoded by their ordinal in the statement's SELECT list.
+        TraceSpan fetchSpan("sql.fetch", m_includePasswordHash ? "empl.load_all" : "empl.load_directory");
         while (query.next()) {
-            QVariantMap record;
-            record["userId"]       = query.value("user_id");
-            record["hwid"]         = query.value("hwid");
-            record["role"]         = query.value("role");
-            record["status"]       = query.value("status");
-            record["password_hash"] = query.value("password_hash");
-            records.append(record);
+            EmployeeRecord record;
+            if (m_includePasswordHash) {
+                schema::read(query, statements::emplLoadAll, record);
+            } else {
+                schema::read(query, statements::emplLoadDirectory, record);
+                record.passwordHashLoaded = false;
+            }
+            records->append(std::move(record));
         }
+        fetchSpan.setRows(records->size());
 
-        // Clean up
-        db.close();
-        QSqlDatabase::removeDatabase("WorkerConnection");
+        if (whitelist) {
+            if (!schema::run(query, statements::whitelistSelectAll)) {
+                *errorText = QString("Database query error: %1").arg(query.lastError().text());
+                db.close();
+                return false;
+            }
+            TraceSpan whitelistSpan("sql.fetch", "whitelist.select_all");
+            while (query.next())
+                whitelist->append(schema::read(query, statements::whitelistSelectAll));
+            whitelistSpan.setRows(whitelist->size());
+        }
 
-        // Signal that we have finished loading
-        emit finished(records);
+        query.finish();
+        db.close();
+        return true;
     }
 
-signals:
-    void finished(const QList<QVariantMap> &records);
-    void error(const QString &errMsg);
+    const StorageBackend *m_backend;
+    bool m_includePasswordHash = true;
+    bool m_useSharedCache = false;
 };
 
 #endif // DATABASELOADER_H
@@ -0,0 +1,195 @@
+#include "diagnosticsdialog.h"
+#include "tracing.h"
+#include "allocationstats.h"
+#include "shadowmanager.h"
+#include "stallwatchdog.h"
+#include "lookupcache.h"
+
+#include <QTableWidget>
+#include <QTableWidgetItem>
+#include <QHeaderView>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QComboBox>
+#include <QLabel>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDateTime>
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent, ShadowManager *shadows)
+    : QDialog(parent)
+    , m_statsTable(new QTableWidget(this))
+    , m_allocationTable(new QTableWidget(this))
+    , m_stallSummary(new QLabel(this))
+    , m_lookupSummary(new QLabel(this))
+{
+    setWindowTitle("ARCHIFLOW Diagnostics");
+    setAttribute(Qt::WA_DeleteOnClose);
+    resize(760, 560);
+
+    QStringList headers = {"Category", "Name", "Count", "p50 (ms)", "p95 (ms)", "p99 (ms)", "Max (ms)"};
+    m_statsTable->setColumnCount(headers.size());
+    m_statsTable->setHorizontalHeaderLabels(headers);
+    m_statsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_statsTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    m_statsTable->verticalHeader()->setVisible(false);
+
+    QStringList allocationHeaders = {"Operation", "Runs", "Allocs (last)", "Bytes (last)",
+                                     "Peak bytes (last)", "Allocs (max)", "Peak bytes (max)"};
+    m_allocationTable->setColumnCount(allocationHeaders.size());
+    m_allocationTable->setHorizontalHeaderLabels(allocationHeaders);
+    m_allocationTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_allocationTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_allocationTable->verticalHeader()->setVisible(false);
+
+    QPushButton *refreshButton = new QPushButton("Refresh", this);
+    QPushButton *exportButton = new QPushButton("Export Chrome Trace...", this);
+    QPushButton *stallButton = new QPushButton("Export Stall Report...", this);
+    QPushButton *clearButton = new QPushButton("Clear", this);
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    buttons->addWidget(refreshButton);
+    buttons->addWidget(clearButton);
+    buttons->addStretch();
+    if (shadows) {
+        // Switch, use the dashboard for a while, then Refresh: the frame times are
+        // recorded per mode.
+        QComboBox *shadowMode = new QComboBox(this);
+        for (ShadowManager::Mode mode : {ShadowManager::Effect, ShadowManager::Cached, ShadowManager::Off})
+            shadowMode->addItem(ShadowManager::modeName(mode), int(mode));
+        shadowMode->setCurrentIndex(shadowMode->findData(int(shadows->mode())));
+        connect(shadowMode, &QComboBox::currentIndexChanged, this, [shadows, shadowMode]() {
+            const auto mode = ShadowManager::Mode(shadowMode->currentData().toInt());
+            shadows->setMode(mode);
+            ShadowManager::saveConfiguredMode(mode);
+        });
+        buttons->addWidget(new QLabel("Shadows:", this));
+        buttons->addWidget(shadowMode);
+    }
+    buttons->addWidget(stallButton);
+    buttons->addWidget(exportButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_statsTable, 2);
+    layout->addWidget(new QLabel(QString("Heap allocations per operation (%1; QString/QList payloads and "
+                                         "allocations inside Qt are not counted):")
+                                     .arg(QLatin1String(AllocationStats::Coverage)), this));
+    layout->addWidget(m_allocationTable, 1);
+    m_stallSummary->setWordWrap(true);
+    layout->addWidget(m_stallSummary);
+    layout->addWidget(m_lookupSummary);
+    layout->addLayout(buttons);
+
+    connect(refreshButton, &QPushButton::clicked, this, &DiagnosticsDialog::refresh);
+    connect(exportButton, &QPushButton::clicked, this, &DiagnosticsDialog::exportTrace);
+    connect(stallButton, &QPushButton::clicked, this, &DiagnosticsDialog::exportStallReport);
+    connect(clearButton, &QPushButton::clicked, this, &DiagnosticsDialog::clearTrace);
+
+    refresh();
+}
+
+void DiagnosticsDialog::refresh()
+{
+    const QList<Tracer::Stats> stats = Tracer::statistics();
+    m_statsTable->setRowCount(stats.size());
+    for (int row = 0; row < stats.size(); ++row) {
+        const Tracer::Stats &entry = stats.at(row);
+        m_statsTable->setItem(row, 0, new QTableWidgetItem(entry.category));
+        m_statsTable->setItem(row, 1, new QTableWidgetItem(entry.name));
+        m_statsTable->setItem(row, 2, new QTableWidgetItem(QString::number(entry.count)));
+        m_statsTable->setItem(row, 3, new QTableWidgetItem(QString::number(entry.p50Ms, 'f', 3)));
+        m_statsTable->setItem(row, 4, new QTableWidgetItem(QString::number(entry.p95Ms, 'f', 3)));
+        m_statsTable->setItem(row, 5, new QTableWidgetItem(QString::number(entry.p99Ms, 'f', 3)));
+        m_statsTable->setItem(row, 6, new QTableWidgetItem(QString::number(entry.maxMs, 'f', 3)));
+    }
+
+    const QList<AllocationStats::Stats> allocations = AllocationStats::statistics();
+    m_allocationTable->setRowCount(allocations.size());
+    for (int row = 0; row < allocations.size(); ++row) {
+        const AllocationStats::Stats &entry = allocations.at(row);
+        m_allocationTable->setItem(row, 0, new QTableWidgetItem(entry.name));
+        m_allocationTable->setItem(row, 1, new QTableWidgetItem(QString::number(entry.runs)));
+        m_allocationTable->setItem(row, 2, new QTableWidgetItem(QString::number(entry.last.allocations)));
+        m_allocationTable->setItem(row, 3, new QTableWidgetItem(QString::number(entry.last.bytes)));
+        m_allocationTable->setItem(row, 4, new QTableWidgetItem(QString::number(entry.last.peakBytes)));
+        m_allocationTable->setItem(row, 5, new QTableWidgetItem(QString::number(entry.maxAllocations)));
+        m_allocationTable->setItem(row, 6, new QTableWidgetItem(QString::number(entry.maxPeakBytes)));
+    }
+
+    const StallWatchdog::Report stalls = StallWatchdog::instance().report();
+    QStringList buckets;
+    for (int bucket = 0; bucket < StallWatchdog::BucketCount; ++bucket) {
+        if (stalls.histogram[bucket] > 0)
+            buckets.append(QString("%1: %2").arg(StallWatchdog::bucketName(bucket)).arg(stalls.histogram[bucket]));
+    }
+    QString summary = QString("GUI stalls over %1 ms: %2").arg(stalls.thresholdMs).arg(stalls.stalls);
+    if (!buckets.isEmpty())
+        summary += " (" + buckets.join(", ") + ")";
+    if (!stalls.recent.isEmpty()) {
+        const StallWatchdog::Stall &last = stalls.recent.first();
+        QStringList spans;
+        for (const Tracer::Event &span : last.spans)
+            spans.append(QString("%1 %2").arg(QLatin1String(span.category), span.name));
+        summary += QString(". Last: %1 ms").arg(last.durationNs / 1e6, 0, 'f', 1);
+        if (!spans.isEmpty())
+            summary += " in " + spans.join(" > ");
+    }
+    m_stallSummary->setText(summary);
+
+    // Hits and misses to size "cache/lookupEntries" and the TTL by.
+    const LookupCache::Stats lookups = LookupCache::instance().stats();
+    const qint64 lookupCount = lookups.hits + lookups.misses;
+    m_lookupSummary->setText(QString("Lookup cache (absent rows): %1 of %2 entries, %3 hits, %4 misses, "
+                                     "hit rate %5%, %6 evicted, %7 invalidated")
+                                 .arg(lookups.entries).arg(lookups.capacity)
+                                 .arg(lookups.hits).arg(lookups.misses)
+                                 .arg(lookupCount > 0 ? 100.0 * lookups.hits / lookupCount : 0.0, 0, 'f', 1)
+                                 .arg(lookups.evictions).arg(lookups.invalidations));
+}
+
+void DiagnosticsDialog::exportTrace()
+{
+    const QString suggested = QString("archiflow-trace-%1.json")
+                                  .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+    QString path = QFileDialog::getSaveFileName(this, "Export Chrome Trace", suggested,
+                                                "Trace Files (*.json)");
+    if (path.isEmpty())
+        return;
+
+    QString errorText;
+    if (!Tracer::exportChromeTrace(path, &errorText)) {
+        QMessageBox::critical(this, "Export Trace", errorText);
+        return;
+    }
+    QMessageBox::information(this, "Export Trace",
+                             "Trace exported. Open it in chrome://tracing or ui.perfetto.dev.");
+}
+
+void DiagnosticsDialog::exportStallReport()
+{
+    const QString suggested = QString("archiflow-stalls-%1.txt")
+                                  .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+    QString path = QFileDialog::getSaveFileName(this, "Export Stall Report", suggested,
+                                                "Text Files (*.txt)");
+    if (path.isEmpty())
+        return;
+
+    QString errorText;
+    if (!StallWatchdog::instance().writeReport(path, &errorText)) {
+        QMessageBox::critical(this, "Export Stall Report", errorText);
+        return;
+    }
+    QMessageBox::information(this, "Export Stall Report",
+                             QString("Stall report exported. The running report is kept at %1.")
+                                 .arg(StallWatchdog::reportPath()));
+}
+
+void DiagnosticsDialog::clearTrace()
+{
+    Tracer::clear();
+    AllocationStats::clear();
+    StallWatchdog::instance().clear();
+    LookupCache::instance().resetStats();
+    refresh();
+}
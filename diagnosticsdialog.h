@@ -0,0 +1,35 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+
+class QLabel;
+class QTableWidget;
+class ShadowManager;
+
+// Hidden diagnostics window (Ctrl+Shift+D on the dashboard): per-statement latency
+// percentiles from the tracer, heap allocations per operation (AllocationScope), the
+// GUI stall histogram (StallWatchdog), the LookupCache hit and miss counters and
+// trace / stall report export. Given the dashboard's ShadowManager it also switches
+// the shadow mode, whose cost shows up in the "ui.frame" rows.
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(QWidget *parent = nullptr, ShadowManager *shadows = nullptr);
+
+private slots:
+    void refresh();
+    void exportTrace();
+    void exportStallReport();
+    void clearTrace();
+
+private:
+    QTableWidget *m_statsTable;
+    QTableWidget *m_allocationTable;
+    QLabel *m_stallSummary;
+    QLabel *m_lookupSummary;
+};
+
+#endif // DIAGNOSTICSDIALOG_H
@@ -0,0 +1,84 @@
+#include "employeeactiondelegate.h"
+
+#include <QApplication>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOptionButton>
+
+EmployeeActionDelegate::EmployeeActionDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+QRect EmployeeActionDelegate::editRect(const QRect &cell)
+{
+    return QRect(cell.left(), cell.top(), cell.width() / 2, cell.height());
+}
+
+QRect EmployeeActionDelegate::deleteRect(const QRect &cell)
+{
+    const int half = cell.width() / 2;
+    return QRect(cell.left() + half, cell.top(), cell.width() - half, cell.height());
+}
+
+void EmployeeActionDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                                   const QModelIndex &index) const
+{
+    QStyledItemDelegate::paint(painter, option, QModelIndex());
+
+    const QWidget *widget = option.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+
+    const bool pressed = m_pressed.isValid() && m_pressed == index;
+    const QRect rects[2] = { editRect(option.rect), deleteRect(option.rect) };
+    const QString labels[2] = { "Edit", "Delete" };
+    for (int i = 0; i < 2; ++i) {
+        QStyleOptionButton button;
+        button.rect = rects[i];
+        button.text = labels[i];
+        button.state = QStyle::State_Enabled;
+        if (pressed && m_pressedEdit == (i == 0))
+            button.state |= QStyle::State_Sunken;
+        else
+            button.state |= QStyle::State_Raised;
+        style->drawControl(QStyle::CE_PushButton, &button, painter, widget);
+    }
+}
+
+QSize EmployeeActionDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QSize size = QStyledItemDelegate::sizeHint(option, index);
+    const int textWidth = option.fontMetrics.horizontalAdvance("Delete");
+    return QSize(qMax(size.width(), 4 * textWidth), size.height());
+}
+
+bool EmployeeActionDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
+                                         const QStyleOptionViewItem &option, const QModelIndex &index)
+{
+    Q_UNUSED(model);
+
+    if (event->type() == QEvent::MouseButtonPress) {
+        auto *mouse = static_cast<QMouseEvent *>(event);
+        if (mouse->button() != Qt::LeftButton)
+            return false;
+        m_pressed = index;
+        m_pressedEdit = editRect(option.rect).contains(mouse->position().toPoint());
+        return true;
+    }
+
+    if (event->type() == QEvent::MouseButtonRelease) {
+        auto *mouse = static_cast<QMouseEvent *>(event);
+        const bool wasPressed = m_pressed.isValid() && m_pressed == index;
+        const bool onEdit = editRect(option.rect).contains(mouse->position().toPoint());
+        m_pressed = QPersistentModelIndex();
+        if (!wasPressed || mouse->button() != Qt::LeftButton || onEdit != m_pressedEdit)
+            return false;
+        if (onEdit)
+            emit editClicked(index.row());
+        else
+            emit deleteClicked(index.row());
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,31 @@
+#ifndef EMPLOYEEACTIONDELEGATE_H
+#define EMPLOYEEACTIONDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+// Paints the Edit / Delete buttons of the Actions column and reports clicks by row,
+// so the view needs no per-row widgets.
+class EmployeeActionDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit EmployeeActionDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    bool editorEvent(QEvent *event, QAbstractItemModel *model,
+                     const QStyleOptionViewItem &option, const QModelIndex &index) override;
+
+signals:
+    void editClicked(int row);
+    void deleteClicked(int row);
+
+private:
+    static QRect editRect(const QRect &cell);
+    static QRect deleteRect(const QRect &cell);
+
+    QPersistentModelIndex m_pressed;
+    bool m_pressedEdit = false;
+};
+
+#endif // EMPLOYEEACTIONDELEGATE_H
@@ -0,0 +1,669 @@
+#include "employeemodel.h"
+#include "allocationstats.h"
+#include "tracing.h"
+
+#include <QCollator>
+#include <QHash>
+#include <QPointer>
+#include <QStringView>
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+int bitWidth(quint32 value)
+{
+    int bits = 1;
+    while (value >>= 1)
+        ++bits;
+    return bits;
+}
+
+struct StringViewHash {
+    std::size_t operator()(QStringView value) const { return qHash(value); }
+};
+
+// Same user_id assumed. An incoming row without its hash matches on the other
+// fields; one that brings a hash the current row lacks does not. last_seen and
+// created_at are left out: no cell shows them, and heartbeats move last_seen of
+// every online user between two reloads.
+bool sameRecord(const EmployeeRecord &current, const EmployeeRecord &incoming)
+{
+    const bool sameHash = !incoming.passwordHashLoaded
+                          || (current.passwordHashLoaded && current.passwordHash == incoming.passwordHash);
+    return current.rowVersion == incoming.rowVersion && current.role == incoming.role
+           && current.status == incoming.status && sameHash && current.hwid == incoming.hwid;
+}
+
+} // namespace
+
+EmployeeModel::EmployeeModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_ranks(ColumnCount)
+{
+}
+
+int EmployeeModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_records.size();
+}
+
+int EmployeeModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant EmployeeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.column() == ActionsColumn)
+        return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::EditRole)
+        return QVariant();
+    const EmployeeRecord &record = m_records.at(index.row());
+    if (index.column() == PasswordColumn && !record.passwordHashLoaded) {
+        requestPasswordHash(index.row());
+        return role == Qt::DisplayRole ? QStringLiteral("…") : QString();
+    }
+    return columnText(record, index.column());
+}
+
+QVariant EmployeeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    static const QStringList headers = {"User ID", "Role", "Status", "Password", "Actions"};
+    return headers.value(section);
+}
+
+Qt::ItemFlags EmployeeModel::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags flags = QAbstractTableModel::flags(index);
+    // Role and password are edited in place and saved with the row's Edit button;
+    // status changes by double-click (home::handleStatusToggle).
+    if (index.column() == RoleColumn || index.column() == PasswordColumn)
+        flags |= Qt::ItemIsEditable;
+    return flags;
+}
+
+bool EmployeeModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || role != Qt::EditRole)
+        return false;
+
+    if (index.column() != RoleColumn && index.column() != StatusColumn
+        && index.column() != PasswordColumn)
+        return false;
+
+    EmployeeRecord &record = m_records[index.row()];
+    if (!m_baselines.contains(record.userId))
+        m_baselines.insert(record.userId, record);
+
+    const QString text = value.toString();
+    switch (index.column()) {
+    case RoleColumn:
+        record.role = text;
+        break;
+    case StatusColumn:
+        record.status = text;
+        break;
+    default:
+        record.passwordHash = text;
+        record.passwordHashLoaded = true;
+        break;
+    }
+    invalidate(index.column());
+    emit dataChanged(index, index, {Qt::DisplayRole, Qt::EditRole});
+    return true;
+}
+
+void EmployeeModel::setRecords(const QList<EmployeeRecord> &records)
+{
+    AllocationScope allocations("employees.setRecords");
+    beginResetModel();
+    m_records = records;
+    m_baselines.clear();
+    invalidate();
+    endResetModel();
+
+    if (!m_sortKeys.isEmpty())
+        sortBy(m_sortKeys);
+}
+
+EmployeeModel::Patch EmployeeModel::mergeRecords(const QList<EmployeeRecord> &records)
+{
+    AllocationScope allocations("employees.mergeRecords");
+    TraceSpan span("ui", "EmployeeModel::mergeRecords");
+    Patch patch;
+
+    QHash<QString, int> currentRows;
+    currentRows.reserve(m_records.size());
+    for (int row = 0; row < m_records.size(); ++row)
+        currentRows.insert(m_records.at(row).userId, row);
+
+    std::vector<char> seen(m_records.size(), 0);
+    std::vector<int> changedRows;
+    bool sortedColumnChanged[ColumnCount] = {};
+    QList<EmployeeRecord> added;
+    for (const EmployeeRecord &incoming : records) {
+        const auto it = currentRows.constFind(incoming.userId);
+        if (it == currentRows.cend()) {
+            // A baseline without a row is a removal that has not been saved yet.
+            if (!m_baselines.contains(incoming.userId))
+                added.append(incoming);
+            continue;
+        }
+        const int row = it.value();
+        seen[row] = 1;
+        if (m_baselines.contains(incoming.userId))
+            continue;
+        if (sameRecord(m_records.at(row), incoming)) {
+            // No cell shows them; the caller learns of them through patch.touched.
+            EmployeeRecord &current = m_records[row];
+            if (current.lastSeen != incoming.lastSeen || current.createdAt != incoming.createdAt) {
+                current.lastSeen = incoming.lastSeen;
+                current.createdAt = incoming.createdAt;
+                ++patch.touched;
+            }
+            continue;
+        }
+        // A reload without password_hash keeps a hash fetched for this version of the row.
+        const EmployeeRecord &current = m_records.at(row);
+        for (int column = 0; column < ColumnCount; ++column) {
+            if (isSortable(column) && columnText(current, column) != columnText(incoming, column))
+                sortedColumnChanged[column] = true;
+        }
+        const bool keepHash = !incoming.passwordHashLoaded && current.passwordHashLoaded
+                              && current.rowVersion == incoming.rowVersion;
+        const QString keptHash = keepHash ? current.passwordHash : QString();
+        m_records[row] = incoming;
+        if (keepHash) {
+            m_records[row].passwordHash = keptHash;
+            m_records[row].passwordHashLoaded = true;
+        }
+        changedRows.push_back(row);
+    }
+
+    // Changed rows, one dataChanged per contiguous run.
+    std::sort(changedRows.begin(), changedRows.end());
+    for (std::size_t i = 0; i < changedRows.size();) {
+        std::size_t last = i;
+        while (last + 1 < changedRows.size() && changedRows[last + 1] == changedRows[last] + 1)
+            ++last;
+        emit dataChanged(index(changedRows[i], 0), index(changedRows[last], ColumnCount - 1),
+                         {Qt::DisplayRole, Qt::EditRole});
+        i = last + 1;
+    }
+    patch.changed = int(changedRows.size());
+
+    // Vanished rows, bottom-up so the rows above keep their numbers. Rows with a
+    // baseline are unsaved inserts and stay.
+    auto vanished = [&](int row) {
+        return !seen[row] && !m_baselines.contains(m_records.at(row).userId);
+    };
+    for (int row = int(seen.size()) - 1; row >= 0;) {
+        if (!vanished(row)) {
+            --row;
+            continue;
+        }
+        int first = row;
+        while (first > 0 && vanished(first - 1))
+            --first;
+        beginRemoveRows(QModelIndex(), first, row);
+        m_records.remove(first, row - first + 1);
+        endRemoveRows();
+        patch.removed += row - first + 1;
+        row = first - 1;
+    }
+
+    if (!added.isEmpty()) {
+        const int first = m_records.size();
+        beginInsertRows(QModelIndex(), first, first + added.size() - 1);
+        m_records.append(added);
+        endInsertRows();
+        patch.inserted = added.size();
+    }
+
+    span.setRows(patch.inserted + patch.removed + patch.changed);
+    if (patch.inserted + patch.removed > 0) {
+        invalidate();
+        if (!m_sortKeys.isEmpty())
+            sortBy(m_sortKeys);
+        return patch;
+    }
+
+    // Changed rows keep their place unless a value they are sorted by moved.
+    bool resort = false;
+    for (int column = 0; column < ColumnCount; ++column) {
+        if (!sortedColumnChanged[column])
+            continue;
+        invalidate(column);
+        for (const SortKey &key : std::as_const(m_sortKeys))
+            resort = resort || key.column == column;
+    }
+    if (resort)
+        sortBy(m_sortKeys);
+    return patch;
+}
+
+void EmployeeModel::insertRecord(int row, const EmployeeRecord &record, bool unsaved)
+{
+    row = qBound(0, row, m_records.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_records.insert(row, record);
+    if (unsaved)
+        m_baselines.insert(record.userId, record);
+    invalidate();
+    endInsertRows();
+}
+
+void EmployeeModel::removeRecord(int row, bool unsaved)
+{
+    if (row < 0 || row >= m_records.size())
+        return;
+    beginRemoveRows(QModelIndex(), row, row);
+    const EmployeeRecord &removed = m_records.at(row);
+    if (!unsaved)
+        m_baselines.remove(removed.userId);
+    else if (!m_baselines.contains(removed.userId))
+        m_baselines.insert(removed.userId, removed);
+    m_records.removeAt(row);
+    invalidate();
+    endRemoveRows();
+}
+
+void EmployeeModel::setStatus(int row, const QString &status)
+{
+    if (row < 0 || row >= m_records.size())
+        return;
+    m_records[row].status = status;
+    invalidate(StatusColumn);
+    const QModelIndex changed = index(row, StatusColumn);
+    emit dataChanged(changed, changed, {Qt::DisplayRole, Qt::EditRole});
+}
+
+int EmployeeModel::rowOfUser(const QString &userId) const
+{
+    for (int row = 0; row < m_records.size(); ++row) {
+        if (m_records.at(row).userId == userId)
+            return row;
+    }
+    return -1;
+}
+
+EmployeeRecord EmployeeModel::baseline(int row) const
+{
+    const EmployeeRecord &record = m_records.at(row);
+    return m_baselines.value(record.userId, record);
+}
+
+void EmployeeModel::commitRow(const EmployeeRecord &committed)
+{
+    const int row = rowOfUser(committed.userId);
+    if (row < 0) {
+        m_baselines.remove(committed.userId);   // a saved removal
+        return;
+    }
+
+    EmployeeRecord &record = m_records[row];
+    record.rowVersion = committed.rowVersion;
+    // Edits made after this write was queued are still unsaved; they now build on it.
+    // A write made without the hash loaded did not touch the password.
+    if (record.role == committed.role && record.status == committed.status
+        && (record.passwordHash == committed.passwordHash || !committed.passwordHashLoaded))
+        m_baselines.remove(record.userId);
+    else
+        m_baselines.insert(record.userId, committed);
+}
+
+void EmployeeModel::revertRow(const EmployeeRecord &restored)
+{
+    m_baselines.remove(restored.userId);
+
+    const int row = rowOfUser(restored.userId);
+    if (row < 0) {
+        insertRecord(0, restored);
+        return;
+    }
+    m_records[row] = restored;
+    invalidate();
+    emit dataChanged(index(row, 0), index(row, ColumnCount - 1), {Qt::DisplayRole, Qt::EditRole});
+}
+
+void EmployeeModel::requestPasswordHash(int row) const
+{
+    const QString &userId = m_records.at(row).userId;
+    if (m_hashRequests.contains(userId))
+        return;
+    m_hashRequests.insert(userId, row);
+    m_unsentHashRequests.append(userId);
+    if (m_hashRequestsQueued)
+        return;
+    // Every cell the view paints in this pass joins the same request.
+    m_hashRequestsQueued = true;
+    QMetaObject::invokeMethod(const_cast<EmployeeModel *>(this), &EmployeeModel::sendPasswordHashRequests,
+                              Qt::QueuedConnection);
+}
+
+void EmployeeModel::sendPasswordHashRequests()
+{
+    m_hashRequestsQueued = false;
+    if (m_unsentHashRequests.isEmpty())
+        return;
+    const QStringList userIds = std::exchange(m_unsentHashRequests, QStringList());
+    emit passwordHashesNeeded(userIds);
+}
+
+void EmployeeModel::setPasswordHashes(const QStringList &userIds, const QHash<QString, QString> &hashes)
+{
+    TraceSpan span("ui", "EmployeeModel::setPasswordHashes");
+    span.setRows(userIds.size());
+
+    QHash<QString, int> rowsByUser;   // built only when a row hint has gone stale
+    std::vector<int> changedRows;
+    for (const QString &userId : userIds) {
+        int row = m_hashRequests.value(userId, -1);
+        m_hashRequests.remove(userId);
+        if (row < 0 || row >= m_records.size() || m_records.at(row).userId != userId) {
+            if (rowsByUser.isEmpty()) {
+                rowsByUser.reserve(m_records.size());
+                for (int i = 0; i < m_records.size(); ++i)
+                    rowsByUser.insert(m_records.at(i).userId, i);
+            }
+            row = rowsByUser.value(userId, -1);
+        }
+
+        const QString hash = hashes.value(userId);
+        if (row >= 0 && !m_records.at(row).passwordHashLoaded) {
+            m_records[row].passwordHash = hash;
+            m_records[row].passwordHashLoaded = true;
+            changedRows.push_back(row);
+        }
+        const auto baseline = m_baselines.find(userId);
+        if (baseline != m_baselines.end() && !baseline->passwordHashLoaded) {
+            baseline->passwordHash = hash;
+            baseline->passwordHashLoaded = true;
+        }
+    }
+
+    std::sort(changedRows.begin(), changedRows.end());
+    for (std::size_t i = 0; i < changedRows.size();) {
+        std::size_t last = i;
+        while (last + 1 < changedRows.size() && changedRows[last + 1] == changedRows[last] + 1)
+            ++last;
+        emit dataChanged(index(changedRows[i], PasswordColumn), index(changedRows[last], PasswordColumn),
+                         {Qt::DisplayRole, Qt::EditRole});
+        i = last + 1;
+    }
+}
+
+void EmployeeModel::abandonPasswordHashes(const QStringList &userIds)
+{
+    for (const QString &userId : userIds)
+        m_hashRequests.remove(userId);
+}
+
+QStringList EmployeeModel::missingPasswordHashes() const
+{
+    QStringList userIds;
+    for (const EmployeeRecord &record : m_records) {
+        if (!record.passwordHashLoaded)
+            userIds.append(record.userId);
+    }
+    return userIds;
+}
+
+bool EmployeeModel::isSortable(int column)
+{
+    return column == UserIdColumn || column == RoleColumn || column == StatusColumn;
+}
+
+void EmployeeModel::sort(int column, Qt::SortOrder order)
+{
+    SortKey key;
+    key.column = column;
+    key.order = order;
+    sortBy({key});
+}
+
+void EmployeeModel::sortBy(const QList<SortKey> &keys)
+{
+    m_sortTask.cancel();
+
+    QList<SortKey> sortable;
+    for (const SortKey &key : keys) {
+        if (isSortable(key.column))
+            sortable.append(key);
+    }
+    m_sortKeys = sortable;
+    if (sortable.isEmpty() || m_records.size() < 2)
+        return;
+
+    const QList<EmployeeRecord> snapshot = m_records;
+    const QVector<Ranks> cached = m_ranks;
+    const quint64 generation = m_generation;
+    QPointer<EmployeeModel> self(this);
+
+    emit sortStarted();
+    m_sortTask = TaskScheduler::instance().submit(
+        TaskScheduler::Interactive, "employees.sort",
+        [self, snapshot, cached, sortable, generation](const TaskHandle &task) {
+            TraceSpan span("sort", "employees.sort");
+            span.setRows(snapshot.size());
+            AllocationScope allocations("employees.sort");
+            std::pmr::monotonic_buffer_resource scratch(scratchBytes(snapshot.size()));
+
+            QVector<Ranks> ranks = cached;
+            for (const SortKey &key : sortable) {
+                if (task.isCancelled())
+                    return;
+                if (!ranks.at(key.column))
+                    ranks[key.column] = computeRanks(snapshot, key.column, &scratch);
+            }
+            if (task.isCancelled())
+                return;
+            const QVector<int> order = orderByRanks(snapshot.size(), sortable, ranks, &scratch);
+
+            QMetaObject::invokeMethod(self.data(), [self, task, order, ranks, generation]() {
+                if (!self || task.isCancelled())
+                    return;
+                if (generation != self->m_generation) {
+                    // Rows changed while sorting; sort the current rows instead.
+                    self->sortBy(self->m_sortKeys);
+                    return;
+                }
+                self->applyOrder(order, ranks);
+            }, Qt::QueuedConnection);
+        });
+}
+
+QVector<int> EmployeeModel::sortedOrder(const QList<EmployeeRecord> &records,
+                                        const QList<SortKey> &keys,
+                                        const TaskHandle &task)
+{
+    AllocationScope allocations("employees.sort");
+    std::pmr::monotonic_buffer_resource scratch(scratchBytes(records.size()));
+
+    QVector<Ranks> ranks(ColumnCount);
+    for (const SortKey &key : keys) {
+        if (task.isCancelled())
+            return QVector<int>();
+        if (!ranks.at(key.column))
+            ranks[key.column] = computeRanks(records, key.column, &scratch);
+    }
+    return orderByRanks(records.size(), keys, ranks, &scratch);
+}
+
+std::size_t EmployeeModel::scratchBytes(int rowCount)
+{
+    // Per row: a value id (4 bytes) per ranked column and a packed (key, row) pair
+    // (16 bytes); the interning table and collation keys scale with distinct values.
+    return std::size_t(rowCount) * 32 + 16 * 1024;
+}
+
+const QString &EmployeeModel::columnText(const EmployeeRecord &record, int column)
+{
+    switch (column) {
+    case UserIdColumn:   return record.userId;
+    case RoleColumn:     return record.role;
+    case StatusColumn:   return record.status;
+    case PasswordColumn: return record.passwordHash;
+    default:             break;
+    }
+    static const QString empty;
+    return empty;
+}
+
+EmployeeModel::Ranks EmployeeModel::computeRanks(const QList<EmployeeRecord> &records, int column,
+                                                 std::pmr::memory_resource *scratch)
+{
+    TraceSpan span("sort", "employees.ranks");
+    span.setRows(records.size());
+
+    // Intern the values first: roles and statuses only have a handful of distinct
+    // values, so the collator runs on those instead of on every row. The table
+    // views the records' own strings; nothing is copied.
+    std::pmr::unordered_map<QStringView, quint32, StringViewHash> ids(scratch);
+    std::pmr::vector<const QString *> distinct(scratch);
+    std::pmr::vector<quint32> valueIds(records.size(), scratch);
+    for (int i = 0; i < records.size(); ++i) {
+        const QString &value = columnText(records.at(i), column);
+        auto inserted = ids.try_emplace(QStringView(value), quint32(distinct.size()));
+        if (inserted.second)
+            distinct.push_back(&value);
+        valueIds[i] = inserted.first->second;
+    }
+
+    // Case-insensitive, numeric-aware ordering in the user's locale; collation keys
+    // make each comparison a plain byte compare.
+    QCollator collator;
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    collator.setNumericMode(true);
+    std::pmr::vector<QCollatorSortKey> keys(scratch);
+    keys.reserve(distinct.size());
+    for (const QString *value : distinct)
+        keys.push_back(collator.sortKey(*value));
+
+    std::pmr::vector<quint32> byValue(distinct.size(), scratch);
+    std::iota(byValue.begin(), byValue.end(), 0u);
+    std::sort(byValue.begin(), byValue.end(), [&keys](quint32 a, quint32 b) {
+        return keys[a].compare(keys[b]) < 0;
+    });
+
+    std::pmr::vector<quint32> rankOfValue(distinct.size(), scratch);
+    quint32 rank = 0;
+    for (size_t i = 0; i < byValue.size(); ++i) {
+        if (i > 0 && keys[byValue[i - 1]].compare(keys[byValue[i]]) != 0)
+            ++rank;
+        rankOfValue[byValue[i]] = rank;
+    }
+
+    auto result = std::make_shared<RankColumn>();
+    result->maxRank = rank;
+    result->ranks.resize(records.size());
+    for (size_t i = 0; i < valueIds.size(); ++i)
+        result->ranks[i] = rankOfValue[valueIds[i]];
+    return result;
+}
+
+QVector<int> EmployeeModel::orderByRanks(int rowCount, const QList<SortKey> &keys,
+                                         const QVector<Ranks> &ranks,
+                                         std::pmr::memory_resource *scratch)
+{
+    int totalBits = 0;
+    for (const SortKey &key : keys)
+        totalBits += bitWidth(ranks.at(key.column)->maxRank);
+
+    QVector<int> order(rowCount);
+
+    if (totalBits <= 64) {
+        // Pack all keys into one integer (descending keys inverted) and sort
+        // (key, row) pairs; the row index breaks ties, which keeps the sort stable.
+        std::pmr::vector<std::pair<quint64, int>> packed(rowCount, scratch);
+        for (int row = 0; row < rowCount; ++row) {
+            quint64 composite = 0;
+            for (const SortKey &key : keys) {
+                const RankColumn &column = *ranks.at(key.column);
+                quint32 r = column.ranks[row];
+                if (key.order == Qt::DescendingOrder)
+                    r = column.maxRank - r;
+                composite = (composite << bitWidth(column.maxRank)) | r;
+            }
+            packed[row] = {composite, row};
+        }
+        std::sort(packed.begin(), packed.end());
+        for (int i = 0; i < rowCount; ++i)
+            order[i] = packed[i].second;
+        return order;
+    }
+
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        for (const SortKey &key : keys) {
+            const std::vector<quint32> &r = ranks.at(key.column)->ranks;
+            if (r[a] != r[b])
+                return key.order == Qt::AscendingOrder ? r[a] < r[b] : r[a] > r[b];
+        }
+        return false;
+    });
+    return order;
+}
+
+void EmployeeModel::applyOrder(const QVector<int> &order, const QVector<Ranks> &ranks)
+{
+    TraceSpan span("ui", "employees.applyOrder");
+    span.setRows(order.size());
+    AllocationScope allocations("employees.applyOrder");
+
+    // order[newRow] == oldRow
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    QVector<int> newRowOf(order.size());
+    for (int newRow = 0; newRow < order.size(); ++newRow)
+        newRowOf[order.at(newRow)] = newRow;
+
+    QList<EmployeeRecord> sorted;
+    sorted.reserve(m_records.size());
+    for (int oldRow : order)
+        sorted.append(std::move(m_records[oldRow]));
+    m_records = std::move(sorted);
+
+    // Keep the cached ranks aligned with the new row order.
+    for (int column = 0; column < ColumnCount; ++column) {
+        const Ranks &source = ranks.at(column) ? ranks.at(column) : m_ranks.at(column);
+        if (!source) {
+            m_ranks[column].reset();
+            continue;
+        }
+        auto permuted = std::make_shared<RankColumn>();
+        permuted->maxRank = source->maxRank;
+        permuted->ranks.resize(order.size());
+        for (int newRow = 0; newRow < order.size(); ++newRow)
+            permuted->ranks[newRow] = source->ranks[order.at(newRow)];
+        m_ranks[column] = permuted;
+    }
+
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex &index : from)
+        to.append(this->index(newRowOf.at(index.row()), index.column()));
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+    emit sortFinished();
+}
+
+void EmployeeModel::invalidate(int column)
+{
+    ++m_generation;
+    if (column < 0) {
+        for (Ranks &ranks : m_ranks)
+            ranks.reset();
+    } else {
+        m_ranks[column].reset();
+    }
+}
@@ -0,0 +1,164 @@
+#ifndef EMPLOYEEMODEL_H
+#define EMPLOYEEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "employeerecord.h"
+#include "taskscheduler.h"
+
+// Table model behind the dashboard's employee view.
+//
+// Sorting never runs on the GUI thread: sort() snapshots the records (implicitly
+// shared, so this is a pointer copy) and hands them to the scheduler. The task
+// turns each sort column into integer ranks (the collator only orders the distinct
+// values), stable-sorts row indices over those ranks, and the model applies the
+// result as one permutation between layoutAboutToBeChanged/layoutChanged.
+// Ranks are cached per column until the rows change, so re-sorting is a pure
+// integer sort. A sort's scratch data (interning table, collation order, packed
+// keys) lives in one monotonic arena that is dropped as a whole when the task ends.
+//
+// Rows may arrive without their password hash (DatabaseLoader without
+// password_hash). The view only asks for the cells it paints, so a hash is
+// requested the first time its cell is painted: the requests of one event loop
+// pass go out together as passwordHashesNeeded(), and setPasswordHashes() fills
+// them in.
+class EmployeeModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        UserIdColumn = 0,
+        RoleColumn,
+        StatusColumn,
+        PasswordColumn,
+        ActionsColumn,
+        ColumnCount
+    };
+
+    struct SortKey {
+        int column = UserIdColumn;
+        Qt::SortOrder order = Qt::AscendingOrder;
+    };
+
+    explicit EmployeeModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+
+    // Single-column sort, as requested by QTableView::sortByColumn().
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // Multi-column sort: keys are compared in order. Runs asynchronously; a newer
+    // request or any change to the rows supersedes a pending one.
+    void sortBy(const QList<SortKey> &keys);
+    QList<SortKey> sortKeys() const { return m_sortKeys; }
+    static bool isSortable(int column);
+
+    // Replaces all rows (a model reset) and re-applies the current sort order.
+    void setRecords(const QList<EmployeeRecord> &records);
+
+    struct Patch {
+        int inserted = 0;
+        int removed = 0;
+        int changed = 0;
+        int touched = 0;    // only last_seen/created_at moved; no signal was emitted
+    };
+
+    // Brings the rows in line with a fresh result set, keyed by user_id: changed
+    // rows get dataChanged, vanished ones are removed and new ones appended, each
+    // contiguous run as one notification. Rows keep their place, so views keep
+    // selection, scroll position and hidden rows; the current sort is re-applied
+    // only when rows came or went or a column it sorts by changed. A row whose only
+    // difference is last_seen/created_at takes them over without a notification and
+    // is counted in Patch::touched. Rows with unsaved changes are left alone.
+    Patch mergeRecords(const QList<EmployeeRecord> &records);
+
+    const QList<EmployeeRecord> &records() const { return m_records; }
+    const EmployeeRecord &record(int row) const { return m_records.at(row); }
+
+    // An 'unsaved' insert or removal is kept across mergeRecords() until
+    // commitRow() or revertRow() settles it.
+    void insertRecord(int row, const EmployeeRecord &record, bool unsaved = false);
+    void removeRecord(int row, bool unsaved = false);
+    void setStatus(int row, const QString &status);
+    int rowOfUser(const QString &userId) const;
+
+    // Optimistic edits: setData() changes the row at once and remembers the last
+    // state known to be in the database. baseline() returns that state (the row
+    // itself when it has no unsaved edits); commitRow()/revertRow() settle it once
+    // the background write reports back.
+    EmployeeRecord baseline(int row) const;
+    void commitRow(const EmployeeRecord &committed);
+    void revertRow(const EmployeeRecord &restored);
+
+    // Answer to passwordHashesNeeded(): every requested user counts as loaded
+    // afterwards, with an empty hash if it is missing from 'hashes'. Rows whose hash
+    // is already known (or was typed in meanwhile) are left alone.
+    void setPasswordHashes(const QStringList &userIds, const QHash<QString, QString> &hashes);
+    // The request failed; the users are asked for again when next painted.
+    void abandonPasswordHashes(const QStringList &userIds);
+    // Users whose hash has not been loaded, for callers that need every row (export).
+    QStringList missingPasswordHashes() const;
+
+    // Text shown in 'column' for a record (empty for the Actions column).
+    static const QString &columnText(const EmployeeRecord &record, int column);
+
+    // Stable order of row indices for the given keys; used by the sort task and the benchmarks.
+    static QVector<int> sortedOrder(const QList<EmployeeRecord> &records,
+                                    const QList<SortKey> &keys,
+                                    const TaskHandle &task = TaskHandle());
+
+signals:
+    void sortStarted();
+    void sortFinished();
+    void passwordHashesNeeded(const QStringList &userIds);
+
+private:
+    // Dense rank of each row's value in one column (equal values share a rank).
+    struct RankColumn {
+        std::vector<quint32> ranks;
+        quint32 maxRank = 0;
+    };
+    using Ranks = std::shared_ptr<const RankColumn>;
+
+    // Initial arena size for sorting 'rowCount' rows, so that a sort normally takes
+    // one block from the heap.
+    static std::size_t scratchBytes(int rowCount);
+
+    static Ranks computeRanks(const QList<EmployeeRecord> &records, int column,
+                              std::pmr::memory_resource *scratch);
+    static QVector<int> orderByRanks(int rowCount, const QList<SortKey> &keys, const QVector<Ranks> &ranks,
+                                     std::pmr::memory_resource *scratch);
+
+    void applyOrder(const QVector<int> &order, const QVector<Ranks> &ranks);
+    void invalidate(int column = -1);
+    void requestPasswordHash(int row) const;
+    void sendPasswordHashRequests();
+
+    QList<EmployeeRecord> m_records;
+    QHash<QString, EmployeeRecord> m_baselines;   // by user_id, rows with unsaved edits, inserts or removals
+    QList<SortKey> m_sortKeys;
+    QVector<Ranks> m_ranks;     // per column, in current row order; null when stale
+    quint64 m_generation = 0;   // bumped whenever rows are added, removed or edited
+    TaskHandle m_sortTask;
+
+    // Lazily loaded password hashes: every user asked for and not answered yet,
+    // with its row at the time (a hint; sorting moves rows), and those not sent yet.
+    mutable QHash<QString, int> m_hashRequests;
+    mutable QStringList m_unsentHashRequests;
+    mutable bool m_hashRequestsQueued = false;
+};
+
+#endif // EMPLOYEEMODEL_H
@@ -0,0 +1,30 @@
+#ifndef EMPLOYEERECORD_H
+#define EMPLOYEERECORD_H
+
+#include <QString>
+#include <QList>
+#include <QDateTime>
+#include <QMetaType>
+
+// One row of the 'empl' table, decoded by DatabaseLoader.
+struct EmployeeRecord
+{
+    QString userId;
+    QString hwid;
+    QString role;
+    QString status;
+    QString passwordHash;
+    // False when the row was loaded without password_hash (passwordHash is then
+    // empty); the grid fetches it when the password column is on screen.
+    bool passwordHashLoaded = true;
+    // Bumped by every directory edit; writes carry the version they were based on.
+    qint64 rowVersion = 0;
+    // Null when unknown (never seen / created before created_at existed).
+    QDateTime lastSeen;
+    QDateTime createdAt;
+};
+
+Q_DECLARE_METATYPE(EmployeeRecord)
+Q_DECLARE_METATYPE(QList<EmployeeRecord>)
+
+#endif // EMPLOYEERECORD_H
@@ -8,28 +8,41 @@
 #include <QSqlError>
 #include <QMessageBox>
 #include <QDebug>
-#include <QGraphicsDropShadowEffect>
-#include <QHBoxLayout>
 #include <QPushButton>
 #include <QTableWidgetItem>
+#include <QGuiApplication>
 #include <algorithm>
 #include <QFileDialog>
-#include <QThread>
 #include <QEvent>
-#include <QCryptographicHash>
 #include <QRandomGenerator>
+#include <QShortcut>
+#include <QTabWidget>
+#include <QTimeZone>
+#include <QHeaderView>
+#include <QMenu>
+#include <QPointer>
 
 #include "pdfexportworker.h"
 #include "databaseloader.h"
+#include "employeemodel.h"
+#include "employeeactiondelegate.h"
+#include "presenceservice.h"
+#include "writebehindqueue.h"
+#include "userrepository.h"
+#include "statements.h"
+#include "storagebackend.h"
+#include "tracing.h"
+#include "diagnosticsdialog.h"
+#include "shadowmanager.h"
+#include "taskscheduler.h"
+#include "dashboardanalytics.h"
+#include "dashboardviews.h"
+#include "appconfig.h"
+#include "shareddirectorycache.h"
 
 // Utility functions to convert hardware IDs
 QString convertHwidToFriendlyId(const QString &hwid) {
-    QString friendly = hwid;
-    std::reverse(friendly.begin(), friendly.end());
-    if (friendly.length() > 10) {
-        friendly = friendly.left(10);
-    }
-    return friendly;
+    return UserRepository::friendlyIdFromHwid(hwid);
 }
 
 QString convertFriendlyIdToHwid(const QString &friendlyId) {
@@ -41,31 +54,102 @@ QString convertFriendlyIdToHwid(const QString &friendlyId) {
 home::home(QWidget *parent)
     : QWidget(parent)
     , ui(new Ui::home)
+    , employeeModel(nullptr)
+    , presence(nullptr)
+    , journal(nullptr)
+    , writeQueue(nullptr)
+    , shadows(nullptr)
     , activityChartView(nullptr)
     , userStatusChartWidget(nullptr)
+    , analytics(nullptr)
+    , analyticsTimer(nullptr)
+    , roleChartView(nullptr)
+    , registrationChartView(nullptr)
 {
     ui->setupUi(this);
+    qRegisterMetaType<QList<EmployeeRecord>>("QList<EmployeeRecord>");
     this->setWindowTitle("ARCHIFLOW 1.0.0 Beta");
     setWindowFlags(Qt::Window | Qt::FramelessWindowHint);
     applyShadowEffect();
 
-    // Set up table columns for employee data
-    QStringList headers = {"User ID", "Role", "Status", "Password", "Actions"};
-    ui->tableWidget->setColumnCount(5);
-    ui->tableWidget->setHorizontalHeaderLabels(headers);
-    ui->tableWidget->setSortingEnabled(true);
-
-    connect(ui->tableWidget->horizontalHeader(), &QHeaderView::sectionClicked,
+    // Employee table: the model sorts off the GUI thread, so the view's own
+    // sorting stays disabled and header clicks are routed to the model.
+    employeeModel = new EmployeeModel(this);
+    ui->tableView->setModel(employeeModel);
+    ui->tableView->setSortingEnabled(false);
+    ui->tableView->horizontalHeader()->setSectionsClickable(true);
+    ui->tableView->horizontalHeader()->setSortIndicatorShown(true);
+    ui->tableView->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+
+    EmployeeActionDelegate *actionDelegate = new EmployeeActionDelegate(this);
+    ui->tableView->setItemDelegateForColumn(EmployeeModel::ActionsColumn, actionDelegate);
+    connect(actionDelegate, &EmployeeActionDelegate::editClicked, this, &home::handleEditButton);
+    connect(actionDelegate, &EmployeeActionDelegate::deleteClicked, this, &home::handleDeleteButton);
+
+    connect(ui->tableView->horizontalHeader(), &QHeaderView::sectionClicked,
             this, &home::onTableHeaderSectionClicked);
 
+    // The password column starts hidden and the directory is then loaded without
+    // password_hash; once shown (header context menu), the model asks for the
+    // hashes of the rows on screen.
+    ui->tableView->setColumnHidden(EmployeeModel::PasswordColumn, true);
+    ui->tableView->horizontalHeader()->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui->tableView->horizontalHeader(), &QHeaderView::customContextMenuRequested,
+            this, [this](const QPoint &pos) {
+        QMenu menu(this);
+        QAction *showPasswords = menu.addAction("Show password hashes");
+        showPasswords->setCheckable(true);
+        showPasswords->setChecked(!ui->tableView->isColumnHidden(EmployeeModel::PasswordColumn));
+        connect(showPasswords, &QAction::toggled, this, [this](bool checked) {
+            ui->tableView->setColumnHidden(EmployeeModel::PasswordColumn, !checked);
+        });
+        menu.exec(ui->tableView->horizontalHeader()->mapToGlobal(pos));
+    });
+    connect(employeeModel, &EmployeeModel::passwordHashesNeeded, this, [this](const QStringList &userIds) {
+        loadPasswordHashes(userIds);
+    });
+    // Rows that arrive with a reload are filtered by the last search like the rest.
+    connect(employeeModel, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &, int first, int last) {
+        if (!m_searchText.isEmpty())
+            applySearch(first, last);
+    });
+
+    m_hwid = login::getHwid();
+    m_clientUserId = login::convertHwidToFriendlyId(m_hwid);
+
+    // Changes show up at once and are saved in the background through the local
+    // journal, which keeps them across a lost connection or a restart.
+    journal = new WriteJournal(this);
+    connect(journal, &WriteJournal::settled, this, &home::onJournalSettled);
+    connect(journal, &WriteJournal::onlineChanged, this, [this](bool online) {
+        if (online)
+            logActivity("Database reachable again; sending queued changes.");
+        else
+            logActivity(QString("Database offline; %1 change(s) queued locally.").arg(journal->pendingCount()));
+    });
+    if (journal->recoveredCount() > 0) {
+        const int recovered = journal->recoveredCount();
+        connect(journal, &WriteJournal::drained, this, [this, recovered]() {
+            logActivity(QString("Saved %1 change(s) left over from the last session.").arg(recovered));
+            startDatabaseLoading();
+        }, Qt::SingleShotConnection);
+    }
+
+    logActivity(QString("Signed in as %1.").arg(m_clientUserId), Activity::Audit);
+
+    writeQueue = new WriteBehindQueue(journal, this);
+    connect(writeQueue, &WriteBehindQueue::committed, this, &home::onWriteCommitted);
+    connect(writeQueue, &WriteBehindQueue::failed, this, &home::onWriteFailed);
+    connect(qApp, &QCoreApplication::aboutToQuit, writeQueue, &WriteBehindQueue::flushNow);
+
     // Setup a timer to display current time
     QTimer *timer = new QTimer(this);
     connect(timer, &QTimer::timeout, this, [=]() {
         ui->label_2->setText(QDateTime::currentDateTime().toString("hh:mm:ss"));
     });
-    timer->start(1000);
+    timer->start(AppConfig::intValue(AppConfig::ClockIntervalMs));
 
-    connect(ui->tableWidget, &QTableWidget::cellDoubleClicked,
+    connect(ui->tableView, &QTableView::doubleClicked,
             this, &home::handleStatusToggle);
 
     connect(ui->exportpdf, &QPushButton::clicked,
@@ -76,6 +160,18 @@ home::home(QWidget *parent)
         QMessageBox::critical(this, "Database Error", "Failed to connect to the database.");
     } else {
         startDatabaseLoading();
+
+        // Presence: coalesced heartbeats out, server-side Online/Offline totals in.
+        presence = new PresenceService(m_clientUserId, this);
+        connect(presence, &PresenceService::statusPublished, this, [this](const QString &userId, const QString &status) {
+            employeeModel->setStatus(employeeModel->rowOfUser(userId), status);
+            logActivity(QString("Set status for %1 to %2").arg(userId, status));
+        });
+        connect(presence, &PresenceService::countsChanged, this, &home::applyUserCounts);
+        connect(presence, &PresenceService::error, this, [](const QString &message) {
+            qDebug() << message;
+        });
+        connect(qApp, &QCoreApplication::aboutToQuit, presence, &PresenceService::publishOfflineNow);
     }
 
     connect(ui->whitelist_table, &QTableWidget::itemChanged,
@@ -83,12 +179,30 @@ home::home(QWidget *parent)
 
     setupActivityChart();
     setupUserStatusChart();
+    setupAnalyticsCharts();
 
     QTimer *statusTimer = new QTimer(this);
     connect(statusTimer, &QTimer::timeout, this, &home::recordUserStatusSnapshot);
-    statusTimer->start(60000); // every minute
+    statusTimer->start(AppConfig::intValue(AppConfig::StatusSnapshotMs));
+
+    // Timer intervals follow the configuration file as it is edited.
+    connect(&AppConfig::instance(), &AppConfig::changed, this, [=](AppConfig::Setting setting) {
+        if (setting == AppConfig::ClockIntervalMs)
+            timer->setInterval(AppConfig::intValue(setting));
+        else if (setting == AppConfig::StatusSnapshotMs)
+            statusTimer->setInterval(AppConfig::intValue(setting));
+        else if (setting == AppConfig::AnalyticsDebounceMs)
+            analyticsTimer->setInterval(AppConfig::intValue(setting));
+    });
 
     updateWhitelistTable();
+
+    // Hidden diagnostics: statement latency percentiles and trace export.
+    QShortcut *diagnosticsShortcut = new QShortcut(QKeySequence("Ctrl+Shift+D"), this);
+    connect(diagnosticsShortcut, &QShortcut::activated, this, [this]() {
+        DiagnosticsDialog *dialog = new DiagnosticsDialog(this, shadows);
+        dialog->show();
+    });
 }
 
 home::~home()
@@ -98,10 +212,11 @@ home::~home()
 
 bool home::connectToDatabase()
 {
-    db = QSqlDatabase::addDatabase("QODBC");
-    db.setDatabaseName("DRIVER={Oracle in XE};DBQ=XE;UID=DALI;PWD=dali;");
-    if (!db.open()) {
-        qDebug() << "Database connection error:" << db.lastError().text();
+    // All UI windows share the GUI thread's default connection of the configured backend.
+    QString errorText;
+    db = StorageBackend::instance().open(QString(), &errorText);
+    if (!db.isOpen()) {
+        qDebug() << "Database connection error:" << errorText;
         return false;
     }
     return true;
@@ -109,122 +224,155 @@ bool home::connectToDatabase()
 
 void home::applyShadowEffect()
 {
-    auto createShadow = [](QWidget *widget) {
-        QGraphicsDropShadowEffect *shadow = new QGraphicsDropShadowEffect(widget);
-        shadow->setBlurRadius(15);
-        shadow->setOffset(4, 4);
-        shadow->setColor(QColor(0, 0, 0, 80));
-        widget->setGraphicsEffect(shadow);
-    };
-
-    createShadow(ui->tableWidget);
-    if (ui->activityLogList) createShadow(ui->activityLogList);
-    if (ui->frame_2) createShadow(ui->frame_2);
-    if (ui->frame_4) createShadow(ui->frame_4);
-    if (ui->whitelist_table) createShadow(ui->whitelist_table);
-    if (ui->frame_3) createShadow(ui->frame_3);
+    // Cached shadows by default: the scrolling tables below would otherwise be
+    // re-blurred on every repaint. The charts register theirs when they are built.
+    shadows = new ShadowManager(this);
+    shadows->add(ui->tableView);
+    if (ui->activityLogList) shadows->add(ui->activityLogList);
+    if (ui->frame_2) shadows->add(ui->frame_2);
+    if (ui->frame_4) shadows->add(ui->frame_4);
+    if (ui->whitelist_table) shadows->add(ui->whitelist_table);
+    if (ui->frame_3) shadows->add(ui->frame_3);
+    connect(shadows, &ShadowManager::modeChanged, this, [this](ShadowManager::Mode mode) {
+        m_frameSpanName = QString("frame (shadows: %1)").arg(ShadowManager::modeName(mode));
+    });
+    m_frameSpanName = QString("frame (shadows: %1)").arg(ShadowManager::modeName(shadows->mode()));
+}
 
+bool home::event(QEvent *event)
+{
+    // One UpdateRequest is one frame: the backing store repaints every dirty widget,
+    // shadow effects included, before QWidget::event returns. The spans are named
+    // after the shadow mode so the diagnostics dialog compares the modes directly.
+    if (event->type() == QEvent::UpdateRequest) {
+        TraceSpan span("ui.frame", m_frameSpanName);
+        return QWidget::event(event);
+    }
+    return QWidget::event(event);
 }
 
-void home::logActivity(const QString &activity)
+void home::logActivity(const QString &activity, Activity kind)
 {
     QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss");
     ui->activityLogList->addItem(QString("%1: %2").arg(timestamp, activity));
 
+    // Each journaled line costs an fsync and an INSERT on the shared database.
+    if (kind == Activity::Audit) {
+        JournalEntry entry;
+        entry.kind = JournalEntry::Kind::Activity;
+        entry.userId = m_clientUserId;
+        entry.text = activity;
+        journal->append(entry);
+    }
+
     // Update the activity chart
-    QTimer::singleShot(100, this, &home::updateActivityChart);
+    QTimer::singleShot(AppConfig::intValue(AppConfig::ActivityChartDelayMs), this, &home::updateActivityChart);
 }
 
 void home::startDatabaseLoading()
 {
-    QThread *thread = new QThread;
+    // A newer reload supersedes one that is still queued.
+    m_loadTask.cancel();
+
     DatabaseLoader *loader = new DatabaseLoader;
-    loader->moveToThread(thread);
-    connect(thread, &QThread::started, loader, &DatabaseLoader::process);
-    connect(loader, &DatabaseLoader::finished, this, [=](const QList<QVariantMap> &records) {
+    // Hashes of a hidden password column are left on the server.
+    loader->setIncludePasswordHash(!ui->tableView->isColumnHidden(EmployeeModel::PasswordColumn));
+    loader->setUseSharedCache(true);
+    connect(loader, &DatabaseLoader::finished, this, [=](const QList<EmployeeRecord> &records) {
         updateEmployeeTable(records);
         updateUserCounts();
         logActivity("Loaded employee records asynchronously.");
-        thread->quit();
     });
     connect(loader, &DatabaseLoader::error, this, [=](const QString &errMsg) {
         QMessageBox::critical(this, "Database Loading Error", errMsg);
-        thread->quit();
     });
-    connect(loader, &DatabaseLoader::finished, loader, &QObject::deleteLater);
-    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
-    thread->start();
+    // The scheduler deletes the loader once process() returns, on success or error.
+    m_loadTask = TaskScheduler::instance().run(TaskScheduler::Load, "employees.load",
+                                               loader, &DatabaseLoader::process);
 }
 
-// ------------------ Employee Table ------------------
-
-void home::updateEmployeeTable(const QList<QVariantMap> &records)
+void home::loadPasswordHashes(const QStringList &userIds, TaskScheduler::Priority priority,
+                              const std::function<void()> &then)
 {
-    ui->tableWidget->setRowCount(0);
-
-    for (const QVariantMap &record : records) {
-        int row = ui->tableWidget->rowCount();
-        ui->tableWidget->insertRow(row);
-
-        ui->tableWidget->setItem(row, 0, new QTableWidgetItem(record["userId"].toString()));
-        ui->tableWidget->setItem(row, 1, new QTableWidgetItem(record["role"].toString()));
-        ui->tableWidget->setItem(row, 2, new QTableWidgetItem(record["status"].toString()));
-        ui->tableWidget->setItem(row, 3, new QTableWidgetItem(record["password_hash"].toString()));
-
-        QWidget *actionWidget = new QWidget;
-        QHBoxLayout *layout = new QHBoxLayout(actionWidget);
-        layout->setContentsMargins(0, 0, 0, 0);
-
-        QPushButton *editButton = new QPushButton("Edit", actionWidget);
-        editButton->setObjectName("editButton");
-        QPushButton *deleteButton = new QPushButton("Delete", actionWidget);
-        deleteButton->setObjectName("deleteButton");
-
-        layout->addWidget(editButton);
-        layout->addWidget(deleteButton);
-        actionWidget->setLayout(layout);
-        ui->tableWidget->setCellWidget(row, 4, actionWidget);
-
-        connect(editButton, &QPushButton::clicked, this, &home::handleEditButton);
-        connect(deleteButton, &QPushButton::clicked, this, &home::handleDeleteButton);
-    }
+    QPointer<home> self(this);
+    TaskScheduler::instance().submit(priority, "employees.password_hashes",
+        [self, userIds, then](const TaskHandle &) {
+            QString errorText;
+            QHash<QString, QString> hashes;
+            QSqlDatabase db = StorageBackend::instance().open(
+                StorageBackend::threadConnectionName("Lookup"), &errorText);
+            const bool ok = db.isOpen() && UserRepository::passwordHashes(db, userIds, &hashes, &errorText);
+
+            QMetaObject::invokeMethod(self.data(), [self, userIds, hashes, ok, errorText, then]() {
+                if (!self)
+                    return;
+                if (!ok) {
+                    self->employeeModel->abandonPasswordHashes(userIds);
+                    self->logActivity(QString("Could not load password hashes: %1").arg(errorText));
+                    return;
+                }
+                self->employeeModel->setPasswordHashes(userIds, hashes);
+                if (then)
+                    then();
+            }, Qt::QueuedConnection);
+        });
 }
 
-void home::onTableHeaderSectionClicked(int index)
+// ------------------ Employee Table ------------------
+
+void home::updateEmployeeTable(const QList<EmployeeRecord> &records)
 {
-    if (index == 3) {
-        bool currentlyHidden = ui->tableWidget->isColumnHidden(3);
-        ui->tableWidget->setColumnHidden(3, !currentlyHidden);
-    }
+    TraceSpan span("ui", "updateEmployeeTable");
+
+    // Only the rows that differ are touched; selection, scrolling, search and the
+    // password column survive the reload.
+    const EmployeeModel::Patch patch = employeeModel->mergeRecords(records);
+    span.setRows(patch.inserted + patch.removed + patch.changed + patch.touched);
+    // Heartbeat-only changes emit no model signal, but stale accounts and presence
+    // by role are computed from last_seen.
+    if (patch.touched > 0 && analyticsTimer)
+        analyticsTimer->start();
 }
 
-void home::updateCurrentUserStatus(const QString &status)
+void home::onTableHeaderSectionClicked(int index)
 {
-    // Generate the friendly ID from the current user's HWID
-    QString friendlyId = login::convertHwidToFriendlyId(login::getHwid());
-
-    QSqlQuery query(db);
-    query.prepare("UPDATE empl SET status = :status WHERE user_id = :id");
-    query.bindValue(":status", status);
-    query.bindValue(":id", friendlyId);
-    if (!query.exec()) {
-        QMessageBox::critical(this, "Database Error", query.lastError().text());
-        return;
-    }
+    QList<EmployeeModel::SortKey> keys = employeeModel->sortKeys();
+
+    if (index == EmployeeModel::PasswordColumn) {
+        bool currentlyHidden = ui->tableView->isColumnHidden(EmployeeModel::PasswordColumn);
+        ui->tableView->setColumnHidden(EmployeeModel::PasswordColumn, !currentlyHidden);
+    } else if (EmployeeModel::isSortable(index)) {
+        // Click sorts by that column alone (toggling its order); Shift+click adds it
+        // as the next key, or toggles it if it is already one.
+        auto existing = std::find_if(keys.begin(), keys.end(), [index](const EmployeeModel::SortKey &key) {
+            return key.column == index;
+        });
+        const bool extend = QGuiApplication::keyboardModifiers() & Qt::ShiftModifier;
+        if (extend && existing != keys.end()) {
+            existing->order = existing->order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+        } else if (extend) {
+            keys.append({index, Qt::AscendingOrder});
+        } else {
+            Qt::SortOrder order = Qt::AscendingOrder;
+            if (!keys.isEmpty() && keys.first().column == index && keys.first().order == Qt::AscendingOrder)
+                order = Qt::DescendingOrder;
+            keys = {{index, order}};
+        }
+        employeeModel->sortBy(keys);
 
-    // Update UI
-    for (int i = 0; i < ui->tableWidget->rowCount(); ++i) {
-        QTableWidgetItem *idItem = ui->tableWidget->item(i, 0);
-        if (idItem && idItem->text() == friendlyId) {
-            QTableWidgetItem *statusItem = ui->tableWidget->item(i, 2);
-            if (statusItem) {
-                statusItem->setText(status);
-            }
-            break;
+        QStringList description;
+        for (const EmployeeModel::SortKey &key : keys) {
+            description << QString("%1 %2").arg(employeeModel->headerData(key.column, Qt::Horizontal).toString(),
+                                                key.order == Qt::AscendingOrder ? "asc" : "desc");
         }
+        logActivity(QString("Sorted employees by %1.").arg(description.join(", ")));
     }
-    updateUserCounts();
-    logActivity(QString("Set status for %1 to %2").arg(friendlyId, status));
+
+    // The header moves the indicator on every click; it tracks the primary key only.
+    if (keys.isEmpty())
+        ui->tableView->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    else
+        ui->tableView->horizontalHeader()->setSortIndicator(keys.first().column, keys.first().order);
 }
 
 // ------------------ Buttons ------------------
@@ -243,23 +391,25 @@ void home::on_pushButton_5_clicked()
 
 void home::on_pushButton_2_clicked()
 {
-    QString searchText = ui->lineEdit_5->text().trimmed();
-    int searchColumn = ui->comboBox->currentIndex();
+    m_searchText = ui->lineEdit_5->text().trimmed();
+    m_searchColumn = ui->comboBox->currentIndex();
+    TraceSpan span("ui", "search");
+    span.setRows(employeeModel->rowCount());
 
-    for (int row = 0; row < ui->tableWidget->rowCount(); ++row) {
-        QTableWidgetItem *item = ui->tableWidget->item(row, searchColumn);
-        if (item) {
-            bool match = item->text().contains(searchText, Qt::CaseInsensitive);
-            ui->tableWidget->setRowHidden(row, !match);
-        }
-    }
-    logActivity(QString("Searched for '%1'.").arg(searchText));
+    applySearch(0, employeeModel->rowCount() - 1);
+    logActivity(QString("Searched for '%1'.").arg(m_searchText));
+}
+
+void home::applySearch(int firstRow, int lastRow)
+{
+    dashboardviews::applySearch(ui->tableView, employeeModel->records(), m_searchText, m_searchColumn,
+                                firstRow, lastRow);
 }
 
 void home::on_pushButton_3_clicked()
 {
-    QString hwid = login::getHwid();
-    QString userRef = convertHwidToFriendlyId(hwid);
+    QString hwid = m_hwid;
+    QString userRef = m_clientUserId;
     qDebug() << "Generated HWID:" << hwid;
     qDebug() << "Generated friendly userRef:" << userRef;
 
@@ -272,78 +422,30 @@ void home::on_pushButton_3_clicked()
 
     QString status = "Offline";
 
+    QString passwordHash = UserRepository::sha256Hex(plainPassword);
 
-    QSqlQuery checkQuery(db);
-    checkQuery.prepare("SELECT COUNT(*) FROM empl WHERE user_id = :id");
-    checkQuery.bindValue(":id", userRef);
-    if (!checkQuery.exec()) {
-        QMessageBox::critical(this, "Database Error", checkQuery.lastError().text());
-        return;
-    }
-    int count = 0;
-    if (checkQuery.next()) {
-        count = checkQuery.value(0).toInt();
-    }
-    if (count > 0) {
+    // A listed user is caught here; one added elsewhere meanwhile is caught by the
+    // unique constraint on user_id when the journal replays the insert.
+    if (employeeModel->rowOfUser(userRef) >= 0) {
         QMessageBox::warning(this, "Input Error", "This user already exists.");
         return;
     }
 
+    EmployeeRecord record;
+    record.userId = userRef;
+    record.hwid = hwid;
+    record.createdAt = QDateTime::currentDateTimeUtc();
+    record.role = role;
+    record.status = status;
+    record.passwordHash = passwordHash;
+    employeeModel->insertRecord(0, record, true);
 
-    QString passwordHash = QString(
-        QCryptographicHash::hash(plainPassword.toUtf8(), QCryptographicHash::Sha256).toHex()
-        );
-
-
-    if (!db.transaction()) {
-        QMessageBox::critical(this, "Transaction Error", "Failed to start database transaction.");
-        return;
-    }
-
-    QSqlQuery insertQuery(db);
-    insertQuery.prepare(
-        "INSERT INTO empl (user_id, hwid, role, status, password_hash) "
-        "VALUES (:id, :hwid, :role, :status, :pass)"
-        );
-    insertQuery.bindValue(":id", userRef);
-    insertQuery.bindValue(":hwid", hwid);
-    insertQuery.bindValue(":role", role);
-    insertQuery.bindValue(":status", status);
-    insertQuery.bindValue(":pass", passwordHash);
-
-    if (!insertQuery.exec()) {
-        db.rollback();
-        QMessageBox::critical(this, "Database Error", insertQuery.lastError().text());
-        return;
-    }
-    if (!db.commit()) {
-        QMessageBox::critical(this, "Transaction Error", "Failed to commit transaction.");
-        return;
-    }
+    JournalEntry entry;
+    entry.kind = JournalEntry::Kind::CreateUser;
+    entry.after = record;
+    journal->append(entry);
 
-    ui->tableWidget->insertRow(0);
-    ui->tableWidget->setItem(0, 0, new QTableWidgetItem(userRef));
-    ui->tableWidget->setItem(0, 1, new QTableWidgetItem(role));
-    ui->tableWidget->setItem(0, 2, new QTableWidgetItem(status));
-    ui->tableWidget->setItem(0, 3, new QTableWidgetItem(passwordHash));
-
-    QWidget *actionWidget = new QWidget();
-    QHBoxLayout *layout = new QHBoxLayout(actionWidget);
-    layout->setContentsMargins(0, 0, 0, 0);
-    QPushButton *editButton = new QPushButton("Edit", actionWidget);
-    editButton->setObjectName("editButton");
-    QPushButton *deleteButton = new QPushButton("Delete", actionWidget);
-    deleteButton->setObjectName("deleteButton");
-    layout->addWidget(editButton);
-    layout->addWidget(deleteButton);
-    actionWidget->setLayout(layout);
-    ui->tableWidget->setCellWidget(0, 4, actionWidget);
-
-    connect(editButton, &QPushButton::clicked, this, &home::handleEditButton);
-    connect(deleteButton, &QPushButton::clicked, this, &home::handleDeleteButton);
-
-    updateUserCounts();
-    logActivity(QString("Added user %1.").arg(userRef));
+    logActivity(QString("Added user %1.").arg(userRef), Activity::Audit);
 
     ui->lineEdit_3->clear();
     ui->lineEdit_6->clear();
@@ -352,140 +454,162 @@ void home::on_pushButton_3_clicked()
 }
 
 
-void home::handleEditButton()
+void home::handleEditButton(int rowToEdit)
 {
+    if (rowToEdit < 0 || rowToEdit >= employeeModel->rowCount()) return;
+
+    // Role and password hold whatever was typed into the cells; 'before' is the
+    // stored row the write is checked against.
+    const EmployeeRecord before = employeeModel->baseline(rowToEdit);
+    EmployeeRecord after = employeeModel->record(rowToEdit);
+    after.role = after.role.trimmed();
+
+    // Only a newly typed password gets hashed. An untouched cell still holds the
+    // stored hash, or the one an earlier edit of this row put there and is still
+    // being saved; hashing that again would lock the user out.
+    const QString shown = m_unsettledPasswordHashes.value(after.userId, before.passwordHash);
+    const QString typed = after.passwordHash.trimmed();
+    if (typed.isEmpty())
+        after.passwordHash = shown;
+    else if (typed != shown && typed != before.passwordHash)
+        after.passwordHash = UserRepository::sha256Hex(typed);
+    else
+        after.passwordHash = typed;
+
+    if (after.passwordHash != before.passwordHash)
+        m_unsettledPasswordHashes.insert(after.userId, after.passwordHash);
+    else
+        m_unsettledPasswordHashes.remove(after.userId);
+
+    employeeModel->setData(employeeModel->index(rowToEdit, EmployeeModel::RoleColumn), after.role);
+    employeeModel->setData(employeeModel->index(rowToEdit, EmployeeModel::PasswordColumn), after.passwordHash);
+    writeQueue->enqueueUpdate(before, after);
+}
 
 
-    QPushButton *button = qobject_cast<QPushButton*>(sender());
-    if (!button) return;
-
-    int rowToEdit = -1;
-    for (int row = 0; row < ui->tableWidget->rowCount(); ++row) {
-        QWidget *cellWidget = ui->tableWidget->cellWidget(row, 4);
-        if (!cellWidget) continue;
-        if (cellWidget->findChild<QPushButton*>("editButton") == button) {
-            rowToEdit = row;
-            break;
-        }
-    }
-    if (rowToEdit < 0) return;
+void home::handleDeleteButton(int rowToDelete)
+{
+    if (rowToDelete < 0 || rowToDelete >= employeeModel->rowCount()) return;
 
-    QString newRole = ui->tableWidget->item(rowToEdit, 1)->text().trimmed();
+    const EmployeeRecord before = employeeModel->baseline(rowToDelete);
+    employeeModel->removeRecord(rowToDelete, true);
+    writeQueue->enqueueDelete(before);
+}
 
-    QString newPass = ui->tableWidget->item(rowToEdit, 3)->text().trimmed();
+void home::handleStatusToggle(const QModelIndex &index)
+{
+    if (!index.isValid() || index.column() != EmployeeModel::StatusColumn) return;
+    const int row = index.row();
 
+    const EmployeeRecord before = employeeModel->baseline(row);
+    EmployeeRecord after = employeeModel->record(row);
+    after.status = (after.status.compare("Online", Qt::CaseInsensitive) == 0) ? "Offline" : "Online";
 
-    QString currentStatus = ui->tableWidget->item(rowToEdit, 2)->text();
-    QString userId = ui->tableWidget->item(rowToEdit, 0)->text();
+    employeeModel->setData(index, after.status);
+    writeQueue->enqueueUpdate(before, after);
+}
 
-    QString passHashToUse;
-    if (!newPass.isEmpty()) {
-        passHashToUse = QString(
-            QCryptographicHash::hash(newPass.toUtf8(), QCryptographicHash::Sha256).toHex()
-            );
+void home::onWriteCommitted(const EmployeeRecord &stored, bool deleted)
+{
+    // The state this write replaced, to log a status toggle apart from an edit.
+    const int row = employeeModel->rowOfUser(stored.userId);
+    const EmployeeRecord previous = row >= 0 ? employeeModel->baseline(row) : stored;
+
+    employeeModel->commitRow(stored);
+    // A later edit of the row may still be on its way.
+    if (deleted || m_unsettledPasswordHashes.value(stored.userId) == stored.passwordHash)
+        m_unsettledPasswordHashes.remove(stored.userId);
+    if (deleted) {
+        logActivity(QString("Deleted user %1.").arg(stored.userId), Activity::Audit);
     } else {
-        passHashToUse = ui->tableWidget->item(rowToEdit, 3)->text();
+        const bool statusChanged = previous.status != stored.status;
+        if (statusChanged)
+            logActivity(QString("Changed status for %1 to %2.").arg(stored.userId, stored.status),
+                        Activity::Audit);
+        if (!statusChanged || previous.role != stored.role
+            || (stored.passwordHashLoaded && previous.passwordHash != stored.passwordHash))
+            logActivity(QString("Edited user %1.").arg(stored.userId), Activity::Audit);
     }
-
-    QSqlQuery query(db);
-    query.prepare(R"(
-        UPDATE empl
-           SET role          = :role,
-               status        = :status,
-               password_hash = :pass
-         WHERE user_id       = :id
-    )");
-    query.bindValue(":role",   newRole);
-    query.bindValue(":status", currentStatus);
-    query.bindValue(":pass",   passHashToUse);
-    query.bindValue(":id",     userId);
-
-    if (!query.exec()) {
-        QMessageBox::critical(this, "Database Error", query.lastError().text());
-        return;
-    }
-
-    ui->tableWidget->item(rowToEdit, 1)->setText(newRole);
-    ui->tableWidget->item(rowToEdit, 3)->setText(passHashToUse);
-
-    QMessageBox::information(this, "Edit Employee", "Employee updated successfully.");
     updateUserCounts();
-    logActivity(QString("Edited user %1.").arg(userId));
 }
 
-
-void home::handleDeleteButton()
+void home::onWriteFailed(const EmployeeRecord &restore, WriteBehindQueue::Failure failure, const QString &message)
 {
-    QPushButton *button = qobject_cast<QPushButton*>(sender());
-    if (!button) return;
-
-    int rowToDelete = -1;
-    for (int row = 0; row < ui->tableWidget->rowCount(); ++row) {
-        QWidget *cellWidget = ui->tableWidget->cellWidget(row, 4);
-        if (!cellWidget) continue;
-        if (cellWidget->findChild<QPushButton*>("deleteButton") == button) {
-            rowToDelete = row;
-            break;
-        }
-    }
-    if (rowToDelete < 0) return;
-
-    QString userId = ui->tableWidget->item(rowToDelete, 0)->text();
-
-    QSqlQuery query(db);
-    query.prepare("DELETE FROM empl WHERE user_id = :id");
-    query.bindValue(":id", userId);
-    if (!query.exec()) {
-        QMessageBox::critical(this, "Database Error", query.lastError().text());
-        return;
+    // Roll just this row back to its stored state.
+    employeeModel->revertRow(restore);
+    m_unsettledPasswordHashes.remove(restore.userId);
+    logActivity(QString("Reverted user %1: %2").arg(restore.userId, message));
+
+    if (failure == WriteBehindQueue::Failure::Conflict) {
+        // Another instance changed the row; a shared snapshot may predate that.
+        if (SharedDirectoryCache *shared = SharedDirectoryCache::configured())
+            shared->invalidate();
+        QMessageBox::warning(this, "Edit Conflict",
+                             QString("%1\nYour change was reverted; the list is being reloaded.").arg(message));
+        startDatabaseLoading();
+    } else {
+        QMessageBox::critical(this, "Database Error", message);
     }
-
-    ui->tableWidget->removeRow(rowToDelete);
-    QMessageBox::information(this, "Delete Employee", "Employee deleted successfully.");
-    updateUserCounts();
-    logActivity(QString("Deleted user %1.").arg(userId));
 }
 
-void home::handleStatusToggle(int row, int column)
+void home::onJournalSettled(const JournalEntry &entry, WriteJournal::Outcome outcome, const QString &message)
 {
-    if (column != 2) return;
-    QTableWidgetItem *item = ui->tableWidget->item(row, column);
-    if (!item) return;
-
-    QString currentStatus = item->text();
-    QString newStatus = (currentStatus.compare("Online", Qt::CaseInsensitive) == 0) ? "Offline" : "Online";
-    item->setText(newStatus);
+    using Kind = JournalEntry::Kind;
+    const bool applied = outcome == WriteJournal::Outcome::Applied;
+
+    // Other instances on this host reload from the database instead of a snapshot
+    // that predates this write.
+    if (applied && entry.kind != Kind::Activity) {
+        if (SharedDirectoryCache *shared = SharedDirectoryCache::configured())
+            shared->invalidate();
+    }
 
-    QString userId = ui->tableWidget->item(row, 0)->text();
-    QSqlQuery query(db);
-    query.prepare("UPDATE empl SET status = :status WHERE user_id = :id");
-    query.bindValue(":status", newStatus);
-    query.bindValue(":id", userId);
-    if (!query.exec()) {
-        QMessageBox::critical(this, "Database Error", query.lastError().text());
-        return;
+    switch (entry.kind) {
+    case Kind::UpdateUser:
+    case Kind::DeleteUser:
+        // Reported through writeQueue's committed()/failed().
+        break;
+    case Kind::CreateUser:
+        if (applied) {
+            employeeModel->commitRow(entry.after);
+            updateUserCounts();
+        } else {
+            employeeModel->removeRecord(employeeModel->rowOfUser(entry.after.userId));
+            logActivity(QString("User %1 was not saved: %2").arg(entry.after.userId, message));
+            QMessageBox::warning(this, "Add User",
+                                 QString("%1\nThe user was not saved; the list is being reloaded.").arg(message));
+            startDatabaseLoading();
+        }
+        break;
+    case Kind::WhitelistAdd:
+    case Kind::WhitelistSetPermission:
+        if (!applied) {
+            logActivity(QString("Whitelist change for %1 was not saved: %2").arg(entry.hwid, message));
+            QMessageBox::critical(this, "Database Error", message);
+            updateWhitelistTable();
+        }
+        break;
+    case Kind::Activity:
+        if (!applied)
+            qDebug() << "Activity entry not saved:" << message;
+        break;
     }
-    updateUserCounts();
-    logActivity(QString("Changed status for %1 to %2.").arg(userId, newStatus));
 }
 
 void home::updateUserCounts()
 {
-    int onlineCount = 0;
-    int offlineCount = 0;
-    for (int i = 0; i < ui->tableWidget->rowCount(); ++i) {
-        QTableWidgetItem *statusItem = ui->tableWidget->item(i, 2);
-        if (!statusItem) continue;
-        if (statusItem->text().compare("Online", Qt::CaseInsensitive) == 0) {
-            onlineCount++;
-        } else if (statusItem->text().compare("Offline", Qt::CaseInsensitive) == 0) {
-            offlineCount++;
-        }
-    }
-    ui->nbr_online->setText(QString::number(onlineCount));
-    ui->nbr_offline->setText(QString::number(offlineCount));
+    // Totals come from the server-side aggregate; this only asks for a fresh poll.
+    if (presence)
+        presence->refreshCounts();
+}
 
-    userStatusHistory[QDateTime::currentDateTime()] = qMakePair(onlineCount, offlineCount);
+void home::applyUserCounts(const UserRepository::StatusCounts &counts)
+{
+    TraceSpan span("ui", "updateUserCounts");
+    ui->nbr_online->setText(QString::number(counts.online));
+    ui->nbr_offline->setText(QString::number(counts.offline));
+
+    userStatusHistory[QDateTime::currentDateTime()] = qMakePair(counts.online, counts.offline);
     updateUserStatusChart();
 }
 
@@ -500,50 +624,39 @@ void home::on_whitelist_user_clicked()
 
     int permission = 1;
 
-    QString hwid = QString(QCryptographicHash::hash(whidText.toUtf8(), QCryptographicHash::Sha256).toHex());
-    QSqlQuery query(db);
-
-    query.prepare("INSERT INTO WHITELISTED_USERS (HWID, PERMISSION) VALUES (:hwid, :perm)");
-    query.bindValue(":hwid", hwid);
-    query.bindValue(":perm", permission);
-
-    if (!query.exec()) {
-        QMessageBox::critical(this, "Database Error", query.lastError().text());
+    QString hwid = UserRepository::sha256Hex(whidText);
+    if (!ui->whitelist_table->findItems(hwid, Qt::MatchExactly).isEmpty()) {
+        QMessageBox::warning(this, "Input Error", "This HWID is already whitelisted.");
         return;
     }
 
+    JournalEntry entry;
+    entry.kind = JournalEntry::Kind::WhitelistAdd;
+    entry.hwid = hwid;
+    entry.permission = permission;
+    journal->append(entry);
+
+    ui->whitelist_table->blockSignals(true);
+    const int row = ui->whitelist_table->rowCount();
+    ui->whitelist_table->insertRow(row);
+    ui->whitelist_table->setItem(row, 0, new QTableWidgetItem(hwid));
+    ui->whitelist_table->setItem(row, 1, new QTableWidgetItem(QString::number(permission)));
+    ui->whitelist_table->blockSignals(false);
+
     QMessageBox::information(this, "Whitelist", "HWID whitelisted successfully.");
     ui->hwid->clear();
 
-    updateWhitelistTable();
-
-    logActivity(QString("Whitelisted HWID: %1 with permission %2").arg(whidText).arg(permission));
+    logActivity(QString("Whitelisted HWID: %1 with permission %2").arg(whidText).arg(permission),
+                Activity::Audit);
 }
 
 void home::updateWhitelistTable()
 {
-    ui->whitelist_table->blockSignals(true);
-
-    ui->whitelist_table->setRowCount(0);
-
-    QSqlQuery query(db);
-    if (!query.exec("SELECT HWID, PERMISSION FROM WHITELISTED_USERS")) {
-        qDebug() << "Error loading whitelist:" << query.lastError().text();
-        ui->whitelist_table->blockSignals(false);
-        return;
-    }
-
-    while (query.next()) {
-        int row = ui->whitelist_table->rowCount();
-        ui->whitelist_table->insertRow(row);
-        QString hwid = query.value("HWID").toString();
-        int perm = query.value("PERMISSION").toInt();
-
-        ui->whitelist_table->setItem(row, 0, new QTableWidgetItem(hwid));
-        ui->whitelist_table->setItem(row, 1, new QTableWidgetItem(QString::number(perm)));
-    }
-
-    ui->whitelist_table->blockSignals(false);
+    TraceSpan span("ui", "updateWhitelistTable");
+    QString errorText;
+    if (!dashboardviews::fillWhitelistTable(ui->whitelist_table, db, &errorText))
+        qDebug() << "Error loading whitelist:" << errorText;
+    span.setRows(ui->whitelist_table->rowCount());
 }
 
 void home::onWhitelistItemChanged(QTableWidgetItem *item)
@@ -563,22 +676,14 @@ void home::onWhitelistItemChanged(QTableWidgetItem *item)
         return;
     }
 
-    // Update the database
-    QSqlQuery query(db);
-    query.prepare("UPDATE WHITELISTED_USERS SET PERMISSION = :perm WHERE HWID = :hwid");
-    query.bindValue(":perm", newPerm);
-    query.bindValue(":hwid", hwid);
-
-    if (!query.exec()) {
-        QMessageBox::critical(this, "Database Error", query.lastError().text());
-        updateWhitelistTable(); // revert changes
-        return;
-    }
+    // The cell already shows the new value; the journal saves it.
+    JournalEntry entry;
+    entry.kind = JournalEntry::Kind::WhitelistSetPermission;
+    entry.hwid = hwid;
+    entry.permission = newPerm;
+    journal->append(entry);
 
-    // Optionally refresh table
-    updateWhitelistTable();
-
-    logActivity(QString("Updated whitelist user %1 to permission %2").arg(hwid).arg(newPerm));
+    logActivity(QString("Updated whitelist user %1 to permission %2").arg(hwid).arg(newPerm), Activity::Audit);
 }
 
 // ------------------ Export PDF ------------------
@@ -600,58 +705,37 @@ void home::exportPdf()
         return;
     }
 
-    QString html;
-    html.append("<html><head><meta charset='UTF-8'></head><body>");
-    html.append("<h2>Employee Data</h2>");
-    html.append("<table border='1' cellspacing='0' cellpadding='2'>");
-    html.append("<tr>");
-
-    QStringList headers = {"User ID", "Role", "Status", "Password", "Actions"};
-    for (const QString &header : headers) {
-        html.append("<th>" + header + "</th>");
-    }
-    html.append("</tr>");
-
-    for (int i = 0; i < ui->tableWidget->rowCount(); ++i) {
-        html.append("<tr>");
-        for (int j = 0; j < ui->tableWidget->columnCount(); ++j) {
-            QTableWidgetItem *item = ui->tableWidget->item(i, j);
-            QString cellText = (item ? item->text() : "");
-            html.append("<td>" + cellText + "</td>");
-        }
-        html.append("</tr>");
+    // The export lists every password hash; fetch those the grid has not loaded yet.
+    const QStringList missingHashes = employeeModel->missingPasswordHashes();
+    if (!missingHashes.isEmpty()) {
+        loadPasswordHashes(missingHashes, TaskScheduler::Export, [this]() { exportPdf(); });
+        return;
     }
-    html.append("</table></body></html>");
+
+    TraceSpan htmlSpan("ui", "exportPdf.buildHtml");
+    const QList<EmployeeRecord> &records = employeeModel->records();
+    htmlSpan.setRows(records.size());
+    const QString html = dashboardviews::employeeExportHtml(records);
 
     bool compressionOn = ui->radioButton1compressionon->isChecked();
 
-    QThread *thread = new QThread;
     PdfExportWorker *worker = new PdfExportWorker(pdfPath, html, compressionOn);
-    worker->moveToThread(thread);
-
-    connect(thread, &QThread::started, worker, &PdfExportWorker::process);
     connect(worker, &PdfExportWorker::finished, this, [=]() {
         QMessageBox::information(this, "Export PDF", "PDF exported successfully.");
         logActivity(QString("Exported PDF to '%1'. Compression %2.")
                         .arg(pdfPath).arg(compressionOn ? "ON" : "OFF"));
-        thread->quit();
     });
-    connect(worker, &PdfExportWorker::finished, worker, &QObject::deleteLater);
-    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
     connect(worker, &PdfExportWorker::error, this, [=](const QString &errMsg) {
         QMessageBox::critical(this, "Export PDF Error", errMsg);
-        thread->quit();
     });
-    thread->start();
+    TaskScheduler::instance().run(TaskScheduler::Export, "export.pdf", worker, &PdfExportWorker::process);
 }
 
 void home::changeEvent(QEvent *event)
 {
     if (event->type() == QEvent::ActivationChange) {
-        if (this->isActiveWindow())
-            updateCurrentUserStatus("Online");
-        else
-            updateCurrentUserStatus("Offline");
+        if (presence)
+            presence->setActive(this->isActiveWindow());
     }
     QWidget::changeEvent(event);
 }
@@ -673,11 +757,7 @@ void home::setupActivityChart()
         activityChartView->setGeometry(QRect(660, 20, 250, 200));
     }
 
-    QGraphicsDropShadowEffect *shadow = new QGraphicsDropShadowEffect(activityChartView);
-    shadow->setBlurRadius(15);
-    shadow->setOffset(4, 4);
-    shadow->setColor(QColor(0, 0, 0, 80));
-    activityChartView->setGraphicsEffect(shadow);
+    shadows->add(activityChartView);
 
     updateActivityChart();
     activityChartView->show();
@@ -688,6 +768,8 @@ void home::updateActivityChart()
     if (!activityChartView || !activityChartView->chart())
         return;
 
+    TraceSpan span("ui.chart", "updateActivityChart");
+
     QChart *chart = activityChartView->chart();
     chart->removeAllSeries();
 
@@ -814,11 +896,11 @@ void home::setupUserStatusChart()
     layout->addWidget(chartView);
     userStatusChartWidget->setLayout(layout);
 
-    QGraphicsDropShadowEffect *shadow = new QGraphicsDropShadowEffect(userStatusChartWidget);
-    shadow->setBlurRadius(10);
-    shadow->setOffset(3, 3);
-    shadow->setColor(QColor(0, 0, 0, 60));
-    userStatusChartWidget->setGraphicsEffect(shadow);
+    ShadowManager::Style chartShadow;
+    chartShadow.blurRadius = 10;
+    chartShadow.offset = QPoint(3, 3);
+    chartShadow.color = QColor(0, 0, 0, 60);
+    shadows->add(userStatusChartWidget, chartShadow);
 
     userStatusHistory[QDateTime::currentDateTime()] = qMakePair(onlineCount, offlineCount);
 
@@ -832,6 +914,8 @@ void home::updateUserStatusChart()
     QChartView *chartView = userStatusChartWidget->findChild<QChartView*>();
     if (!chartView || !chartView->chart()) return;
 
+    TraceSpan span("ui.chart", "updateUserStatusChart");
+
     QChart *chart = chartView->chart();
     chart->removeAllSeries();
 
@@ -897,8 +981,156 @@ void home::recordUserStatusSnapshot()
     int offlineCount = ui->nbr_offline->text().toInt();
     userStatusHistory[QDateTime::currentDateTime()] = qMakePair(onlineCount, offlineCount);
 
-    while (userStatusHistory.size() > 50) {
+    const int historyPoints = AppConfig::intValue(AppConfig::StatusHistoryPoints);
+    while (userStatusHistory.size() > historyPoints) {
         userStatusHistory.remove(userStatusHistory.keys().first());
     }
     updateUserStatusChart();
 }
+
+// ----- Directory Analytics -----
+
+void home::setupAnalyticsCharts()
+{
+    QTabWidget *tabs = new QTabWidget(ui->stackedWidget->currentWidget());
+    tabs->setGeometry(QRect(300, 20, 350, 240));
+
+    QChart *roleChart = new QChart();
+    roleChart->setTitle("Users by role");
+    roleChart->legend()->setVisible(true);
+    roleChart->legend()->setAlignment(Qt::AlignBottom);
+    roleChartView = new QChartView(roleChart);
+    roleChartView->setRenderHint(QPainter::Antialiasing);
+    tabs->addTab(roleChartView, "By role");
+
+    QChart *registrationChart = new QChart();
+    registrationChart->setTitle("New users per day");
+    registrationChart->legend()->setVisible(false);
+    registrationChartView = new QChartView(registrationChart);
+    registrationChartView->setRenderHint(QPainter::Antialiasing);
+    tabs->addTab(registrationChartView, "Registrations");
+
+    shadows->add(tabs);
+
+    // Aggregated on the scheduler from a snapshot of the model; bursts of row
+    // changes (a reload, a sort, heartbeats) are folded into one pass.
+    analytics = new DashboardAnalytics(this);
+    connect(analytics, &DashboardAnalytics::updated, this, &home::applyAnalytics);
+
+    analyticsTimer = new QTimer(this);
+    analyticsTimer->setSingleShot(true);
+    analyticsTimer->setInterval(AppConfig::intValue(AppConfig::AnalyticsDebounceMs));
+    connect(analyticsTimer, &QTimer::timeout, this, [this]() {
+        analytics->refresh(employeeModel->records());
+    });
+    auto scheduleRefresh = [this]() { analyticsTimer->start(); };
+    connect(employeeModel, &QAbstractItemModel::rowsInserted, this, scheduleRefresh);
+    connect(employeeModel, &QAbstractItemModel::rowsRemoved, this, scheduleRefresh);
+    connect(employeeModel, &QAbstractItemModel::dataChanged, this, scheduleRefresh);
+    connect(employeeModel, &QAbstractItemModel::modelReset, this, scheduleRefresh);
+    // Presence expires with time even when no row changes.
+    if (presence)
+        connect(presence, &PresenceService::countsChanged, this, scheduleRefresh);
+
+    tabs->show();
+}
+
+void home::applyAnalytics(const DashboardAnalytics::Result &result)
+{
+    if (!roleChartView || !registrationChartView)
+        return;
+
+    TraceSpan span("ui.chart", "applyAnalytics");
+    span.setRows(result.users);
+
+    // Role distribution, stacked by status.
+    QChart *chart = roleChartView->chart();
+    chart->removeAllSeries();
+    for (QAbstractAxis *axis : chart->axes()) {
+        chart->removeAxis(axis);
+        delete axis;
+    }
+
+    QStringList roles = result.roles.keys();
+    QStringList statuses;
+    for (const QMap<QString, int> &byStatus : result.statusByRole) {
+        for (auto it = byStatus.cbegin(); it != byStatus.cend(); ++it) {
+            if (!statuses.contains(it.key()))
+                statuses << it.key();
+        }
+    }
+
+    QStackedBarSeries *roleSeries = new QStackedBarSeries();
+    for (const QString &status : statuses) {
+        QBarSet *set = new QBarSet(status);
+        if (status == "Online")
+            set->setColor(QColor(76, 175, 80));
+        else if (status == "Offline")
+            set->setColor(QColor(244, 67, 54));
+        else
+            set->setColor(QColor(255, 193, 7));
+        for (const QString &role : roles)
+            *set << result.statusByRole.value(role).value(status);
+        roleSeries->append(set);
+    }
+    chart->addSeries(roleSeries);
+
+    QBarCategoryAxis *roleAxis = new QBarCategoryAxis();
+    roleAxis->append(roles);
+    roleAxis->setGridLineVisible(false);
+    chart->addAxis(roleAxis, Qt::AlignBottom);
+    roleSeries->attachAxis(roleAxis);
+
+    int largestRole = 1;
+    for (int count : result.roles)
+        largestRole = qMax(largestRole, count);
+    QValueAxis *countAxis = new QValueAxis();
+    countAxis->setRange(0, largestRole);
+    countAxis->setLabelFormat("%d");
+    chart->addAxis(countAxis, Qt::AlignLeft);
+    roleSeries->attachAxis(countAxis);
+
+    chart->setTitle(QString("Users by role (%1 stale)").arg(result.stale));
+
+    QStringList oldest;
+    for (const auto &user : result.oldestSeen) {
+        oldest << QString("%1: %2").arg(user.second,
+                                        user.first.isValid() ? user.first.toLocalTime().toString("yyyy-MM-dd hh:mm")
+                                                             : QString("never seen"));
+    }
+    roleChartView->setToolTip(oldest.isEmpty()
+        ? QString("No user has been away for more than %1 days.").arg(DashboardAnalytics::StaleDays)
+        : QString("Longest without a heartbeat:\n") + oldest.join('\n'));
+
+    // New registrations per day.
+    chart = registrationChartView->chart();
+    chart->removeAllSeries();
+    for (QAbstractAxis *axis : chart->axes()) {
+        chart->removeAxis(axis);
+        delete axis;
+    }
+
+    QLineSeries *registrations = new QLineSeries();
+    int busiestDay = 1;
+    for (auto it = result.registrationsPerDay.cbegin(); it != result.registrationsPerDay.cend(); ++it) {
+        registrations->append(QDateTime(it.key(), QTime(0, 0), QTimeZone::UTC).toMSecsSinceEpoch(), it.value());
+        busiestDay = qMax(busiestDay, it.value());
+    }
+    chart->addSeries(registrations);
+
+    QDateTimeAxis *dayAxis = new QDateTimeAxis();
+    dayAxis->setFormat("dd/MM");
+    dayAxis->setTickCount(6);
+    chart->addAxis(dayAxis, Qt::AlignBottom);
+    registrations->attachAxis(dayAxis);
+
+    QValueAxis *newUsersAxis = new QValueAxis();
+    newUsersAxis->setRange(0, busiestDay);
+    newUsersAxis->setLabelFormat("%d");
+    chart->addAxis(newUsersAxis, Qt::AlignLeft);
+    registrations->attachAxis(newUsersAxis);
+
+    chart->setTitle(result.registrationsUnknown > 0
+        ? QString("New users per day (%1 without a date)").arg(result.registrationsUnknown)
+        : QString("New users per day"));
+}
@@ -7,14 +7,26 @@
 #include <QVariantMap>
 #include <QEvent>
 #include <QMap>
+#include <QHash>
 #include <QDateTime>
 #include <QPair>
 #include <QTableWidgetItem>
+#include <QStringList>
+
+#include <functional>
+
+#include "dashboardanalytics.h"
+#include "employeerecord.h"
+#include "taskscheduler.h"
+#include "userrepository.h"
+#include "writebehindqueue.h"
+#include "writejournal.h"
 
 // Include Qt Charts headers
 #include <QtCharts/QChartView>
 #include <QtCharts/QBarSeries>
 #include <QtCharts/QBarSet>
+#include <QtCharts/QStackedBarSeries>
 #include <QtCharts/QLineSeries>
 #include <QtCharts/QPieSeries>
 #include <QtCharts/QPieSlice>
@@ -28,6 +40,11 @@ namespace Ui {
 class home;
 }
 
+class EmployeeModel;
+class PresenceService;
+class ShadowManager;
+class QTimer;
+
 class home : public QWidget
 {
     Q_OBJECT
@@ -39,19 +56,46 @@ public:
 private:
     Ui::home *ui;
     QSqlDatabase db;
+    EmployeeModel *employeeModel;
+    PresenceService *presence;
+    WriteJournal *journal;
+    WriteBehindQueue *writeQueue;
+    QString m_hwid;
+    QString m_clientUserId;
+    ShadowManager *shadows;
+    QString m_frameSpanName;
+    QString m_searchText;
+    int m_searchColumn = 0;
+    // Hashes an edit put into the password cell, by user_id, until that write
+    // settles: a cell showing one was not typed in.
+    QHash<QString, QString> m_unsettledPasswordHashes;
 
     // Chart-related members – using types directly without a namespace prefix
     QChartView *activityChartView;
     QWidget *userStatusChartWidget;
     QMap<QDateTime, QPair<int, int>> userStatusHistory;
+    DashboardAnalytics *analytics;
+    QTimer *analyticsTimer;
+    QChartView *roleChartView;
+    QChartView *registrationChartView;
+    TaskHandle m_loadTask;
 
     bool connectToDatabase();
     void applyShadowEffect();
-    void logActivity(const QString &activity);
+    // Adds a line to the activity list. Audit lines (sign-in, user and whitelist
+    // changes) are also journaled to activity_log; navigation, presence and other
+    // UI lines stay local.
+    enum class Activity { Local, Audit };
+    void logActivity(const QString &activity, Activity kind = Activity::Local);
     void startDatabaseLoading();
-    void updateEmployeeTable(const QList<QVariantMap> &records);
-    void updateCurrentUserStatus(const QString &status);
+    // Fetches password hashes for rows loaded without them, then runs 'then' on success.
+    void loadPasswordHashes(const QStringList &userIds,
+                            TaskScheduler::Priority priority = TaskScheduler::Interactive,
+                            const std::function<void()> &then = {});
+    void updateEmployeeTable(const QList<EmployeeRecord> &records);
+    void applySearch(int firstRow, int lastRow);
     void updateUserCounts();
+    void applyUserCounts(const UserRepository::StatusCounts &counts);
 
     // Chart-related methods
     void setupActivityChart();
@@ -60,6 +104,8 @@ private:
     void setupUserStatusChart();
     void updateUserStatusChart();
     void recordUserStatusSnapshot();
+    void setupAnalyticsCharts();
+    void applyAnalytics(const DashboardAnalytics::Result &result);
 
     void updateWhitelistTable();
 
@@ -70,15 +116,19 @@ private slots:
     void on_pushButton_5_clicked(); // Minimize window
     void on_pushButton_2_clicked(); // Search button
     void on_pushButton_3_clicked(); // Add employee button
-    void handleEditButton();
-    void handleDeleteButton();
-    void handleStatusToggle(int row, int column);
+    void handleEditButton(int row);
+    void handleDeleteButton(int row);
+    void handleStatusToggle(const QModelIndex &index);
+    void onWriteCommitted(const EmployeeRecord &stored, bool deleted);
+    void onWriteFailed(const EmployeeRecord &restore, WriteBehindQueue::Failure failure, const QString &message);
+    void onJournalSettled(const JournalEntry &entry, WriteJournal::Outcome outcome, const QString &message);
     void on_save_clicked();         // Select PDF save path
     void exportPdf();
     void on_whitelist_user_clicked();
     void onWhitelistItemChanged(QTableWidgetItem *item);
 
 protected:
+    bool event(QEvent *event) override;
     void changeEvent(QEvent *event) override;
 };
 
@@ -0,0 +1,41 @@
+QT       = core sql
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = archiflow-loadgen
+
+# Virtual clients run the application's own data-access code; the SQLite
+# stand-in is seeded with the benchmark fixtures.
+INCLUDEPATH += .. ../bench
+
+SOURCES += \
+    ../allocationstats.cpp \
+    ../appconfig.cpp \
+    ../bench/syntheticdata.cpp \
+    ../lookupcache.cpp \
+    ../schemamigrator.cpp \
+    ../sha256batch.cpp \
+    ../shareddirectorycache.cpp \
+    ../storagebackend.cpp \
+    ../tracing.cpp \
+    ../userrepository.cpp \
+    loadgenmain.cpp \
+    virtualclient.cpp
+
+HEADERS += \
+    ../allocationstats.h \
+    ../appconfig.h \
+    ../bench/syntheticdata.h \
+    ../databaseloader.h \
+    ../employeerecord.h \
+    ../lookupcache.h \
+    ../schema.h \
+    ../schemamigrator.h \
+    ../sha256batch.h \
+    ../shareddirectorycache.h \
+    ../statements.h \
+    ../storagebackend.h \
+    ../tracing.h \
+    ../userrepository.h \
+    virtualclient.h
@@ -0,0 +1,252 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "storagebackend.h"
+#include "syntheticdata.h"
+#include "virtualclient.h"
+
+// archiflow-loadgen: many concurrent Archiflow clients against one database.
+//
+//   archiflow-loadgen --clients 200 --duration 60 --think 500
+//                     --mix login=20,register=5,status=40,counts=30,refresh=5
+//                     [--sqlite FILE [--rows N]] [--output report.json]
+//
+// Without --sqlite the backend is selected exactly like the GUI (ARCHIFLOW_BACKEND
+// etc.), so the same run can target an Oracle test instance.
+
+namespace {
+
+QTextStream &err()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+// Nearest-rank percentile of sorted samples, in milliseconds.
+double percentileMs(const QList<qint64> &sorted, double percentile)
+{
+    if (sorted.isEmpty())
+        return 0.0;
+    const qsizetype rank = qsizetype(std::ceil(percentile / 100.0 * sorted.size()));
+    return sorted.at(qBound<qsizetype>(0, rank - 1, sorted.size() - 1)) / 1e6;
+}
+
+QJsonObject summarize(const QString &name, QList<qint64> samples, int errors, double seconds)
+{
+    std::sort(samples.begin(), samples.end());
+    qint64 total = 0;
+    for (qint64 sample : samples)
+        total += sample;
+    const int requests = int(samples.size()) + errors;
+
+    QJsonObject result;
+    result["name"] = name;
+    result["requests"] = requests;
+    result["errors"] = errors;
+    result["error_rate"] = requests > 0 ? double(errors) / requests : 0.0;
+    result["throughput_per_sec"] = seconds > 0 ? requests / seconds : 0.0;
+    if (!samples.isEmpty()) {
+        result["mean_ms"] = total / 1e6 / samples.size();
+        result["p50_ms"] = percentileMs(samples, 50);
+        result["p90_ms"] = percentileMs(samples, 90);
+        result["p95_ms"] = percentileMs(samples, 95);
+        result["p99_ms"] = percentileMs(samples, 99);
+        result["max_ms"] = samples.last() / 1e6;
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("archiflow-loadgen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Concurrent client load generator for Archiflow.");
+    parser.addHelpOption();
+    QCommandLineOption clientsOption("clients", "Concurrent virtual clients.", "n", "50");
+    QCommandLineOption durationOption("duration", "Measured run time in seconds.", "seconds", "30");
+    QCommandLineOption rampUpOption("ramp-up", "Seconds over which the clients start.", "seconds", "0");
+    QCommandLineOption thinkOption("think", "Mean think time between actions (exponential); 0 for none.", "ms", "500");
+    QCommandLineOption mixOption("mix", "Action weights.", "list",
+                                 "login=20,register=5,status=40,counts=30,refresh=5");
+    QCommandLineOption sqliteOption("sqlite", "Run against this SQLite file instead of the configured backend.", "path");
+    QCommandLineOption rowsOption("rows", "Synthetic users to seed a new --sqlite file with.", "n", "10000");
+    QCommandLineOption seedOption("seed", "Seed for the clients' action and think-time draws.", "n", "20250313");
+    QCommandLineOption outputOption("output", "Write the JSON report to this file instead of stdout.", "path");
+    parser.addOptions({ clientsOption, durationOption, rampUpOption, thinkOption, mixOption,
+                        sqliteOption, rowsOption, seedOption, outputOption });
+    parser.process(app);
+
+    const int clients = qMax(1, parser.value(clientsOption).toInt());
+    const int durationSec = qMax(1, parser.value(durationOption).toInt());
+    const int rampUpSec = qMax(0, parser.value(rampUpOption).toInt());
+
+    VirtualClient::Config config;
+    config.thinkMs = qMax(0, parser.value(thinkOption).toInt());
+    config.seed = parser.value(seedOption).toUInt();
+    config.runTag = QString::number(QDateTime::currentMSecsSinceEpoch(), 36)
+                    + QString::number(QRandomGenerator::global()->bounded(1296), 36);
+    QString errorText;
+    if (!VirtualClient::parseMix(parser.value(mixOption), &config.mix, &errorText)) {
+        err() << errorText << Qt::endl;
+        return 2;
+    }
+
+    std::unique_ptr<StorageBackend> backend;
+    bool seedFixture = false;
+    if (parser.isSet(sqliteOption)) {
+        const QString path = parser.value(sqliteOption);
+        seedFixture = !QFileInfo::exists(path);
+        backend = std::make_unique<SqliteBackend>(path);
+    } else {
+        backend = StorageBackend::createConfigured();
+    }
+    config.backend = backend.get();
+
+    {
+        QSqlDatabase db = backend->open("LoadgenSetup", &errorText);
+        if (!db.isOpen()) {
+            err() << "Database connection error: " << errorText << Qt::endl;
+            return 1;
+        }
+        // A new stand-in gets a directory of realistic size, so refreshes and counts
+        // scan as many rows as they would in production.
+        if (seedFixture && !SyntheticData().generate(db, parser.value(rowsOption).toInt(), &errorText)) {
+            err() << "Dataset generation failed: " << errorText << Qt::endl;
+            return 1;
+        }
+        if (!VirtualClient::provision(db, clients, &errorText)) {
+            err() << "Cannot create the client users: " << errorText << Qt::endl;
+            return 1;
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("LoadgenSetup");
+
+    err() << "Running " << clients << " clients for " << durationSec << " s against "
+          << backend->name() << " (" << VirtualClient::mixText(config.mix) << ")" << Qt::endl;
+
+    std::vector<std::unique_ptr<VirtualClient>> virtualClients;
+    QList<QThread *> threads;
+    QElapsedTimer clock;
+    clock.start();
+    const qint64 stopMs = qint64(rampUpSec + durationSec) * 1000;
+    for (int index = 0; index < clients; ++index) {
+        virtualClients.push_back(std::make_unique<VirtualClient>(index, config));
+        VirtualClient *client = virtualClients.back().get();
+        const qint64 startMs = qint64(rampUpSec) * 1000 * index / clients;
+        QThread *thread = QThread::create([client, &clock, startMs, stopMs]() {
+            client->run(clock, startMs, stopMs);
+        });
+        thread->start();
+        threads.append(thread);
+    }
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    const double seconds = clock.elapsed() / 1000.0;
+
+    // Merge the per-client samples per action.
+    QList<qint64> all;
+    int allErrors = 0;
+    int connectFailures = 0;
+    QHash<QString, int> messages;
+    QJsonArray actions;
+    for (int action = 0; action < VirtualClient::ActionCount; ++action) {
+        QList<qint64> samples;
+        int errors = 0;
+        for (const auto &client : virtualClients) {
+            const VirtualClient::ActionStats &stats = client->stats()[action];
+            samples += stats.latenciesNs;
+            errors += stats.errors;
+        }
+        if (samples.isEmpty() && errors == 0)
+            continue;
+        all += samples;
+        allErrors += errors;
+        actions.append(summarize(VirtualClient::actionName(VirtualClient::Action(action)), samples, errors, seconds));
+    }
+    for (const auto &client : virtualClients) {
+        if (client->connectFailed())
+            ++connectFailures;
+        for (auto it = client->errorMessages().cbegin(); it != client->errorMessages().cend(); ++it)
+            messages[it.key()] += it.value();
+    }
+
+    QList<QPair<int, QString>> byCount;
+    for (auto it = messages.cbegin(); it != messages.cend(); ++it)
+        byCount.append(qMakePair(it.value(), it.key()));
+    std::sort(byCount.begin(), byCount.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    QJsonArray errorList;
+    for (const auto &entry : byCount.mid(0, 20)) {
+        QJsonObject error;
+        error["message"] = entry.second;
+        error["count"] = entry.first;
+        errorList.append(error);
+    }
+
+    QJsonObject root;
+    root["suite"] = "archiflow-loadgen";
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["qt_version"] = QString::fromLatin1(qVersion());
+    root["platform"] = QSysInfo::prettyProductName();
+    root["backend"] = backend->name();
+    root["clients"] = clients;
+    root["connect_failures"] = connectFailures;
+    root["duration_s"] = seconds;
+    root["ramp_up_s"] = rampUpSec;
+    root["think_ms"] = config.thinkMs;
+    root["mix"] = VirtualClient::mixText(config.mix);
+    root["total"] = summarize("total", all, allErrors, seconds);
+    root["actions"] = actions;
+    root["errors"] = errorList;
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    // Short summary on stderr, so stdout stays valid JSON.
+    for (const QJsonValue &value : actions) {
+        const QJsonObject action = value.toObject();
+        err() << QString("%1 %2 req/s  p50 %3 ms  p99 %4 ms  errors %5/%6")
+                     .arg(action["name"].toString(), -9)
+                     .arg(action["throughput_per_sec"].toDouble(), 8, 'f', 1)
+                     .arg(action["p50_ms"].toDouble(), 8, 'f', 2)
+                     .arg(action["p99_ms"].toDouble(), 8, 'f', 2)
+                     .arg(action["errors"].toInt())
+                     .arg(action["requests"].toInt())
+              << Qt::endl;
+    }
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err() << "Cannot write " << file.fileName() << ": " << file.errorString() << Qt::endl;
+            return 1;
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return allErrors > 0 || connectFailures > 0 ? 3 : 0;
+}
@@ -0,0 +1,264 @@
+#include "virtualclient.h"
+#include "databaseloader.h"
+#include "storagebackend.h"
+#include "userrepository.h"
+
+#include <QThread>
+
+#include <cmath>
+
+namespace {
+
+// Distinct messages kept per client; the rest only count as errors.
+constexpr int MaxErrorMessages = 50;
+
+// Longest single think time, so a long tail cannot outlast the run by much.
+constexpr int MaxThinkFactor = 10;
+
+} // namespace
+
+VirtualClient::VirtualClient(int index, const Config &config)
+    : m_index(index)
+    , m_config(config)
+    , m_random(config.seed + quint32(index))
+    , m_hwid(UserRepository::sha256Hex(rawHwid(index)))
+    , m_userId(UserRepository::friendlyIdFromHwid(m_hwid))
+{
+}
+
+QString VirtualClient::rawHwid(int index)
+{
+    return QString("loadgen-client-%1").arg(index);
+}
+
+QString VirtualClient::password(int index)
+{
+    return QString("loadgen-%1").arg(index);
+}
+
+QString VirtualClient::actionName(Action action)
+{
+    switch (action) {
+    case Login:    return QStringLiteral("login");
+    case Register: return QStringLiteral("register");
+    case Status:   return QStringLiteral("status");
+    case Counts:   return QStringLiteral("counts");
+    case Refresh:  return QStringLiteral("refresh");
+    case ActionCount: break;
+    }
+    return QString();
+}
+
+bool VirtualClient::parseMix(const QString &text, Mix *mix, QString *errorText)
+{
+    Mix parsed{};
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts)) {
+        const QStringList pair = part.split('=');
+        bool ok = pair.size() == 2;
+        const int weight = ok ? pair.at(1).trimmed().toInt(&ok) : 0;
+        int action = 0;
+        while (action < ActionCount && actionName(Action(action)) != pair.at(0).trimmed())
+            ++action;
+        if (!ok || weight < 0 || action == ActionCount) {
+            if (errorText)
+                *errorText = QString("Invalid mix entry \"%1\"; expected NAME=WEIGHT with NAME one of "
+                                     "login, register, status, counts, refresh.").arg(part);
+            return false;
+        }
+        parsed[action] = weight;
+    }
+    int total = 0;
+    for (int weight : parsed)
+        total += weight;
+    if (total <= 0) {
+        if (errorText)
+            *errorText = "The action mix needs at least one positive weight.";
+        return false;
+    }
+    *mix = parsed;
+    return true;
+}
+
+QString VirtualClient::mixText(const Mix &mix)
+{
+    QStringList parts;
+    for (int action = 0; action < ActionCount; ++action) {
+        if (mix[action] > 0)
+            parts << QString("%1=%2").arg(actionName(Action(action))).arg(mix[action]);
+    }
+    return parts.join(',');
+}
+
+bool VirtualClient::provision(QSqlDatabase &db, int clients, QString *errorText)
+{
+    if (!db.transaction()) {
+        if (errorText)
+            *errorText = db.lastError().text();
+        return false;
+    }
+    for (int index = 0; index < clients; ++index) {
+        // Derived exactly like a registration from the login window's HWID.
+        const QString hwid = UserRepository::sha256Hex(rawHwid(index));
+        switch (UserRepository::createUser(db, UserRepository::friendlyIdFromHwid(hwid), hwid, "User",
+                                           UserRepository::sha256Hex(password(index)), errorText)) {
+        case UserRepository::CreateResult::Created:
+        case UserRepository::CreateResult::AlreadyExists:
+            break;
+        case UserRepository::CreateResult::NotWhitelisted:
+        case UserRepository::CreateResult::Failed:
+            db.rollback();
+            return false;
+        }
+    }
+    if (!db.commit()) {
+        if (errorText)
+            *errorText = db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void VirtualClient::run(const QElapsedTimer &clock, qint64 startMs, qint64 stopMs)
+{
+    const QString connectionName = StorageBackend::threadConnectionName("LoadClient");
+    {
+        if (clock.elapsed() < startMs)
+            QThread::msleep(quint64(startMs - clock.elapsed()));
+
+        QString errorText;
+        QSqlDatabase db = m_config.backend->open(connectionName, &errorText);
+        if (!db.isOpen()) {
+            m_connectFailed = true;
+            m_errorMessages[QString("connect: %1").arg(errorText)] += 1;
+        } else {
+            while (clock.elapsed() < stopMs) {
+                const Action action = pickAction();
+                QElapsedTimer timer;
+                timer.start();
+                errorText.clear();
+                const bool ok = perform(action, db, &errorText);
+                const qint64 elapsedNs = timer.nsecsElapsed();
+
+                ActionStats &stats = m_stats[action];
+                if (ok) {
+                    stats.latenciesNs.append(elapsedNs);
+                } else {
+                    ++stats.errors;
+                    const QString key = QString("%1: %2").arg(actionName(action), errorText);
+                    if (m_errorMessages.contains(key) || m_errorMessages.size() < MaxErrorMessages)
+                        m_errorMessages[key] += 1;
+                }
+
+                if (m_config.thinkMs > 0) {
+                    // Exponential think time with the configured mean, capped.
+                    const double draw = -std::log(1.0 - m_random.generateDouble()) * m_config.thinkMs;
+                    const qint64 thinkMs = qMin(qint64(draw), qint64(m_config.thinkMs) * MaxThinkFactor);
+                    const qint64 remaining = stopMs - clock.elapsed();
+                    if (remaining > 0)
+                        QThread::msleep(quint64(qMin(thinkMs, remaining)));
+                }
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+VirtualClient::Action VirtualClient::pickAction()
+{
+    int total = 0;
+    for (int weight : m_config.mix)
+        total += weight;
+    int draw = m_random.bounded(total);
+    for (int action = 0; action < ActionCount; ++action) {
+        if (draw < m_config.mix[action])
+            return Action(action);
+        draw -= m_config.mix[action];
+    }
+    return Counts;
+}
+
+bool VirtualClient::perform(Action action, QSqlDatabase &db, QString *errorText)
+{
+    switch (action) {
+    case Login:    return login(db, errorText);
+    case Register: return registerUser(db, errorText);
+    case Status:   return toggleStatus(db, errorText);
+    case Counts:   return pollCounts(db, errorText);
+    case Refresh:  return refresh(errorText);
+    case ActionCount: break;
+    }
+    return false;
+}
+
+bool VirtualClient::login(QSqlDatabase &db, QString *errorText)
+{
+    const QString passwordHash = UserRepository::sha256Hex(password(m_index));
+
+    QString storedHash;
+    bool found = false;
+    if (!UserRepository::passwordHash(db, m_userId, &storedHash, &found, errorText))
+        return false;
+    if (!found) {
+        *errorText = "no such user";
+        return false;
+    }
+    if (storedHash != passwordHash) {
+        *errorText = "password hash mismatch";
+        return false;
+    }
+    return true;
+}
+
+bool VirtualClient::registerUser(QSqlDatabase &db, QString *errorText)
+{
+    const QString hwid = UserRepository::sha256Hex(
+        QString("loadgen-%1-%2-%3").arg(m_config.runTag).arg(m_index).arg(++m_registered));
+
+    // Whitelisting is the admin's half of a registration; both round trips are timed.
+    if (!UserRepository::whitelistHwid(db, hwid, 1, errorText))
+        return false;
+
+    switch (UserRepository::registerWhitelistedUser(db, UserRepository::friendlyIdFromHwid(hwid), hwid, "User",
+                                                    UserRepository::sha256Hex(password(m_index)), errorText)) {
+    case UserRepository::CreateResult::Created:
+        return true;
+    case UserRepository::CreateResult::AlreadyExists:
+        *errorText = "already exists";
+        return false;
+    case UserRepository::CreateResult::NotWhitelisted:
+        *errorText = "not whitelisted";
+        return false;
+    case UserRepository::CreateResult::Failed:
+        return false;
+    }
+    return false;
+}
+
+bool VirtualClient::toggleStatus(QSqlDatabase &db, QString *errorText)
+{
+    // A window gaining or losing focus.
+    const bool online = !m_online;
+    if (!UserRepository::heartbeat(db, m_userId, online ? "Online" : "Offline", errorText))
+        return false;
+    m_online = online;
+    return true;
+}
+
+bool VirtualClient::pollCounts(QSqlDatabase &db, QString *errorText)
+{
+    UserRepository::StatusCounts counts;
+    return UserRepository::statusCounts(db, &counts, errorText, UserRepository::presenceCutoff());
+}
+
+bool VirtualClient::refresh(QString *errorText)
+{
+    // Opens and drops its own connection per load, like the dashboard's load task.
+    bool ok = true;
+    DatabaseLoader loader(m_config.backend);
+    QObject::connect(&loader, &DatabaseLoader::error, [&](const QString &errMsg) {
+        ok = false;
+        *errorText = errMsg;
+    });
+    loader.process();
+    return ok;
+}
@@ -0,0 +1,98 @@
+#ifndef VIRTUALCLIENT_H
+#define VIRTUALCLIENT_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+#include <array>
+
+class StorageBackend;
+
+// One simulated Archiflow user, driven from its own thread and connection.
+//
+// Every action goes through the code path of the window it stands for:
+//   login     UserRepository::passwordHash + compare  (login::on_loginbtn_clicked)
+//   register  UserRepository::registerWhitelistedUser (Register::on_registerbtn_clicked)
+//   status    UserRepository::heartbeat               (home::changeEvent via PresenceService)
+//   counts    UserRepository::statusCounts            (the dashboard's presence poll)
+//   refresh   DatabaseLoader::process                 (home::startDatabaseLoading)
+//
+// Actions are drawn from the weighted mix; between two actions the client waits an
+// exponentially distributed think time, so the clients together issue requests
+// like independent users rather than in lockstep.
+class VirtualClient
+{
+public:
+    enum Action {
+        Login,
+        Register,
+        Status,
+        Counts,
+        Refresh,
+        ActionCount
+    };
+
+    using Mix = std::array<int, ActionCount>;   // relative weights
+
+    struct Config {
+        const StorageBackend *backend = nullptr;
+        Mix mix{};
+        int thinkMs = 0;           // mean think time; 0 runs back to back
+        QString runTag;            // keeps registered HWIDs unique across runs
+        quint32 seed = 0;
+    };
+
+    struct ActionStats {
+        QList<qint64> latenciesNs;   // successful requests only
+        int errors = 0;
+    };
+
+    VirtualClient(int index, const Config &config);
+
+    // Runs actions from 'startMs' until 'stopMs' on 'clock', then drops the connection.
+    void run(const QElapsedTimer &clock, qint64 startMs, qint64 stopMs);
+
+    const std::array<ActionStats, ActionCount> &stats() const { return m_stats; }
+    const QHash<QString, int> &errorMessages() const { return m_errorMessages; }
+    bool connectFailed() const { return m_connectFailed; }
+
+    static QString actionName(Action action);
+
+    // "login=20,status=40,..."; actions left out get weight 0.
+    static bool parseMix(const QString &text, Mix *mix, QString *errorText);
+    static QString mixText(const Mix &mix);
+
+    // Creates the users the clients log in as; existing ones are kept.
+    static bool provision(QSqlDatabase &db, int clients, QString *errorText);
+
+private:
+    static QString rawHwid(int index);
+    static QString password(int index);
+
+    Action pickAction();
+    bool perform(Action action, QSqlDatabase &db, QString *errorText);
+    bool login(QSqlDatabase &db, QString *errorText);
+    bool registerUser(QSqlDatabase &db, QString *errorText);
+    bool toggleStatus(QSqlDatabase &db, QString *errorText);
+    bool pollCounts(QSqlDatabase &db, QString *errorText);
+    bool refresh(QString *errorText);
+
+    int m_index;
+    Config m_config;
+    QRandomGenerator m_random;
+    QString m_hwid;
+    QString m_userId;
+    bool m_online = false;
+    int m_registered = 0;
+    bool m_connectFailed = false;
+
+    std::array<ActionStats, ActionCount> m_stats;
+    QHash<QString, int> m_errorMessages;   // "<action>: <message>" -> occurrences
+};
+
+#endif // VIRTUALCLIENT_H
@@ -7,16 +7,26 @@
 #include <QSqlError>
 #include <QMessageBox>
 #include <QSettings>
-#include <QCryptographicHash>
 #include <QClipboard>
 #include <QGuiApplication>
 #include <QDebug>
+#include <QSysInfo>
+#include <QTimer>
 
+#include "storagebackend.h"
+#include "userrepository.h"
+#include "statements.h"
+#include "sessiontoken.h"
+#include "taskscheduler.h"
+#include "tracing.h"
+
+#ifdef Q_OS_WIN
 #ifdef __MINGW32__
 #define __CPUIDEX_DEFINED
 #endif
 #include <windows.h>
 #include <intrin.h>
+#endif
 #include <sstream>
 
 login::login(QWidget *parent)
@@ -46,10 +56,11 @@ login::~login()
 
 bool login::connectToDatabase()
 {
-    db = QSqlDatabase::addDatabase("QODBC");
-    db.setDatabaseName("DRIVER={Oracle in XE};DBQ=XE;UID=DALI;PWD=dali;");
-    if (!db.open()) {
-        qDebug() << "Database connection error:" << db.lastError().text();
+    // All UI windows share the GUI thread's default connection of the configured backend.
+    QString errorText;
+    db = StorageBackend::instance().open(QString(), &errorText);
+    if (!db.isOpen()) {
+        qDebug() << "Database connection error:" << errorText;
         return false;
     }
     return true;
@@ -58,24 +69,36 @@ bool login::connectToDatabase()
 void login::loadRememberedCredentials()
 {
     QSettings settings("Archiflow", "Archiflow");
+    // Earlier versions remembered the plain password; it is neither read nor kept.
+    settings.remove("password");
 
     bool remember = settings.value("rememberMe", false).toBool();
-    if (remember) {
-        QString savedUser = settings.value("userId", "").toString();
-        QString savedPass = settings.value("password", "").toString();
+    if (!remember)
+        return;
+    ui->checkBox->setChecked(true);
 
-        // Optionally display or use the saved userId as needed.
-        ui->pass->setText(savedPass);
-        ui->checkBox->setChecked(true);
+    SessionToken::Claims claims;
+    const SessionToken::Check check = SessionToken::verify(SessionToken::load(), getHwid(), &claims);
+    if (check != SessionToken::Check::Valid) {
+        qDebug() << "Remembered session not used:" << SessionToken::checkName(check);
+        SessionToken::clear();
+        return;
     }
+
+    // Verified locally: the dashboard opens now and the server confirms in the
+    // background. Deferred so the window finishes constructing first.
+    QTimer::singleShot(0, this, [this, claims]() {
+        openDashboard();
+        revalidateSession(claims);
+    });
 }
 
-void login::saveRememberedCredentials(const QString &userId, const QString &plainPassword)
+void login::saveRememberedCredentials(const QString &userId, const QString &passwordHash)
 {
     QSettings settings("Archiflow", "Archiflow");
     settings.setValue("rememberMe", true);
     settings.setValue("userId", userId);
-    settings.setValue("password", plainPassword);
+    SessionToken::save(SessionToken::mint(userId, getHwid(), passwordHash));
 }
 
 void login::clearRememberedCredentials()
@@ -84,14 +107,81 @@ void login::clearRememberedCredentials()
     settings.remove("rememberMe");
     settings.remove("userId");
     settings.remove("password");
+    SessionToken::clear();
+}
+
+void login::openDashboard()
+{
+    m_home = new home();
+    m_home->show();
+    this->hide();
+}
+
+void login::revalidateSession(const SessionToken::Claims &claims)
+{
+    const QString hwid = getHwid();
+    QPointer<login> self(this);
+    TaskScheduler::instance().submit(TaskScheduler::Interactive, "session.revalidate",
+        [self, claims, hwid](const TaskHandle &) {
+            QString errorText;
+            QSqlDatabase db = StorageBackend::instance().open(StorageBackend::threadConnectionName("Session"), &errorText);
+            if (!db.isOpen()) {
+                // Offline: the locally verified session stands until it expires.
+                qDebug() << "Session not revalidated, database unreachable:" << errorText;
+                return;
+            }
+
+            // Straight to the database, past LookupCache: this is the server's confirmation.
+            QSqlQuery query(db);
+            if (!schema::run(query, statements::emplSelectPasswordHash, claims.userId)) {
+                qDebug() << "Session not revalidated:" << query.lastError().text();
+                return;
+            }
+            const bool found = query.next();
+            const QString storedHash = found ? schema::read(query, statements::emplSelectPasswordHash).passwordHash
+                                             : QString();
+            const bool confirmed = found && SessionToken::matchesPassword(claims, hwid, storedHash);
+
+            QMetaObject::invokeMethod(self.data(), [self, claims, hwid, storedHash, confirmed]() {
+                if (!self)
+                    return;
+                if (confirmed) {
+                    // Confirmed by the server: the validity window starts again.
+                    SessionToken::save(SessionToken::mint(claims.userId, hwid, storedHash));
+                } else {
+                    self->endSession("Your saved login is no longer valid. Please sign in again.");
+                }
+            }, Qt::QueuedConnection);
+        });
+}
+
+void login::endSession(const QString &reason)
+{
+    SessionToken::clear();
+    if (m_home) {
+        m_home->close();
+        m_home->deleteLater();
+    }
+    ui->pass->clear();
+    show();
+    QMessageBox::warning(this, "Session Ended", reason);
 }
 
 // --- Static functions ---
 
 QString login::getHwid()
+{
+    // Firmware, CPU and disk queries are slow and the answer never changes while
+    // the process runs.
+    static const QString hwid = readMachineHwid();
+    return hwid;
+}
+
+QString login::readMachineHwid()
 {
     std::stringstream ss;
 
+#ifdef Q_OS_WIN
     // BIOS
     {
         char biosSerial[256] = {0};
@@ -150,20 +240,19 @@ QString login::getHwid()
             ss << "Disk: Error opening physical drive\n";
         }
     }
+#else
+    // Non-Windows builds (headless SQLite deployments) have no firmware tables to query.
+    ss << "Machine: " << QSysInfo::machineUniqueId().toStdString() << "\n";
+#endif
 
     QString combined = QString::fromStdString(ss.str()) + "C:\\Windows\\SysWOW64\\ntdll.dll";
-    QString hwid = QString(QCryptographicHash::hash(combined.toUtf8(), QCryptographicHash::Sha256).toHex());
+    QString hwid = UserRepository::sha256Hex(combined);
     return hwid;
 }
 
 QString login::convertHwidToFriendlyId(const QString &hwid)
 {
-    QString friendly = hwid;
-    std::reverse(friendly.begin(), friendly.end());
-    if (friendly.length() > 10) {
-        friendly = friendly.left(10);
-    }
-    return friendly;
+    return UserRepository::friendlyIdFromHwid(hwid);
 }
 
 void login::on_hwidbtn_clicked()
@@ -186,41 +275,38 @@ void login::on_loginbtn_clicked()
     // Log computed values for debugging
     qDebug() << "Computed HWID:" << hwid;
     qDebug() << "Friendly HWID (userId):" << userId;
-    qDebug() << "Entered password:" << pass;
 
     // Hash the entered password
-    QByteArray hashedInput = QCryptographicHash::hash(pass.toUtf8(), QCryptographicHash::Sha256).toHex();
-    qDebug() << "Hashed password:" << QString(hashedInput);
+    QString hashedInput = UserRepository::sha256Hex(pass);
 
     if (userId.isEmpty() || pass.isEmpty()) {
         QMessageBox::warning(this, "Login Failed", "HWID and password must be provided.");
         return;
     }
 
-    QSqlQuery query(db);
-    query.prepare("SELECT password_hash FROM empl WHERE user_id = :userId");
-    query.bindValue(":userId", userId);
-
-    if (!query.exec()) {
-        qDebug() << "SQL error:" << query.lastError().text();
-        QMessageBox::critical(this, "Database Error", query.lastError().text());
+    // Unknown user ids are answered from LookupCache; a stored hash always comes
+    // from the database.
+    QString storedHash;
+    bool found = false;
+    QString errorText;
+    if (!UserRepository::passwordHash(db, userId, &storedHash, &found, &errorText)) {
+        qDebug() << "SQL error:" << errorText;
+        QMessageBox::critical(this, "Database Error", errorText);
         return;
     }
 
-    if (query.next()) {
-        QString storedHash = query.value(0).toString();
+    if (found) {
         qDebug() << "Stored password hash:" << storedHash;
-        if (storedHash == QString(hashedInput)) {
+        if (storedHash == hashedInput) {
             if (ui->checkBox->isChecked()) {
-                saveRememberedCredentials(userId, pass);
+                saveRememberedCredentials(userId, storedHash);
             } else {
                 clearRememberedCredentials();
             }
-            home *homeWindow = new home();
-            homeWindow->show();
-            this->hide();
+            ui->pass->clear();
+            openDashboard();
         } else {
-            qDebug() << "Hash mismatch: entered" << QString(hashedInput)
+            qDebug() << "Hash mismatch: entered" << hashedInput
             << "vs stored" << storedHash;
             QMessageBox::warning(this, "Login Failed", "Invalid HWID or password.");
         }
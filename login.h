@@ -3,11 +3,16 @@
 
 #include <QMainWindow>
 #include <QSqlDatabase>
+#include <QPointer>
+
+#include "sessiontoken.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class login; }
 QT_END_NAMESPACE
 
+class home;
+
 class login : public QMainWindow
 {
     Q_OBJECT
@@ -16,10 +21,14 @@ public:
     explicit login(QWidget *parent = nullptr);
     ~login();
 
-    // Declare these functions as public static so they can be called without an instance
+    // Declare these functions as public static so they can be called without an instance.
+    // The HWID is computed once per process.
     static QString getHwid();
     static QString convertHwidToFriendlyId(const QString &hwid);
 
+private:
+    static QString readMachineHwid();
+
 private slots:
     void on_hwidbtn_clicked();
     void on_loginbtn_clicked();
@@ -28,11 +37,15 @@ private slots:
 private:
     Ui::login *ui;
     QSqlDatabase db;
+    QPointer<home> m_home;
 
     bool connectToDatabase();
     void loadRememberedCredentials();
-    void saveRememberedCredentials(const QString &userId, const QString &plainPassword);
+    void saveRememberedCredentials(const QString &userId, const QString &passwordHash);
     void clearRememberedCredentials();
+    void openDashboard();
+    void revalidateSession(const SessionToken::Claims &claims);
+    void endSession(const QString &reason);
 };
 
 #endif // LOGIN_H
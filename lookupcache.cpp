@@ -0,0 +1,117 @@
+#include "lookupcache.h"
+#include "appconfig.h"
+
+LookupCache::LookupCache()
+{
+    m_clock.start();
+}
+
+LookupCache &LookupCache::instance()
+{
+    static LookupCache cache;
+    return cache;
+}
+
+QString LookupCache::qualified(Table table, const QString &key)
+{
+    return QString::number(int(table)) + QLatin1Char(':') + key;
+}
+
+bool LookupCache::isMissing(Table table, const QString &key)
+{
+    if (AppConfig::intValue(AppConfig::LookupCacheEntries) == 0)
+        return false;
+
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_index.find(qualified(table, key));
+    if (it == m_index.end()) {
+        ++m_stats.misses;
+        return false;
+    }
+
+    const Lru::iterator entry = it.value();
+    if (entry->expiresMs <= m_clock.elapsed()) {
+        m_lru.erase(entry);
+        m_index.erase(it);
+        ++m_stats.misses;
+        return false;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, entry);
+    ++m_stats.hits;
+    return true;
+}
+
+quint64 LookupCache::generation() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_generation;
+}
+
+void LookupCache::insertMissing(Table table, const QString &key, quint64 generation)
+{
+    const int capacity = AppConfig::intValue(AppConfig::LookupCacheEntries);
+    const int ttlMs = AppConfig::intValue(AppConfig::LookupCacheNegativeTtlMs);
+    if (capacity == 0 || ttlMs == 0)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    // Something was written while the absence was read; it may predate the write.
+    if (generation != m_generation)
+        return;
+
+    const QString qualifiedKey = qualified(table, key);
+    const auto it = m_index.find(qualifiedKey);
+    if (it != m_index.end()) {
+        m_lru.erase(it.value());
+        m_index.erase(it);
+    }
+    m_lru.push_front({ qualifiedKey, m_clock.elapsed() + ttlMs });
+    m_index.insert(qualifiedKey, m_lru.begin());
+    trim(capacity);
+}
+
+void LookupCache::trim(int capacity)
+{
+    // The capacity is live; a smaller one takes effect on the next insert.
+    while (int(m_lru.size()) > capacity) {
+        m_index.remove(m_lru.back().key);
+        m_lru.pop_back();
+        ++m_stats.evictions;
+    }
+}
+
+void LookupCache::invalidate(Table table, const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_generation;
+    ++m_stats.invalidations;
+    const auto it = m_index.find(qualified(table, key));
+    if (it != m_index.end()) {
+        m_lru.erase(it.value());
+        m_index.erase(it);
+    }
+}
+
+void LookupCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_generation;
+    m_lru.clear();
+    m_index.clear();
+}
+
+LookupCache::Stats LookupCache::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.entries = int(m_lru.size());
+    stats.capacity = AppConfig::intValue(AppConfig::LookupCacheEntries);
+    return stats;
+}
+
+void LookupCache::resetStats()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stats = Stats();
+}
@@ -0,0 +1,79 @@
+#ifndef LOOKUPCACHE_H
+#define LOOKUPCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+
+#include <list>
+
+// Negative cache for single-row lookups: user_ids with no row (login) and HWIDs
+// without a whitelist permission (registration). Rows that exist are never kept;
+// a stored password hash must come from the database every time, and a whitelisted
+// registration is a single statement either way.
+//
+// An absence is kept for "cache/lookupNegativeTtlMs" (default 5 s). At most
+// "cache/lookupEntries" entries are kept, least recently used first out; 0 turns
+// the cache off.
+//
+// Writes made by this process drop the entries they touch: UserRepository's
+// inserts and WriteJournal's batches invalidate the keys they create. A row added
+// by another process shows up when the entry expires.
+//
+// An absence read from the database is only stored if nothing was invalidated
+// while it was being read: take generation() before the query and pass it to
+// insertMissing().
+class LookupCache
+{
+public:
+    enum Table {
+        Users,       // key user_id
+        Whitelist    // key HWID
+    };
+
+    struct Stats {
+        qint64 hits = 0;
+        qint64 misses = 0;          // expired entries included
+        qint64 evictions = 0;
+        qint64 invalidations = 0;
+        int entries = 0;
+        int capacity = 0;
+    };
+
+    static LookupCache &instance();
+
+    // True when the row was recently found not to exist.
+    bool isMissing(Table table, const QString &key);
+
+    quint64 generation() const;
+    void insertMissing(Table table, const QString &key, quint64 generation);
+
+    void invalidate(Table table, const QString &key);
+    void clear();
+
+    Stats stats() const;
+    void resetStats();
+
+private:
+    LookupCache();
+    Q_DISABLE_COPY(LookupCache)
+
+    struct Entry {
+        QString key;                // table-qualified
+        qint64 expiresMs = 0;       // on m_clock
+    };
+    using Lru = std::list<Entry>;   // most recently used first
+
+    static QString qualified(Table table, const QString &key);
+    void trim(int capacity);
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    Lru m_lru;
+    QHash<QString, Lru::iterator> m_index;
+    quint64 m_generation = 0;
+    Stats m_stats;
+};
+
+#endif // LOOKUPCACHE_H
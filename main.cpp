@@ -1,14 +1,21 @@
 #include <QApplication>
 #include "login.h"
 #include "home.h"
+#include "taskscheduler.h"
+#include "stallwatchdog.h"
 
 int main(int argc, char *argv[]) {
     qputenv("QT_DEBUG_PLUGINS", QByteArray("1"));
 
     QApplication a(argc, argv);
+    // Join the background workers while the event loop's objects still exist.
+    QObject::connect(&a, &QCoreApplication::aboutToQuit, [] { TaskScheduler::instance().shutdown(); });
+
+    // Reports handlers that block the event loop (see "diagnostics/stallThresholdMs").
+    StallWatchdog::instance().start();
+    QObject::connect(&a, &QCoreApplication::aboutToQuit, [] { StallWatchdog::instance().stop(); });
 
     login loginWindow;
-    home w;
     qDebug() << "Available SQL drivers:" << QSqlDatabase::drivers();
 
     qApp->setStyleSheet("QMessageBox QLabel { color: black; }");
@@ -6,6 +6,9 @@
 #include <QPrinter>
 #include <QTextDocument>
 
+#include "appconfig.h"
+#include "tracing.h"
+
 class PdfExportWorker : public QObject
 {
     Q_OBJECT
@@ -15,6 +18,8 @@ public:
 
 public slots:
     void process() {
+        TraceSpan taskSpan("task", "PdfExportWorker::process");
+
         // Create printer for PDF export.
         QPrinter printer(QPrinter::HighResolution);
         printer.setOutputFormat(QPrinter::PdfFormat);
@@ -24,7 +29,7 @@ public slots:
         if (m_compressionOn)
             printer.setResolution(72);
         else
-            printer.setResolution(300);
+            printer.setResolution(AppConfig::intValue(AppConfig::PdfResolution));
 
         QTextDocument doc;
         doc.setHtml(m_html);
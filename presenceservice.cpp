@@ -0,0 +1,155 @@
+#include "presenceservice.h"
+#include "appconfig.h"
+#include "storagebackend.h"
+#include "taskscheduler.h"
+
+#include <QPointer>
+#include <QSqlDatabase>
+
+namespace {
+
+const QString kOnline = QStringLiteral("Online");
+const QString kOffline = QStringLiteral("Offline");
+
+} // namespace
+
+PresenceService::PresenceService(const QString &userId, QObject *parent)
+    : QObject(parent)
+    , m_userId(userId)
+    , m_wantedStatus(kOffline)
+{
+    m_writeTimer.setSingleShot(true);
+    connect(&m_writeTimer, &QTimer::timeout, this, [this]() { write(false); });
+
+    // Only an Online client keeps writing; Offline is left to expire or stay put.
+    connect(&m_heartbeatTimer, &QTimer::timeout, this, [this]() {
+        if (m_publishedStatus == kOnline)
+            write(true);
+    });
+    m_heartbeatTimer.start(AppConfig::intValue(AppConfig::PresenceHeartbeatMs));
+
+    connect(&m_pollTimer, &QTimer::timeout, this, &PresenceService::refreshCounts);
+    m_pollTimer.start(AppConfig::intValue(AppConfig::PresencePollMs));
+
+    connect(&AppConfig::instance(), &AppConfig::changed, this, [this](AppConfig::Setting setting) {
+        if (setting == AppConfig::PresenceHeartbeatMs)
+            m_heartbeatTimer.start(AppConfig::intValue(setting));
+        else if (setting == AppConfig::PresencePollMs)
+            m_pollTimer.start(AppConfig::intValue(setting));
+    });
+
+    refreshCounts();
+}
+
+void PresenceService::setActive(bool active)
+{
+    m_wantedStatus = active ? kOnline : kOffline;
+    scheduleWrite();
+}
+
+void PresenceService::scheduleWrite()
+{
+    // A write that is pending or running picks up the latest wanted state when it
+    // completes, so rapid focus changes collapse into one UPDATE.
+    if (m_writeInFlight || m_writeTimer.isActive())
+        return;
+    if (m_wantedStatus == m_publishedStatus)
+        return;
+
+    qint64 wait = 0;
+    if (m_sinceWrite.isValid())
+        wait = qMax<qint64>(0, AppConfig::intValue(AppConfig::PresenceMinWriteMs) - m_sinceWrite.elapsed());
+    m_writeTimer.start(int(wait));
+}
+
+void PresenceService::write(bool heartbeat)
+{
+    if (m_writeInFlight)
+        return;
+
+    const QString status = heartbeat ? m_publishedStatus : m_wantedStatus;
+    if (!heartbeat && status == m_publishedStatus)
+        return;
+
+    m_writeInFlight = true;
+    m_sinceWrite.start();
+
+    QPointer<PresenceService> self(this);
+    const QString userId = m_userId;
+    TaskScheduler::instance().submit(TaskScheduler::Background, "presence.heartbeat",
+        [self, userId, status](const TaskHandle &) {
+            QString errorText;
+            QSqlDatabase db = StorageBackend::instance().open(
+                StorageBackend::threadConnectionName("Presence"), &errorText);
+            const bool ok = db.isOpen() && UserRepository::heartbeat(db, userId, status, &errorText);
+
+            QMetaObject::invokeMethod(self.data(), [self, status, ok, errorText]() {
+                if (!self)
+                    return;
+                self->m_writeInFlight = false;
+                if (!ok) {
+                    emit self->error(QString("Presence update failed: %1").arg(errorText));
+                } else if (status != self->m_publishedStatus) {
+                    self->m_publishedStatus = status;
+                    emit self->statusPublished(self->m_userId, status);
+                    self->refreshCounts();
+                }
+                // Retries a failed write, or carries a change that came in meanwhile.
+                self->scheduleWrite();
+            }, Qt::QueuedConnection);
+        });
+}
+
+void PresenceService::refreshCounts()
+{
+    if (m_pollInFlight) {
+        m_pollQueued = true;
+        return;
+    }
+    m_pollInFlight = true;
+
+    QPointer<PresenceService> self(this);
+    TaskScheduler::instance().submit(TaskScheduler::Background, "presence.poll",
+        [self](const TaskHandle &) {
+            QString errorText;
+            UserRepository::StatusCounts counts;
+            QSqlDatabase db = StorageBackend::instance().open(
+                StorageBackend::threadConnectionName("Presence"), &errorText);
+            const bool ok = db.isOpen()
+                            && UserRepository::statusCounts(db, &counts, &errorText,
+                                                            UserRepository::presenceCutoff());
+
+            QMetaObject::invokeMethod(self.data(), [self, counts, ok, errorText]() {
+                if (!self)
+                    return;
+                self->m_pollInFlight = false;
+                if (ok) {
+                    self->m_counts = counts;
+                    emit self->countsChanged(counts);
+                } else {
+                    emit self->error(QString("Presence poll failed: %1").arg(errorText));
+                }
+                if (self->m_pollQueued) {
+                    self->m_pollQueued = false;
+                    self->refreshCounts();
+                }
+            }, Qt::QueuedConnection);
+        });
+}
+
+void PresenceService::publishOfflineNow()
+{
+    m_writeTimer.stop();
+    m_heartbeatTimer.stop();
+    m_pollTimer.stop();
+
+    if (m_publishedStatus != kOnline)
+        return;
+
+    QSqlDatabase db = QSqlDatabase::database(QLatin1String(QSqlDatabase::defaultConnection), false);
+    if (!db.isOpen())
+        return;
+    QString errorText;
+    if (UserRepository::heartbeat(db, m_userId, kOffline, &errorText))
+        m_publishedStatus = kOffline;
+}
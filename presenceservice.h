@@ -0,0 +1,66 @@
+#ifndef PRESENCESERVICE_H
+#define PRESENCESERVICE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "userrepository.h"
+
+// Publishes this client's Online/Offline state and keeps the directory-wide totals.
+//
+// Writes: activation changes only update the wanted state; at most one UPDATE per
+// "presence/minWriteMs" carries the latest of them, and an Online client re-stamps
+// last_seen every "presence/heartbeatMs" (see AppConfig). A client that stops heartbeating (crash,
+// network loss) expires after UserRepository::presenceTtlMs() without anyone
+// writing on its behalf.
+//
+// Reads: totals come from a server-side GROUP BY polled every "presence/pollMs"
+// (and on request), so they include every client, not just the rows this window loaded.
+//
+// All database work runs on the task scheduler; signals arrive on the GUI thread.
+class PresenceService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PresenceService(const QString &userId, QObject *parent = nullptr);
+
+    QString userId() const { return m_userId; }
+
+    // Called on every activation change; cheap and coalesced.
+    void setActive(bool active);
+
+    // Latest totals (valid after the first countsChanged).
+    UserRepository::StatusCounts counts() const { return m_counts; }
+
+    // Polls the aggregate now; requests while a poll is running collapse into one.
+    void refreshCounts();
+
+    // Writes Offline synchronously on the calling thread's default connection; for shutdown.
+    void publishOfflineNow();
+
+signals:
+    void statusPublished(const QString &userId, const QString &status);
+    void countsChanged(const UserRepository::StatusCounts &counts);
+    void error(const QString &message);
+
+private:
+    void scheduleWrite();
+    void write(bool heartbeat);
+
+    QString m_userId;
+    QString m_wantedStatus;
+    QString m_publishedStatus;
+    UserRepository::StatusCounts m_counts;
+
+    QTimer m_writeTimer;
+    QTimer m_heartbeatTimer;
+    QTimer m_pollTimer;
+    QElapsedTimer m_sinceWrite;
+
+    bool m_writeInFlight = false;
+    bool m_pollInFlight = false;
+    bool m_pollQueued = false;
+};
+
+#endif // PRESENCESERVICE_H
@@ -1,15 +1,20 @@
 #include "register.h"
 #include "ui_register.h"
+#include "userrepository.h"
+#include "storagebackend.h"
+#include "shareddirectorycache.h"
 
 #include <QMessageBox>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDebug>
-#include <QCryptographicHash>
 #include <QClipboard>
 #include <QGuiApplication>
+#include <QSysInfo>
+#ifdef Q_OS_WIN
 #include <windows.h>
 #include <intrin.h>
+#endif
 #include <sstream>
 #include <algorithm> // for std::reverse
 
@@ -32,10 +37,11 @@ Register::~Register()
 
 bool Register::connectToDatabase()
 {
-    db = QSqlDatabase::addDatabase("QODBC");
-    db.setDatabaseName("DRIVER={Oracle in XE};DBQ=XE;UID=DALI;PWD=dali;");
-    if (!db.open()) {
-        qDebug() << "Database connection error:" << db.lastError().text();
+    // All UI windows share the GUI thread's default connection of the configured backend.
+    QString errorText;
+    db = StorageBackend::instance().open(QString(), &errorText);
+    if (!db.isOpen()) {
+        qDebug() << "Database connection error:" << errorText;
         return false;
     }
     return true;
@@ -44,25 +50,22 @@ bool Register::connectToDatabase()
 QString Register::getHwid()
 {
     std::stringstream ss;
+#ifdef Q_OS_WIN
     int cpuInfo[4];
     __cpuid(cpuInfo, 0);
     ss << "CPU: " << std::hex << cpuInfo[1] << cpuInfo[3] << cpuInfo[2] << "\n";
+#else
+    ss << "Machine: " << QSysInfo::machineUniqueId().toStdString() << "\n";
+#endif
 
     QString combined = QString::fromStdString(ss.str()) + "C:\\Windows\\SysWOW64\\ntdll.dll";
-    QString hwid = QString(
-        QCryptographicHash::hash(combined.toUtf8(), QCryptographicHash::Sha256).toHex()
-        );
+    QString hwid = UserRepository::sha256Hex(combined);
     return hwid;
 }
 
 QString Register::convertHwidToFriendlyId(const QString &hwid)
 {
-    QString friendly = hwid;
-    std::reverse(friendly.begin(), friendly.end());
-    if (friendly.length() > 10) {
-        friendly = friendly.left(10);
-    }
-    return friendly;
+    return UserRepository::friendlyIdFromHwid(hwid);
 }
 
 void Register::on_hwidbtn_clicked()
@@ -79,7 +82,7 @@ void Register::on_hwidbtn_clicked()
 void Register::on_registerbtn_clicked()
 {
     QString hwidd = ui->hwidbtn->text().trimmed();
-    QString hwid = QString(QCryptographicHash::hash(hwidd.toUtf8(), QCryptographicHash::Sha256).toHex());
+    QString hwid = UserRepository::sha256Hex(hwidd);
 
     qDebug() << "HWID FL CODE:" << hwid;
     QString userRef = convertHwidToFriendlyId(hwid);
@@ -92,63 +95,24 @@ void Register::on_registerbtn_clicked()
         return;
     }
 
-    QSqlQuery wlQuery(db);
-    wlQuery.prepare("SELECT PERMISSION FROM WHITELISTED_USERS WHERE HWID = :hwid");
-    wlQuery.bindValue(":hwid", hwid);
-    if (!wlQuery.exec()) {
-        QMessageBox::critical(this, "Database Error", wlQuery.lastError().text());
-        return;
-    }
-
-    int permission = wlQuery.value(0).toInt();
-    qDebug() << "Whitelist permission:" << permission;
-
-    QString passwordHash = QString(
-        QCryptographicHash::hash(pass.toUtf8(), QCryptographicHash::Sha256).toHex()
-        );
-
-    // 6. Check if this userRef already exists in the database.
-    QSqlQuery checkQuery(db);
-    checkQuery.prepare("SELECT COUNT(*) FROM empl WHERE user_id = :id");
-    checkQuery.bindValue(":id", userRef);
-    if (!checkQuery.exec()) {
-        QMessageBox::critical(this, "Database Error", checkQuery.lastError().text());
+    QString passwordHash = UserRepository::sha256Hex(pass);
+
+    // Whitelist check, uniqueness and insert happen in a single statement.
+    QString errorText;
+    switch (UserRepository::registerWhitelistedUser(db, userRef, hwid, role, passwordHash, &errorText)) {
+    case UserRepository::CreateResult::Created:
+        // The new user shows up on the next load of every instance on this host.
+        if (SharedDirectoryCache *shared = SharedDirectoryCache::configured())
+            shared->invalidate();
+        break;
+    case UserRepository::CreateResult::NotWhitelisted:
+        QMessageBox::warning(this, "Register", "This HWID is not whitelisted.");
         return;
-    }
-    int count = 0;
-    if (checkQuery.next()) {
-        count = checkQuery.value(0).toInt();
-    }
-    if (count > 0) {
+    case UserRepository::CreateResult::AlreadyExists:
         QMessageBox::warning(this, "Register", "A user with this ID (derived from HWID) already exists.");
         return;
-    }
-
-    // 7. Insert into 'empl'
-    QString status = "Offline";
-    if (!db.transaction()) {
-        QMessageBox::critical(this, "Transaction Error", "Failed to start database transaction.");
-        return;
-    }
-
-    QSqlQuery insertQuery(db);
-    insertQuery.prepare(
-        "INSERT INTO empl (user_id, hwid, role, status, password_hash) "
-        "VALUES (:id, :hwid, :role, :status, :pass)"
-        );
-    insertQuery.bindValue(":id", userRef);
-    insertQuery.bindValue(":hwid", hwid);
-    insertQuery.bindValue(":role", role);
-    insertQuery.bindValue(":status", status);
-    insertQuery.bindValue(":pass", passwordHash);
-
-    if (!insertQuery.exec()) {
-        db.rollback();
-        QMessageBox::critical(this, "Database Error", insertQuery.lastError().text());
-        return;
-    }
-    if (!db.commit()) {
-        QMessageBox::critical(this, "Transaction Error", "Failed to commit transaction.");
+    case UserRepository::CreateResult::Failed:
+        QMessageBox::critical(this, "Database Error", errorText);
         return;
     }
 
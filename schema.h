@@ -0,0 +1,402 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <QString>
+#include <QVariant>
+#include <QDateTime>
+#include <QSqlQuery>
+
+#include <array>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "tracing.h"
+
+// Compile-time description of the tables the application talks to, and of the
+// statements run against them.
+//
+// A statement lists its bind parameters and result fields next to its SQL text;
+// the lists are checked against the text at compile time (see Statement::valid),
+// so a renamed column, a reordered SELECT list or a missing placeholder fails the
+// build instead of the first query. Binding is positional and decoding goes by
+// ordinal straight into the row struct, so nothing is looked up by name at run time.
+namespace schema {
+
+template <typename T>
+struct Column {
+    std::string_view table;     // empty for computed result columns
+    std::string_view name;
+    using Type = T;
+};
+
+// ---- Tables ----
+
+struct Empl {
+    static constexpr std::string_view table{"empl"};
+    static constexpr Column<QString>   userId{table, "user_id"};
+    static constexpr Column<QString>   hwid{table, "hwid"};
+    static constexpr Column<QString>   role{table, "role"};
+    static constexpr Column<QString>   status{table, "status"};
+    static constexpr Column<QString>   passwordHash{table, "password_hash"};
+    static constexpr Column<QDateTime> lastSeen{table, "last_seen"};
+    static constexpr Column<QDateTime> createdAt{table, "created_at"};
+    static constexpr Column<qint64>    rowVersion{table, "row_version"};
+};
+
+struct WhitelistedUsers {
+    static constexpr std::string_view table{"WHITELISTED_USERS"};
+    static constexpr Column<QString> hwid{table, "HWID"};
+    static constexpr Column<int>     permission{table, "PERMISSION"};
+};
+
+struct ActivityLog {
+    static constexpr std::string_view table{"activity_log"};
+    static constexpr Column<QDateTime> loggedAt{table, "logged_at"};
+    static constexpr Column<QString>   userId{table, "user_id"};
+    static constexpr Column<QString>   message{table, "message"};
+};
+
+// Computed result columns: matched against the SELECT item itself ("COUNT(*)")
+// or its alias ("... AS presence").
+template <typename T>
+constexpr Column<T> computed(std::string_view expressionOrAlias) { return {{}, expressionOrAlias}; }
+
+constexpr Column<int> countAll = computed<int>("COUNT(*)");
+
+// ---- Statement parts ----
+
+// A ":name" placeholder, typed by the column it is compared with or written to.
+template <typename T>
+struct Param {
+    std::string_view placeholder;
+    Column<T> column;
+    using Type = T;
+};
+
+template <typename T>
+constexpr Param<T> param(std::string_view placeholder, Column<T> column) { return {placeholder, column}; }
+
+// One SELECT item, decoded into Row::*member.
+template <typename Row, typename T>
+struct Field {
+    Column<T> column;
+    T Row::*member;
+};
+
+template <typename Row, typename T>
+constexpr Field<Row, T> field(Column<T> column, T Row::*member) { return {column, member}; }
+
+template <typename... P>
+constexpr std::tuple<Param<P>...> params(Param<P>... p) { return std::tuple<Param<P>...>(p...); }
+
+template <typename Row, typename... T>
+constexpr std::tuple<Field<Row, T>...> fields(Field<Row, T>... f) { return std::tuple<Field<Row, T>...>(f...); }
+
+// ---- Compile-time SQL checks ----
+
+namespace detail {
+
+constexpr bool isIdentChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+constexpr bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+constexpr std::string_view trimmed(std::string_view text)
+{
+    while (!text.empty() && isSpace(text.front()))
+        text.remove_prefix(1);
+    while (!text.empty() && isSpace(text.back()))
+        text.remove_suffix(1);
+    return text;
+}
+
+// 'word' appears in 'sql' as a whole identifier, not as part of a placeholder.
+constexpr bool containsWord(std::string_view sql, std::string_view word)
+{
+    for (std::size_t at = sql.find(word); at != std::string_view::npos; at = sql.find(word, at + 1)) {
+        const bool startOk = at == 0 || (!isIdentChar(sql[at - 1]) && sql[at - 1] != ':');
+        const std::size_t end = at + word.size();
+        const bool endOk = end == sql.size() || !isIdentChar(sql[end]);
+        if (startOk && endOk)
+            return true;
+    }
+    return false;
+}
+
+// Placeholders must appear once each, in bind order: values are bound by position.
+template <std::size_t N>
+constexpr bool placeholdersMatch(std::string_view sql, const std::array<std::string_view, N> &expected)
+{
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < sql.size(); ++i) {
+        if (sql[i] == '\'') {                       // skip string literals
+            i = sql.find('\'', i + 1);
+            if (i == std::string_view::npos)
+                return false;
+            continue;
+        }
+        if (sql[i] != ':' || i + 1 >= sql.size() || !isIdentChar(sql[i + 1]))
+            continue;
+        std::size_t end = i + 1;
+        while (end < sql.size() && isIdentChar(sql[end]))
+            ++end;
+        if (next >= N || sql.substr(i, end - i) != expected[next])
+            return false;
+        ++next;
+        i = end - 1;
+    }
+    return next == N;
+}
+
+// "<expression> AS name"
+constexpr bool endsWithAlias(std::string_view item, std::string_view name)
+{
+    if (item.size() <= name.size() || item.substr(item.size() - name.size()) != name
+        || isIdentChar(item[item.size() - name.size() - 1]))
+        return false;
+    const std::string_view rest = trimmed(item.substr(0, item.size() - name.size()));
+    return rest.size() > 3 && rest.substr(rest.size() - 2) == "AS" && isSpace(rest[rest.size() - 3]);
+}
+
+// The SELECT list of the outermost query, item by item, equals the fields.
+template <std::size_t N>
+constexpr bool selectListMatches(std::string_view sql, const std::array<std::string_view, N> &expected)
+{
+    sql = trimmed(sql);
+    constexpr std::string_view select{"SELECT"};
+    if (sql.substr(0, select.size()) != select)
+        return N == 0;                              // not a query: nothing to decode
+    if (N == 0)
+        return false;                               // a query that decodes nothing
+
+    std::size_t item = 0;
+    std::size_t start = select.size();
+    int depth = 0;
+    for (std::size_t i = start; i < sql.size(); ++i) {
+        const char c = sql[i];
+        if (c == '(') {
+            ++depth;
+        } else if (c == ')') {
+            --depth;
+        } else if (depth == 0 && c == '\'') {
+            i = sql.find('\'', i + 1);
+            if (i == std::string_view::npos)
+                return false;
+        } else if (depth == 0 && (c == ',' || (isSpace(sql[i - 1]) && sql.substr(i, 4) == "FROM"
+                                                && (i + 4 == sql.size() || !isIdentChar(sql[i + 4]))))) {
+            std::string_view text = trimmed(sql.substr(start, i - start));
+            if (text.substr(0, 9) == "DISTINCT ")
+                text = trimmed(text.substr(9));
+            if (item >= N)
+                return false;
+            const std::string_view name = expected[item];
+            if (text != name && !endsWithAlias(text, name))
+                return false;
+            ++item;
+            if (c != ',')
+                return item == N;
+            start = i + 1;
+        }
+    }
+    return false;
+}
+
+} // namespace detail
+
+// Statement without a result row.
+struct NoRow {};
+
+template <typename Row, typename Params, typename Fields>
+struct Statement;
+
+template <typename Row, typename... P, typename... F>
+struct Statement<Row, std::tuple<Param<P>...>, std::tuple<Field<Row, F>...>>
+{
+    std::string_view name;      // the trace name, e.g. "empl.load_all"
+    std::string_view sql;
+    std::tuple<Param<P>...> params;
+    std::tuple<Field<Row, F>...> fields;
+
+    using RowType = Row;
+    static constexpr std::size_t ParamCount = sizeof...(P);
+    static constexpr std::size_t FieldCount = sizeof...(F);
+
+    constexpr bool valid() const { return validImpl(std::index_sequence_for<P...>(), std::index_sequence_for<F...>()); }
+
+private:
+    template <std::size_t... PI, std::size_t... FI>
+    constexpr bool validImpl(std::index_sequence<PI...>, std::index_sequence<FI...>) const
+    {
+        const std::array<std::string_view, sizeof...(P)> placeholders{{std::get<PI>(params).placeholder...}};
+        const std::array<std::string_view, sizeof...(F)> selected{{std::get<FI>(fields).column.name...}};
+        return detail::placeholdersMatch(sql, placeholders)
+               && detail::selectListMatches(sql, selected)
+               && (mentions(std::get<PI>(params).column) && ...)
+               && (mentions(std::get<FI>(fields).column) && ...);
+    }
+
+    // Table columns must be named in the statement, along with their table.
+    template <typename T>
+    constexpr bool mentions(const Column<T> &column) const
+    {
+        return column.table.empty()
+               || (detail::containsWord(sql, column.table) && detail::containsWord(sql, column.name));
+    }
+};
+
+// INSERT/UPDATE/DELETE: parameters only.
+template <typename... P>
+constexpr auto statement(std::string_view name, std::string_view sql, std::tuple<Param<P>...> p)
+{
+    return Statement<NoRow, std::tuple<Param<P>...>, std::tuple<>>{name, sql, p, {}};
+}
+
+// SELECT: parameters and the fields of Row, in SELECT-list order.
+template <typename Row, typename... P, typename... F>
+constexpr auto query(std::string_view name, std::string_view sql,
+                     std::tuple<Param<P>...> p, std::tuple<Field<Row, F>...> f)
+{
+    return Statement<Row, std::tuple<Param<P>...>, std::tuple<Field<Row, F>...>>{name, sql, p, f};
+}
+
+// ---- Run-time side ----
+
+inline QString text(std::string_view view)
+{
+    return QString::fromLatin1(view.data(), qsizetype(view.size()));
+}
+
+template <typename T>
+QVariant toVariant(const T &value) { return QVariant::fromValue(value); }
+
+// An empty optional binds a typed SQL NULL.
+template <typename T>
+QVariant toVariant(const std::optional<T> &value)
+{
+    return value ? QVariant::fromValue(*value) : QVariant(QMetaType::fromType<T>());
+}
+
+template <typename T>
+T fromVariant(const QVariant &value)
+{
+    if constexpr (std::is_same_v<T, QString>)
+        return value.toString();
+    else if constexpr (std::is_same_v<T, int>)
+        return value.toInt();
+    else if constexpr (std::is_same_v<T, qint64>)
+        return value.toLongLong();
+    else if constexpr (std::is_same_v<T, QDateTime>)
+        return value.toDateTime();
+    else
+        return value.value<T>();
+}
+
+template <typename T, typename Arg>
+constexpr bool bindable()
+{
+    using A = std::decay_t<Arg>;
+    return std::is_convertible_v<A, T> || std::is_same_v<A, std::optional<T>>;
+}
+
+template <typename Stmt>
+bool prepare(QSqlQuery &query, const Stmt &stmt)
+{
+    return tracedPrepare(query, text(stmt.name), text(stmt.sql));
+}
+
+namespace detail {
+
+template <typename... P, typename... Args, std::size_t... I>
+void bindAll(QSqlQuery &query, const std::tuple<Param<P>...> &, std::index_sequence<I...>, const Args &...args)
+{
+    static_assert((bindable<P, Args>() && ...), "bind value does not match the column type");
+    (query.bindValue(int(I), toVariant<P>(args)), ...);
+}
+
+} // namespace detail
+
+// Binds one value per parameter, by position, checked against the column types.
+template <typename Stmt, typename... Args>
+void bind(QSqlQuery &query, const Stmt &stmt, const Args &...args)
+{
+    static_assert(sizeof...(Args) == Stmt::ParamCount, "wrong number of bind values");
+    detail::bindAll(query, stmt.params, std::make_index_sequence<sizeof...(Args)>(), args...);
+}
+
+namespace detail {
+
+template <typename... P, std::size_t... I>
+void bindDefaultsAll(QSqlQuery &query, const std::tuple<Param<P>...> &, std::index_sequence<I...>)
+{
+    (query.bindValue(int(I), toVariant<P>(P())), ...);
+    (void)query;
+}
+
+} // namespace detail
+
+// Binds a default value of each parameter's type, for statements that are only
+// explained, never executed.
+template <typename Stmt>
+void bindDefaults(QSqlQuery &query, const Stmt &stmt)
+{
+    detail::bindDefaultsAll(query, stmt.params, std::make_index_sequence<Stmt::ParamCount>());
+}
+
+template <typename Stmt>
+bool exec(QSqlQuery &query, const Stmt &stmt)
+{
+    return tracedExec(query, text(stmt.name));
+}
+
+// Prepare, bind and execute in one go. A statement without parameters is sent
+// unprepared, as before.
+template <typename Stmt, typename... Args>
+bool run(QSqlQuery &query, const Stmt &stmt, const Args &...args)
+{
+    if constexpr (sizeof...(Args) == 0 && Stmt::ParamCount == 0) {
+        return tracedExec(query, text(stmt.name), text(stmt.sql));
+    } else {
+        if (!prepare(query, stmt))
+            return false;
+        bind(query, stmt, args...);
+        return exec(query, stmt);
+    }
+}
+
+namespace detail {
+
+template <typename Row, typename... F, std::size_t... I>
+void readAll(const QSqlQuery &query, const std::tuple<Field<Row, F>...> &fields, Row &row,
+             std::index_sequence<I...>)
+{
+    ((row.*(std::get<I>(fields).member) = fromVariant<F>(query.value(int(I)))), ...);
+}
+
+} // namespace detail
+
+// Decodes the current row by ordinal.
+template <typename Stmt>
+void read(const QSqlQuery &query, const Stmt &stmt, typename Stmt::RowType &row)
+{
+    detail::readAll(query, stmt.fields, row, std::make_index_sequence<Stmt::FieldCount>());
+}
+
+template <typename Stmt>
+typename Stmt::RowType read(const QSqlQuery &query, const Stmt &stmt)
+{
+    typename Stmt::RowType row;
+    read(query, stmt, row);
+    return row;
+}
+
+} // namespace schema
+
+#endif // SCHEMA_H
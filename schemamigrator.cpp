@@ -0,0 +1,472 @@
+#include "schemamigrator.h"
+#include "statements.h"
+#include "tracing.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <QDebug>
+
+struct SchemaMigrator::Step {
+    enum Kind { Table, Column, Index };
+
+    Kind kind = Table;
+    QString table;
+    QString name;          // column or index
+    QString sqlite;        // CREATE TABLE statement, or the column definition
+    QString oracle;
+    QStringList columns;   // indexed columns, leading first
+    bool unique = false;
+};
+
+struct SchemaMigrator::Migration {
+    int version = 0;
+    QString description;
+    QList<Step> steps;
+};
+
+const QList<SchemaMigrator::Migration> &SchemaMigrator::migrations()
+{
+    auto table = [](const QString &name, const QString &sqlite, const QString &oracle) {
+        Step step;
+        step.kind = Step::Table;
+        step.table = name;
+        step.sqlite = sqlite;
+        step.oracle = oracle;
+        return step;
+    };
+    auto column = [](const QString &tableName, const QString &name, const QString &sqlite, const QString &oracle) {
+        Step step;
+        step.kind = Step::Column;
+        step.table = tableName;
+        step.name = name;
+        step.sqlite = sqlite;
+        step.oracle = oracle;
+        return step;
+    };
+    auto index = [](const QString &name, const QString &tableName, const QStringList &columns, bool unique) {
+        Step step;
+        step.kind = Step::Index;
+        step.table = tableName;
+        step.name = name;
+        step.columns = columns;
+        step.unique = unique;
+        return step;
+    };
+
+    // Append only: a released migration never changes, later fixes get a new version.
+    static const QList<Migration> list = {
+        { 1, "base tables", {
+            table("empl",
+                  "CREATE TABLE empl ("
+                  "  user_id TEXT PRIMARY KEY,"
+                  "  hwid TEXT NOT NULL,"
+                  "  role TEXT NOT NULL,"
+                  "  status TEXT NOT NULL DEFAULT 'Offline',"
+                  "  password_hash TEXT NOT NULL,"
+                  "  last_seen TEXT,"
+                  "  row_version INTEGER NOT NULL DEFAULT 0,"
+                  "  created_at TEXT)",
+                  "CREATE TABLE empl ("
+                  "  user_id VARCHAR2(64) PRIMARY KEY,"
+                  "  hwid VARCHAR2(128) NOT NULL,"
+                  "  role VARCHAR2(32) NOT NULL,"
+                  "  status VARCHAR2(16) DEFAULT 'Offline' NOT NULL,"
+                  "  password_hash VARCHAR2(128) NOT NULL,"
+                  "  last_seen TIMESTAMP,"
+                  "  row_version NUMBER(10) DEFAULT 0 NOT NULL,"
+                  "  created_at TIMESTAMP)"),
+            // SQLite identifiers are case-insensitive, so the upper-case spelling used
+            // by the Oracle queries resolves to the same table.
+            table("WHITELISTED_USERS",
+                  "CREATE TABLE WHITELISTED_USERS ("
+                  "  HWID TEXT PRIMARY KEY,"
+                  "  PERMISSION INTEGER NOT NULL)",
+                  "CREATE TABLE WHITELISTED_USERS ("
+                  "  HWID VARCHAR2(128) PRIMARY KEY,"
+                  "  PERMISSION NUMBER(2) NOT NULL)"),
+            table("activity_log",
+                  "CREATE TABLE activity_log ("
+                  "  logged_at TEXT NOT NULL,"
+                  "  user_id TEXT NOT NULL,"
+                  "  message TEXT NOT NULL)",
+                  "CREATE TABLE activity_log ("
+                  "  logged_at TIMESTAMP NOT NULL,"
+                  "  user_id VARCHAR2(64) NOT NULL,"
+                  "  message VARCHAR2(1000) NOT NULL)")
+        } },
+        // Tables created before presence, optimistic concurrency and analytics.
+        { 2, "presence, row version and registration columns", {
+            column("empl", "last_seen", "TEXT", "TIMESTAMP"),
+            column("empl", "row_version", "INTEGER NOT NULL DEFAULT 0", "NUMBER(10) DEFAULT 0 NOT NULL"),
+            column("empl", "created_at", "TEXT", "TIMESTAMP")
+        } },
+        // Login, register, edit, delete and status all look a user up by user_id,
+        // and user creation relies on the unique key to reject duplicates. Whitelist
+        // entries may be duplicated (see statements::emplRegisterWhitelisted), so
+        // their index only serves the lookup.
+        { 3, "user and whitelist keys", {
+            index("empl_user_id_uq", "empl", { "user_id" }, true),
+            index("whitelist_hwid_ix", "WHITELISTED_USERS", { "HWID" }, false)
+        } },
+        // Covers the presence aggregate (statements::emplCountByPresence), so the
+        // dashboard poll reads the index instead of the table.
+        { 4, "presence index", {
+            index("empl_status_seen_ix", "empl", { "status", "last_seen" }, false)
+        } }
+    };
+    return list;
+}
+
+SchemaMigrator::SchemaMigrator(const QSqlDatabase &db, StorageBackend::Kind kind)
+    : m_db(db)
+    , m_kind(kind)
+{
+}
+
+int SchemaMigrator::latestVersion()
+{
+    return migrations().isEmpty() ? 0 : migrations().last().version;
+}
+
+int SchemaMigrator::currentVersion(QString *errorText)
+{
+    if (!hasTable("schema_version"))
+        return 0;
+    QSqlQuery query(m_db);
+    if (!query.exec("SELECT MAX(version) FROM schema_version")) {
+        if (errorText)
+            *errorText = query.lastError().text();
+        return -1;
+    }
+    return query.next() ? query.value(0).toInt() : 0;
+}
+
+bool SchemaMigrator::migrate(QString *errorText)
+{
+    TraceSpan span("task", "SchemaMigrator::migrate");
+    m_applied.clear();
+
+    if (!ensureVersionTable(errorText))
+        return false;
+    const int current = currentVersion(errorText);
+    if (current < 0)
+        return false;
+
+    for (const Migration &migration : migrations()) {
+        if (migration.version > current && !apply(migration, errorText))
+            return false;
+    }
+    return true;
+}
+
+bool SchemaMigrator::ensureVersionTable(QString *errorText)
+{
+    if (hasTable("schema_version"))
+        return true;
+    QSqlQuery query(m_db);
+    const QString sql = m_kind == StorageBackend::Kind::Sqlite
+        ? QStringLiteral("CREATE TABLE schema_version ("
+                         "  version INTEGER PRIMARY KEY,"
+                         "  description TEXT NOT NULL,"
+                         "  applied_at TEXT NOT NULL)")
+        : QStringLiteral("CREATE TABLE schema_version ("
+                         "  version NUMBER(10) PRIMARY KEY,"
+                         "  description VARCHAR2(200) NOT NULL,"
+                         "  applied_at TIMESTAMP NOT NULL)");
+    if (!query.exec(sql)) {
+        // Another client may have created it meanwhile.
+        if (hasTable("schema_version"))
+            return true;
+        if (errorText)
+            *errorText = QString("schema_version: %1").arg(query.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+bool SchemaMigrator::apply(const Migration &migration, QString *errorText)
+{
+    const bool transactional = m_kind == StorageBackend::Kind::Sqlite;
+    if (transactional && !m_db.transaction()) {
+        if (errorText)
+            *errorText = m_db.lastError().text();
+        return false;
+    }
+
+    QString stepError;
+    bool ok = true;
+    for (const Step &step : migration.steps) {
+        if (!applyStep(step, &stepError)) {
+            ok = false;
+            break;
+        }
+    }
+    if (ok) {
+        QSqlQuery record(m_db);
+        ok = record.prepare("INSERT INTO schema_version (version, description, applied_at) "
+                            "VALUES (:version, :description, :at)");
+        record.bindValue(0, migration.version);
+        record.bindValue(1, migration.description);
+        record.bindValue(2, QDateTime::currentDateTimeUtc());
+        if (!ok || !record.exec()) {
+            ok = false;
+            stepError = QString("schema_version: %1").arg(record.lastError().text());
+        }
+    }
+    if (ok && transactional && !m_db.commit()) {
+        ok = false;
+        stepError = m_db.lastError().text();
+    }
+    if (!ok) {
+        if (transactional)
+            m_db.rollback();
+        // Clients starting the same build migrate concurrently; the one that lost
+        // the race (duplicate version, or a step the other one committed under its
+        // feet) finds the migration recorded and carries on.
+        if (versionRecorded(migration.version)) {
+            qDebug() << "Schema migration" << migration.version << "was applied by another client";
+            return true;
+        }
+        if (errorText)
+            *errorText = QString("Schema migration %1 (%2) failed: %3")
+                             .arg(migration.version).arg(migration.description, stepError);
+        return false;
+    }
+
+    qDebug() << "Applied schema migration" << migration.version << migration.description;
+    m_applied << migration.description;
+    return true;
+}
+
+bool SchemaMigrator::isApplied(const Step &step)
+{
+    switch (step.kind) {
+    case Step::Table:
+        return hasTable(step.table);
+    case Step::Column:
+        return hasColumn(step.table, step.name);
+    case Step::Index: {
+        const int existing = indexOn(step.table, step.columns);
+        return step.unique ? existing == 1 : existing >= 0;
+    }
+    }
+    return false;
+}
+
+bool SchemaMigrator::applyStep(const Step &step, QString *errorText)
+{
+    if (isApplied(step))
+        return true;
+
+    const bool sqlite = m_kind == StorageBackend::Kind::Sqlite;
+    QString sql;
+    switch (step.kind) {
+    case Step::Table:
+        sql = sqlite ? step.sqlite : step.oracle;
+        break;
+    case Step::Column:
+        sql = QString("ALTER TABLE %1 ADD %2 %3").arg(step.table, step.name, sqlite ? step.sqlite : step.oracle);
+        break;
+    case Step::Index:
+        sql = QString("CREATE %1INDEX %2 ON %3 (%4)")
+                  .arg(step.unique ? "UNIQUE " : "", step.name, step.table, step.columns.join(", "));
+        break;
+    }
+
+    QSqlQuery query(m_db);
+    if (!query.exec(sql)) {
+        // Another client may have run the same step since the check above
+        // (ORA-00955, ORA-01408, ORA-01430); the catalog has the last word.
+        if (isApplied(step))
+            return true;
+        if (errorText)
+            *errorText = QString("%1: %2").arg(sql, query.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+bool SchemaMigrator::versionRecorded(int version)
+{
+    QSqlQuery query(m_db);
+    query.prepare("SELECT COUNT(*) FROM schema_version WHERE version = :version");
+    query.bindValue(0, version);
+    return query.exec() && query.next() && query.value(0).toInt() > 0;
+}
+
+bool SchemaMigrator::hasTable(const QString &table)
+{
+    QSqlQuery query(m_db);
+    if (m_kind == StorageBackend::Kind::Sqlite) {
+        query.prepare("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = :name COLLATE NOCASE");
+        query.bindValue(0, table);
+    } else {
+        query.prepare("SELECT COUNT(*) FROM user_tables WHERE table_name = :name");
+        query.bindValue(0, table.toUpper());
+    }
+    return query.exec() && query.next() && query.value(0).toInt() > 0;
+}
+
+bool SchemaMigrator::hasColumn(const QString &table, const QString &column)
+{
+    QSqlQuery query(m_db);
+    if (m_kind == StorageBackend::Kind::Sqlite) {
+        if (!query.exec(QString("PRAGMA table_info(%1)").arg(table)))
+            return false;
+        while (query.next()) {
+            if (query.value(1).toString().compare(column, Qt::CaseInsensitive) == 0)
+                return true;
+        }
+        return false;
+    }
+    query.prepare("SELECT COUNT(*) FROM user_tab_columns WHERE table_name = :tab AND column_name = :col");
+    query.bindValue(0, table.toUpper());
+    query.bindValue(1, column.toUpper());
+    return query.exec() && query.next() && query.value(0).toInt() > 0;
+}
+
+int SchemaMigrator::indexOn(const QString &table, const QStringList &columns)
+{
+    // (unique, columns in key order) per index of the table.
+    QList<QPair<bool, QStringList>> indexes;
+    QSqlQuery query(m_db);
+    if (m_kind == StorageBackend::Kind::Sqlite) {
+        QList<QPair<QString, bool>> names;
+        if (!query.exec(QString("PRAGMA index_list(%1)").arg(table)))
+            return -1;
+        while (query.next())
+            names.append(qMakePair(query.value(1).toString(), query.value(2).toInt() != 0));
+        for (const auto &name : names) {
+            QStringList indexed;
+            if (query.exec(QString("PRAGMA index_info(%1)").arg(name.first))) {
+                while (query.next())
+                    indexed << query.value(2).toString();
+            }
+            indexes.append(qMakePair(name.second, indexed));
+        }
+    } else {
+        query.prepare("SELECT i.index_name, i.uniqueness, c.column_name"
+                      "  FROM user_indexes i JOIN user_ind_columns c ON c.index_name = i.index_name"
+                      " WHERE i.table_name = :tab"
+                      " ORDER BY i.index_name, c.column_position");
+        query.bindValue(0, table.toUpper());
+        if (!query.exec())
+            return -1;
+        QString current;
+        while (query.next()) {
+            if (indexes.isEmpty() || query.value(0).toString() != current) {
+                current = query.value(0).toString();
+                indexes.append(qMakePair(query.value(1).toString() == QLatin1String("UNIQUE"), QStringList()));
+            }
+            indexes.last().second << query.value(2).toString();
+        }
+    }
+
+    int found = -1;
+    for (const auto &index : indexes) {
+        if (index.second.size() < columns.size())
+            continue;
+        bool leading = true;
+        for (int i = 0; i < columns.size() && leading; ++i)
+            leading = index.second.at(i).compare(columns.at(i), Qt::CaseInsensitive) == 0;
+        if (!leading)
+            continue;
+        // Only a unique index on exactly these columns makes them unique.
+        if (index.first && index.second.size() == columns.size())
+            return 1;
+        found = 0;
+    }
+    return found;
+}
+
+template <typename Stmt>
+SchemaMigrator::PlanCheck SchemaMigrator::explain(const Stmt &stmt, const QString &table, QString *errorText)
+{
+    PlanCheck check;
+    check.statement = schema::text(stmt.name);
+    check.table = table;
+
+    QStringList lines;
+    bool reached = false;
+    bool fullScan = false;
+    QSqlQuery query(m_db);
+    if (m_kind == StorageBackend::Kind::Sqlite) {
+        // "SEARCH empl USING INDEX ..." or "SCAN empl USING COVERING INDEX ..." read
+        // through an index; a bare "SCAN empl" (older: "SCAN TABLE empl") reads every row.
+        const QRegularExpression mentionsTable(QString("\\b%1\\b").arg(QRegularExpression::escape(table)),
+                                               QRegularExpression::CaseInsensitiveOption);
+        if (!query.prepare("EXPLAIN QUERY PLAN " + schema::text(stmt.sql))) {
+            if (errorText)
+                *errorText = query.lastError().text();
+            return check;
+        }
+        schema::bindDefaults(query, stmt);
+        if (!query.exec()) {
+            if (errorText)
+                *errorText = query.lastError().text();
+            return check;
+        }
+        while (query.next()) {
+            const QString detail = query.value(3).toString();
+            lines << detail;
+            if (!mentionsTable.match(detail).hasMatch())
+                continue;
+            reached = true;
+            if (detail.startsWith(QLatin1String("SCAN")) && !detail.contains(QLatin1String("USING")))
+                fullScan = true;
+        }
+    } else {
+        const QString clear = "DELETE FROM plan_table WHERE statement_id = 'archiflow'";
+        query.exec(clear);
+        if (!query.prepare("EXPLAIN PLAN SET STATEMENT_ID = 'archiflow' FOR " + schema::text(stmt.sql))) {
+            if (errorText)
+                *errorText = query.lastError().text();
+            return check;
+        }
+        schema::bindDefaults(query, stmt);
+        if (!query.exec()
+            || !query.exec("SELECT operation, options, object_name FROM plan_table"
+                           " WHERE statement_id = 'archiflow' ORDER BY id")) {
+            if (errorText)
+                *errorText = query.lastError().text();
+            return check;
+        }
+        while (query.next()) {
+            const QString operation = query.value(0).toString();
+            const QString options = query.value(1).toString();
+            const QString object = query.value(2).toString();
+            lines << QString("%1 %2 %3").arg(operation, options, object).simplified();
+            // Index operations name the index, not the table.
+            if (object.compare(table, Qt::CaseInsensitive) == 0 || operation.startsWith(QLatin1String("INDEX")))
+                reached = true;
+            if (operation == QLatin1String("TABLE ACCESS") && options == QLatin1String("FULL")
+                && object.compare(table, Qt::CaseInsensitive) == 0)
+                fullScan = true;
+        }
+        QSqlQuery(m_db).exec(clear);
+    }
+
+    check.indexed = reached && !fullScan;
+    check.plan = lines.join('\n');
+    return check;
+}
+
+QList<SchemaMigrator::PlanCheck> SchemaMigrator::checkPlans(QString *errorText)
+{
+    TraceSpan span("task", "SchemaMigrator::checkPlans");
+    QList<PlanCheck> checks;
+    const QString empl = schema::text(schema::Empl::table);
+    const QString whitelist = schema::text(schema::WhitelistedUsers::table);
+
+    checks << explain(statements::emplSelectPasswordHash, empl, errorText)      // login
+           << explain(statements::emplSelectPasswordHashes, empl, errorText)    // password column
+           << explain(statements::emplRegisterWhitelisted, whitelist, errorText) // register
+           << explain(statements::emplUpdateVersioned, empl, errorText)          // edit
+           << explain(statements::emplDeleteVersioned, empl, errorText)          // delete
+           << explain(statements::emplHeartbeat, empl, errorText)                // status
+           << explain(statements::whitelistUpdatePermission, whitelist, errorText)
+           << explain(statements::emplCountByPresence, empl, errorText);         // dashboard totals
+    return checks;
+}
@@ -0,0 +1,77 @@
+#ifndef SCHEMAMIGRATOR_H
+#define SCHEMAMIGRATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSqlDatabase>
+
+#include "storagebackend.h"
+
+// Versioned schema setup for 'empl', WHITELISTED_USERS and activity_log.
+//
+// The applied version is kept in a schema_version table (no table: version 0).
+// migrate() applies the later migrations in order and records each one. Every
+// step checks the catalog first (sqlite_master / PRAGMA on SQLite, the USER_*
+// views on Oracle) and is skipped when the table, column or an index on the same
+// leading columns already exists, so a schema that was created by hand is adopted
+// without errors. On SQLite a migration runs in one transaction; Oracle commits
+// each DDL statement by itself, which the existence checks make safe to re-run.
+// Clients that start a new build together migrate concurrently: a step or version
+// row that fails because another client just created it is checked again against
+// the catalog / schema_version and counts as done.
+//
+// checkPlans() explains the statements on the login, register, edit, delete,
+// status, presence and password-column paths (EXPLAIN QUERY PLAN / EXPLAIN PLAN)
+// and reports any that would read a table with a full scan.
+class SchemaMigrator
+{
+public:
+    struct PlanCheck {
+        QString statement;   // statements.h trace name
+        QString table;       // the table that must be reached through an index
+        bool indexed = false;
+        QString plan;        // one plan line per row
+    };
+
+    SchemaMigrator(const QSqlDatabase &db, StorageBackend::Kind kind);
+
+    // The version the migrations in this build lead to.
+    static int latestVersion();
+
+    // 0 when the database has no schema_version table yet; -1 on error.
+    int currentVersion(QString *errorText = nullptr);
+
+    // Applies every migration above currentVersion().
+    bool migrate(QString *errorText = nullptr);
+
+    // Descriptions of the migrations the last migrate() applied.
+    QStringList applied() const { return m_applied; }
+
+    QList<PlanCheck> checkPlans(QString *errorText = nullptr);
+
+private:
+    struct Step;
+    struct Migration;
+    static const QList<Migration> &migrations();
+
+    bool apply(const Migration &migration, QString *errorText);
+    bool applyStep(const Step &step, QString *errorText);
+    bool isApplied(const Step &step);
+    bool ensureVersionTable(QString *errorText);
+    bool versionRecorded(int version);
+
+    bool hasTable(const QString &table);
+    bool hasColumn(const QString &table, const QString &column);
+    // -1: no index starts with these columns; 0: only non-unique ones; 1: a unique one.
+    int indexOn(const QString &table, const QStringList &columns);
+
+    template <typename Stmt>
+    PlanCheck explain(const Stmt &stmt, const QString &table, QString *errorText);
+
+    QSqlDatabase m_db;
+    StorageBackend::Kind m_kind;
+    QStringList m_applied;
+};
+
+#endif // SCHEMAMIGRATOR_H
@@ -0,0 +1,160 @@
+#include "sessiontoken.h"
+#include "appconfig.h"
+#include "userrepository.h"
+
+#include <QSettings>
+#include <QRandomGenerator>
+#include <QMessageAuthenticationCode>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTimeZone>
+
+namespace {
+
+constexpr QByteArray::Base64Options TokenEncoding =
+    QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals;
+
+// Compares without an early exit, so the time taken does not reveal how many
+// leading bytes of a forged signature were right.
+bool constantTimeEquals(const QByteArray &a, const QByteArray &b)
+{
+    if (a.size() != b.size())
+        return false;
+    unsigned char difference = 0;
+    for (qsizetype i = 0; i < a.size(); ++i)
+        difference |= static_cast<unsigned char>(a.at(i) ^ b.at(i));
+    return difference == 0;
+}
+
+// Created on first use; never leaves this machine's settings.
+QByteArray installationSecret()
+{
+    QSettings settings("Archiflow", "Archiflow");
+    QByteArray secret = QByteArray::fromBase64(settings.value("session/secret").toByteArray());
+    if (secret.size() < 32) {
+        secret.resize(32);
+        QRandomGenerator::system()->fillRange(reinterpret_cast<quint32 *>(secret.data()),
+                                              secret.size() / int(sizeof(quint32)));
+        settings.setValue("session/secret", secret.toBase64());
+    }
+    return secret;
+}
+
+} // namespace
+
+QByteArray SessionToken::signingKey(const QString &hwid)
+{
+    return QMessageAuthenticationCode::hash("archiflow-session:" + hwid.toUtf8(),
+                                            installationSecret(), QCryptographicHash::Sha256);
+}
+
+QByteArray SessionToken::sign(const QByteArray &payload, const QString &hwid)
+{
+    return QMessageAuthenticationCode::hash(payload, signingKey(hwid), QCryptographicHash::Sha256);
+}
+
+QString SessionToken::passwordTag(const QString &hwid, const QString &passwordHash)
+{
+    // Keyed, so the token does not carry a plain digest of the password hash.
+    const QByteArray tag = QMessageAuthenticationCode::hash("password:" + passwordHash.toUtf8(),
+                                                            signingKey(hwid), QCryptographicHash::Sha256);
+    return QString::fromLatin1(tag.left(16).toBase64(TokenEncoding));
+}
+
+QString SessionToken::mint(const QString &userId, const QString &hwid, const QString &passwordHash)
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    QJsonObject claims;
+    claims["uid"] = userId;
+    claims["hwid"] = UserRepository::sha256Hex(hwid);
+    claims["pwd"] = passwordTag(hwid, passwordHash);
+    claims["iat"] = now.toSecsSinceEpoch();
+    claims["exp"] = now.addSecs(qint64(validityHours()) * 3600).toSecsSinceEpoch();
+
+    const QByteArray payload = QJsonDocument(claims).toJson(QJsonDocument::Compact);
+    return QString::fromLatin1(payload.toBase64(TokenEncoding) + '.'
+                               + sign(payload, hwid).toBase64(TokenEncoding));
+}
+
+SessionToken::Check SessionToken::verify(const QString &token, const QString &hwid, Claims *claims)
+{
+    if (token.isEmpty())
+        return Check::Missing;
+
+    const QStringList parts = token.split('.');
+    if (parts.size() != 2)
+        return Check::Malformed;
+
+    const auto payload = QByteArray::fromBase64Encoding(parts.at(0).toLatin1(),
+                                                        TokenEncoding | QByteArray::AbortOnBase64DecodingErrors);
+    const auto signature = QByteArray::fromBase64Encoding(parts.at(1).toLatin1(),
+                                                          TokenEncoding | QByteArray::AbortOnBase64DecodingErrors);
+    if (!payload || !signature)
+        return Check::Malformed;
+
+    // The signature is checked before any claim is trusted.
+    if (!constantTimeEquals(sign(*payload, hwid), *signature))
+        return Check::BadSignature;
+
+    const QJsonObject object = QJsonDocument::fromJson(*payload).object();
+    Claims decoded;
+    decoded.userId = object["uid"].toString();
+    decoded.hwidHash = object["hwid"].toString();
+    decoded.passwordTag = object["pwd"].toString();
+    decoded.issuedAt = QDateTime::fromSecsSinceEpoch(object["iat"].toInteger(), QTimeZone::UTC);
+    decoded.expiresAt = QDateTime::fromSecsSinceEpoch(object["exp"].toInteger(), QTimeZone::UTC);
+    if (decoded.userId.isEmpty() || decoded.passwordTag.isEmpty())
+        return Check::Malformed;
+
+    if (decoded.hwidHash != UserRepository::sha256Hex(hwid))
+        return Check::WrongMachine;
+    if (QDateTime::currentDateTimeUtc() >= decoded.expiresAt)
+        return Check::Expired;
+
+    if (claims)
+        *claims = decoded;
+    return Check::Valid;
+}
+
+bool SessionToken::matchesPassword(const Claims &claims, const QString &hwid, const QString &passwordHash)
+{
+    return constantTimeEquals(claims.passwordTag.toLatin1(), passwordTag(hwid, passwordHash).toLatin1());
+}
+
+int SessionToken::validityHours()
+{
+    return AppConfig::intValue(AppConfig::SessionValidityHours);
+}
+
+QString SessionToken::load()
+{
+    QSettings settings("Archiflow", "Archiflow");
+    return settings.value("session/token").toString();
+}
+
+void SessionToken::save(const QString &token)
+{
+    QSettings settings("Archiflow", "Archiflow");
+    settings.setValue("session/token", token);
+}
+
+void SessionToken::clear()
+{
+    QSettings settings("Archiflow", "Archiflow");
+    settings.remove("session/token");
+}
+
+QString SessionToken::checkName(Check check)
+{
+    switch (check) {
+    case Check::Valid:        return QStringLiteral("valid");
+    case Check::Missing:      return QStringLiteral("missing");
+    case Check::Malformed:    return QStringLiteral("malformed");
+    case Check::BadSignature: return QStringLiteral("bad signature");
+    case Check::WrongMachine: return QStringLiteral("issued on another machine");
+    case Check::Expired:      return QStringLiteral("expired");
+    }
+    return QString();
+}
@@ -0,0 +1,62 @@
+#ifndef SESSIONTOKEN_H
+#define SESSIONTOKEN_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+
+// Signed "remember me" tokens, stored in QSettings instead of the password.
+//
+// A token is "<payload>.<signature>", both base64url. The payload is JSON with the
+// user id, the SHA-256 of the HWID, a tag of the password hash the login was
+// checked against, and the issue/expiry times. The signature is HMAC-SHA256 with
+// a key derived from a random per-installation secret and the HWID, so a token
+// copied to another machine, edited, or past its expiry fails verify() without
+// touching the database.
+//
+// A locally valid token only opens the dashboard. The login window then checks
+// the password tag against empl.password_hash in the background: a changed
+// password or a deleted user revokes the session.
+class SessionToken
+{
+public:
+    struct Claims {
+        QString userId;
+        QString hwidHash;
+        QString passwordTag;
+        QDateTime issuedAt;
+        QDateTime expiresAt;
+    };
+
+    enum class Check {
+        Valid,
+        Missing,
+        Malformed,
+        BadSignature,   // edited, or signed with another installation's secret
+        WrongMachine,
+        Expired
+    };
+
+    static QString mint(const QString &userId, const QString &hwid, const QString &passwordHash);
+    static Check verify(const QString &token, const QString &hwid, Claims *claims = nullptr);
+
+    // True while 'passwordHash' is still the one the token was minted for.
+    static bool matchesPassword(const Claims &claims, const QString &hwid, const QString &passwordHash);
+
+    // AppConfig "session/validityHours" (ARCHIFLOW_SESSION_HOURS), read per token.
+    static int validityHours();
+
+    // The remembered token in the application settings.
+    static QString load();
+    static void save(const QString &token);
+    static void clear();
+
+    static QString checkName(Check check);
+
+private:
+    static QByteArray signingKey(const QString &hwid);
+    static QByteArray sign(const QByteArray &payload, const QString &hwid);
+    static QString passwordTag(const QString &hwid, const QString &passwordHash);
+};
+
+#endif // SESSIONTOKEN_H
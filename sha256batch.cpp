@@ -0,0 +1,583 @@
+#include "sha256batch.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SHA256BATCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC and Clang compile the SIMD kernels for their instruction set only, so the
+// rest of the binary keeps the baseline target; MSVC always accepts the intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define SHA256BATCH_TARGET(features) __attribute__((target(features)))
+#else
+#define SHA256BATCH_TARGET(features)
+#endif
+
+namespace {
+
+constexpr int BlockBytes = 64;
+constexpr int DigestBytes = 32;
+
+alignas(16) constexpr uint32_t RoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t InitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+struct Span {
+    const uint8_t *data = nullptr;
+    std::size_t size = 0;
+};
+
+std::size_t blockCount(std::size_t size)
+{
+    return (size + 9 + BlockBytes - 1) / BlockBytes;
+}
+
+// A message as a sequence of 64-byte blocks: the whole blocks are read in place,
+// the last one or two come from a padded copy of the tail.
+struct PaddedMessage {
+    const uint8_t *data = nullptr;
+    std::size_t wholeBlocks = 0;
+    std::size_t blocks = 0;
+    uint8_t tail[2 * BlockBytes];
+
+    void reset(const Span &message)
+    {
+        data = message.data;
+        wholeBlocks = message.size / BlockBytes;
+        const std::size_t rest = message.size % BlockBytes;
+        const std::size_t tailBlocks = rest + 9 > BlockBytes ? 2 : 1;
+        blocks = wholeBlocks + tailBlocks;
+
+        std::memset(tail, 0, sizeof(tail));
+        if (rest > 0)
+            std::memcpy(tail, data + wholeBlocks * BlockBytes, rest);
+        tail[rest] = 0x80;
+        const uint64_t bits = uint64_t(message.size) * 8;
+        uint8_t *length = tail + tailBlocks * BlockBytes - 8;
+        for (int i = 0; i < 8; ++i)
+            length[i] = uint8_t(bits >> (56 - 8 * i));
+    }
+
+    const uint8_t *block(std::size_t index) const
+    {
+        return index < wholeBlocks ? data + index * BlockBytes
+                                   : tail + (index - wholeBlocks) * BlockBytes;
+    }
+};
+
+void storeState(const uint32_t state[8], uint8_t *out)
+{
+    for (int i = 0; i < 8; ++i) {
+        out[4 * i] = uint8_t(state[i] >> 24);
+        out[4 * i + 1] = uint8_t(state[i] >> 16);
+        out[4 * i + 2] = uint8_t(state[i] >> 8);
+        out[4 * i + 3] = uint8_t(state[i]);
+    }
+}
+
+// ---- Scalar ------------------------------------------------------------------
+
+inline uint32_t rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+void compressScalar(uint32_t state[8], const uint8_t *block)
+{
+    uint32_t w[64];
+    for (int t = 0; t < 16; ++t) {
+        const uint8_t *p = block + 4 * t;
+        w[t] = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+    }
+    for (int t = 16; t < 64; ++t) {
+        const uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+        const uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+        w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 64; ++t) {
+        const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g))
+                            + RoundConstants[t] + w[t];
+        const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void digestScalar(const Span &message, uint8_t *out)
+{
+    PaddedMessage padded;
+    padded.reset(message);
+    uint32_t state[8];
+    std::memcpy(state, InitialState, sizeof(state));
+    for (std::size_t i = 0; i < padded.blocks; ++i)
+        compressScalar(state, padded.block(i));
+    storeState(state, out);
+}
+
+void hexScalar(const uint8_t *in, std::size_t bytes, char *out)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (std::size_t i = 0; i < bytes; ++i) {
+        out[2 * i] = digits[in[i] >> 4];
+        out[2 * i + 1] = digits[in[i] & 0x0f];
+    }
+}
+
+#ifdef SHA256BATCH_X86
+
+// ---- CPU features ------------------------------------------------------------
+
+struct CpuFeatures {
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx2 = false;
+    bool sha = false;
+};
+
+CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features;
+    unsigned leaf1[4] = {};
+    unsigned leaf7[4] = {};
+    unsigned long long xcr0 = 0;
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+    __cpuid(regs, 1);
+    std::memcpy(leaf1, regs, sizeof(leaf1));
+    if (maxLeaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        std::memcpy(leaf7, regs, sizeof(leaf7));
+    }
+    if (leaf1[2] & (1u << 27))
+        xcr0 = _xgetbv(0);
+#else
+    if (!__get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]))
+        return features;
+    __get_cpuid_count(7, 0, &leaf7[0], &leaf7[1], &leaf7[2], &leaf7[3]);
+    if (leaf1[2] & (1u << 27)) {
+        unsigned eax = 0, edx = 0;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+    }
+#endif
+    // AVX2 also needs the OS to save the YMM registers (XCR0 bits 1 and 2).
+    const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+    features.ssse3 = leaf1[2] & (1u << 9);
+    features.sse41 = leaf1[2] & (1u << 19);
+    features.avx2 = ymmEnabled && (leaf1[2] & (1u << 28)) && (leaf7[1] & (1u << 5));
+    features.sha = features.sse41 && (leaf7[1] & (1u << 29));
+    return features;
+}
+
+const CpuFeatures &cpuFeatures()
+{
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+// ---- SHA extensions ----------------------------------------------------------
+
+SHA256BATCH_TARGET("sha,sse4.1")
+void digestShaNi(const Span &message, uint8_t *out)
+{
+    PaddedMessage padded;
+    padded.reset(message);
+
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&InitialState[0]));
+    __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&InitialState[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);                 // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);           // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);   // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);        // CDGH
+
+    for (std::size_t index = 0; index < padded.blocks; ++index) {
+        const uint8_t *block = padded.block(index);
+        const __m128i abefSaved = state0;
+        const __m128i cdghSaved = state1;
+        __m128i w[4];
+        // Four rounds per step. sha256msg1/msg2 extend the schedule three and one
+        // steps ahead of the rounds that consume it. Fully unrolled, the w[] indices
+        // become registers.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 16
+#endif
+        for (int step = 0; step < 16; ++step) {
+            if (step < 4)
+                w[step] = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * step)), byteSwap);
+            __m128i rounds = _mm_add_epi32(
+                w[step & 3], _mm_load_si128(reinterpret_cast<const __m128i *>(&RoundConstants[4 * step])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, rounds);
+            if (step >= 3 && step <= 14) {
+                const __m128i carried = _mm_alignr_epi8(w[step & 3], w[(step + 3) & 3], 4);
+                w[(step + 1) & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(w[(step + 1) & 3], carried), w[step & 3]);
+            }
+            rounds = _mm_shuffle_epi32(rounds, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, rounds);
+            if (step >= 1 && step <= 12)
+                w[(step + 3) & 3] = _mm_sha256msg1_epu32(w[(step + 3) & 3], w[step & 3]);
+        }
+        state0 = _mm_add_epi32(state0, abefSaved);
+        state1 = _mm_add_epi32(state1, cdghSaved);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);              // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);           // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);        // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);           // ABEF
+    // Back to big-endian bytes: reverse each 32-bit word.
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(state0, byteSwap));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), _mm_shuffle_epi8(state1, byteSwap));
+}
+
+// ---- AVX2, eight messages per pass ---------------------------------------------
+
+constexpr int Lanes = 8;
+
+SHA256BATCH_TARGET("avx2")
+inline __m256i rotr8(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// Row i of the input becomes column i: word j of lane i <-> word i of lane j.
+SHA256BATCH_TARGET("avx2")
+inline void transpose8(__m256i r[8])
+{
+    const __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    const __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    const __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    const __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    const __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+// Up to eight messages; a lane whose message has run out of blocks hashes a dummy
+// block and keeps its state.
+SHA256BATCH_TARGET("avx2")
+void digestAvx2(const Span *messages, int count, uint8_t *const *out)
+{
+    alignas(32) static const uint8_t zeroBlock[BlockBytes] = {};
+    const __m256i byteSwap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                              3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    PaddedMessage padded[Lanes];
+    alignas(32) int32_t blocks[Lanes] = {};
+    std::size_t maxBlocks = 0;
+    for (int lane = 0; lane < count; ++lane) {
+        padded[lane].reset(messages[lane]);
+        blocks[lane] = int32_t(padded[lane].blocks);
+        maxBlocks = std::max(maxBlocks, padded[lane].blocks);
+    }
+    const __m256i laneBlocks = _mm256_load_si256(reinterpret_cast<const __m256i *>(blocks));
+
+    __m256i state[8];
+    for (int i = 0; i < 8; ++i)
+        state[i] = _mm256_set1_epi32(int(InitialState[i]));
+
+    for (std::size_t index = 0; index < maxBlocks; ++index) {
+        __m256i w[16];
+        for (int lane = 0; lane < Lanes; ++lane) {
+            const uint8_t *block = lane < count && index < padded[lane].blocks ? padded[lane].block(index)
+                                                                                : zeroBlock;
+            w[lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+            w[Lanes + lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+        }
+        transpose8(w);
+        transpose8(w + Lanes);
+        for (int t = 0; t < 16; ++t)
+            w[t] = _mm256_shuffle_epi8(w[t], byteSwap);
+
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            if (t >= 16) {
+                const __m256i w15 = w[(t - 15) & 15];
+                const __m256i w2 = w[(t - 2) & 15];
+                const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w15, 7), rotr8(w15, 18)),
+                                                    _mm256_srli_epi32(w15, 3));
+                const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w2, 17), rotr8(w2, 19)),
+                                                    _mm256_srli_epi32(w2, 10));
+                w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0),
+                                             _mm256_add_epi32(w[(t - 7) & 15], s1));
+            }
+            const __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(e, 6), rotr8(e, 11)), rotr8(e, 25));
+            const __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            const __m256i t1 = _mm256_add_epi32(
+                _mm256_add_epi32(_mm256_add_epi32(h, sigma1), _mm256_add_epi32(choose, w[t & 15])),
+                _mm256_set1_epi32(int(RoundConstants[t])));
+            const __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(a, 2), rotr8(a, 13)), rotr8(a, 22));
+            const __m256i majority = _mm256_xor_si256(_mm256_and_si256(a, _mm256_xor_si256(b, c)),
+                                                      _mm256_and_si256(b, c));
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = _mm256_add_epi32(t1, _mm256_add_epi32(sigma0, majority));
+        }
+
+        const __m256i active = _mm256_cmpgt_epi32(laneBlocks, _mm256_set1_epi32(int(index)));
+        const __m256i worked[8] = { a, b, c, d, e, f, g, h };
+        for (int i = 0; i < 8; ++i)
+            state[i] = _mm256_blendv_epi8(state[i], _mm256_add_epi32(state[i], worked[i]), active);
+    }
+
+    transpose8(state);
+    for (int lane = 0; lane < count; ++lane)
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out[lane]), _mm256_shuffle_epi8(state[lane], byteSwap));
+}
+
+// ---- Hex ---------------------------------------------------------------------
+
+// Splits sixteen bytes into nibbles and looks both halves up in one shuffle each.
+SHA256BATCH_TARGET("ssse3")
+void hexSsse3(const uint8_t *in, std::size_t bytes, char *out)
+{
+    const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                         '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i lowNibble = _mm_set1_epi8(0x0f);
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        const __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(value, 4), lowNibble));
+        const __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(value, lowNibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+    hexScalar(in + i, bytes - i, out + 2 * i);
+}
+
+#endif // SHA256BATCH_X86
+
+bool supported(Sha256Batch::Engine engine)
+{
+    switch (engine) {
+    case Sha256Batch::Engine::Auto:
+    case Sha256Batch::Engine::Scalar:
+        return true;
+#ifdef SHA256BATCH_X86
+    case Sha256Batch::Engine::Avx2:
+        return cpuFeatures().avx2;
+    case Sha256Batch::Engine::ShaNi:
+        return cpuFeatures().sha;
+#else
+    default:
+        return false;
+#endif
+    }
+    return false;
+}
+
+Sha256Batch::Engine resolve(Sha256Batch::Engine engine, std::size_t messages)
+{
+    if (engine != Sha256Batch::Engine::Auto && supported(engine))
+        return engine;
+    if (supported(Sha256Batch::Engine::ShaNi))
+        return Sha256Batch::Engine::ShaNi;
+    if (messages >= 2 && supported(Sha256Batch::Engine::Avx2))
+        return Sha256Batch::Engine::Avx2;
+    return Sha256Batch::Engine::Scalar;
+}
+
+// Writes messages.size() digests back to back into 'out'.
+void digestAll(const std::vector<Span> &messages, Sha256Batch::Engine engine, uint8_t *out)
+{
+    switch (engine) {
+#ifdef SHA256BATCH_X86
+    case Sha256Batch::Engine::ShaNi:
+        for (std::size_t i = 0; i < messages.size(); ++i)
+            digestShaNi(messages[i], out + i * DigestBytes);
+        return;
+    case Sha256Batch::Engine::Avx2: {
+        // Messages with the same block count share a pass, so no lane idles while
+        // the others finish a longer message.
+        std::vector<std::size_t> order(messages.size());
+        std::iota(order.begin(), order.end(), std::size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&messages](std::size_t a, std::size_t b) {
+            return blockCount(messages[a].size) < blockCount(messages[b].size);
+        });
+        for (std::size_t first = 0; first < order.size(); first += Lanes) {
+            const int count = int(std::min<std::size_t>(Lanes, order.size() - first));
+            Span lanes[Lanes];
+            uint8_t *targets[Lanes];
+            for (int lane = 0; lane < count; ++lane) {
+                lanes[lane] = messages[order[first + lane]];
+                targets[lane] = out + order[first + lane] * DigestBytes;
+            }
+            if (count == 1)
+                digestScalar(lanes[0], targets[0]);
+            else
+                digestAvx2(lanes, count, targets);
+        }
+        return;
+    }
+#endif
+    default:
+        for (std::size_t i = 0; i < messages.size(); ++i)
+            digestScalar(messages[i], out + i * DigestBytes);
+        return;
+    }
+}
+
+void hexAll(const uint8_t *in, std::size_t bytes, char *out)
+{
+#ifdef SHA256BATCH_X86
+    if (cpuFeatures().ssse3) {
+        hexSsse3(in, bytes, out);
+        return;
+    }
+#endif
+    hexScalar(in, bytes, out);
+}
+
+std::vector<Span> spans(const QList<QByteArray> &messages)
+{
+    std::vector<Span> result;
+    result.reserve(std::size_t(messages.size()));
+    for (const QByteArray &message : messages)
+        result.push_back({ reinterpret_cast<const uint8_t *>(message.constData()), std::size_t(message.size()) });
+    return result;
+}
+
+} // namespace
+
+bool Sha256Batch::isSupported(Engine engine)
+{
+    return supported(engine);
+}
+
+QString Sha256Batch::engineName(Engine engine)
+{
+    switch (engine) {
+    case Engine::Auto:
+        return "auto";
+    case Engine::Scalar:
+        return "scalar";
+    case Engine::Avx2:
+        return "avx2";
+    case Engine::ShaNi:
+        return "sha-ni";
+    }
+    return QString();
+}
+
+Sha256Batch::Engine Sha256Batch::selectedEngine(qsizetype messages)
+{
+    return resolve(Engine::Auto, std::size_t(qMax<qsizetype>(0, messages)));
+}
+
+QList<QByteArray> Sha256Batch::digest(const QList<QByteArray> &messages, Engine engine)
+{
+    const std::vector<Span> input = spans(messages);
+    QByteArray digests(messages.size() * DigestBytes, Qt::Uninitialized);
+    digestAll(input, resolve(engine, input.size()), reinterpret_cast<uint8_t *>(digests.data()));
+
+    QList<QByteArray> result;
+    result.reserve(messages.size());
+    for (qsizetype i = 0; i < messages.size(); ++i)
+        result.append(digests.mid(i * DigestBytes, DigestBytes));
+    return result;
+}
+
+QStringList Sha256Batch::hex(const QList<QByteArray> &messages, Engine engine)
+{
+    if (messages.isEmpty())
+        return QStringList();
+    const Engine resolved = resolve(engine, std::size_t(messages.size()));
+    TraceSpan span("hash.sha256", engineName(resolved));
+    span.setRows(messages.size());
+
+    const std::vector<Span> input = spans(messages);
+    std::vector<uint8_t> digests(input.size() * DigestBytes);
+    digestAll(input, resolved, digests.data());
+    std::vector<char> text(digests.size() * 2);
+    hexAll(digests.data(), digests.size(), text.data());
+
+    QStringList result;
+    result.reserve(messages.size());
+    for (std::size_t i = 0; i < input.size(); ++i)
+        result.append(QString::fromLatin1(text.data() + i * 2 * DigestBytes, 2 * DigestBytes));
+    return result;
+}
+
+QString Sha256Batch::hex(const QByteArray &message)
+{
+    const Span input{ reinterpret_cast<const uint8_t *>(message.constData()), std::size_t(message.size()) };
+    uint8_t digest[DigestBytes];
+#ifdef SHA256BATCH_X86
+    if (supported(Engine::ShaNi))
+        digestShaNi(input, digest);
+    else
+#endif
+        digestScalar(input, digest);
+    char text[2 * DigestBytes];
+    hexAll(digest, DigestBytes, text);
+    return QString::fromLatin1(text, 2 * DigestBytes);
+}
+
+QStringList Sha256Batch::hexOfUtf8(const QStringList &texts, Engine engine)
+{
+    QList<QByteArray> messages;
+    messages.reserve(texts.size());
+    for (const QString &text : texts)
+        messages.append(text.toUtf8());
+    return hex(messages, engine);
+}
@@ -0,0 +1,48 @@
+#ifndef SHA256BATCH_H
+#define SHA256BATCH_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+// SHA-256 of many independent messages at once, for the bulk hashing paths
+// (CSV import, whitelisting a list of HWIDs).
+//
+// Three engines, picked at run time from CPUID:
+//   ShaNi    the SHA extensions, one message at a time (two rounds per instruction)
+//   Avx2     eight messages per pass, one per 32-bit lane; messages are grouped by
+//            block count so the lanes of a pass rarely idle
+//   Scalar   portable code, used everywhere else
+// The lower-case hex text is produced in one SSSE3 pass over all digests.
+//
+// The digests are plain SHA-256, byte for byte the same as
+// QCryptographicHash::hash(message, QCryptographicHash::Sha256).
+class Sha256Batch
+{
+public:
+    enum class Engine {
+        Auto,      // ShaNi, else Avx2 for two or more messages, else Scalar
+        Scalar,
+        Avx2,
+        ShaNi
+    };
+
+    static bool isSupported(Engine engine);
+    static QString engineName(Engine engine);
+
+    // The engine Auto resolves to for a batch of 'messages' items.
+    static Engine selectedEngine(qsizetype messages);
+
+    // 32-byte digests, in input order. An unsupported engine falls back to Auto.
+    static QList<QByteArray> digest(const QList<QByteArray> &messages, Engine engine = Engine::Auto);
+
+    // Lower-case hex digests, in input order.
+    static QStringList hex(const QList<QByteArray> &messages, Engine engine = Engine::Auto);
+    static QString hex(const QByteArray &message);
+
+    // Hex digests of the UTF-8 encoding of each text, as stored for HWIDs and passwords.
+    static QStringList hexOfUtf8(const QStringList &texts, Engine engine = Engine::Auto);
+};
+
+#endif // SHA256BATCH_H
@@ -0,0 +1,259 @@
+#include "shadowmanager.h"
+#include "appconfig.h"
+
+#include <QWidget>
+#include <QEvent>
+#include <QPainter>
+#include <QPixmap>
+#include <QPixmapCache>
+#include <QImage>
+#include <QVector>
+#include <QGraphicsDropShadowEffect>
+#include <qdrawutil.h>
+
+namespace {
+
+// Running-sum box blur over an alpha plane, along rows (step 1) or columns (step width).
+void boxBlurPass(QVector<int> &alpha, int width, int height, int radius, bool horizontal)
+{
+    const int lines = horizontal ? height : width;
+    const int length = horizontal ? width : height;
+    const int step = horizontal ? 1 : width;
+    const int window = 2 * radius + 1;
+    QVector<int> line(length);
+
+    for (int l = 0; l < lines; ++l) {
+        int *first = alpha.data() + (horizontal ? l * width : l);
+        for (int i = 0; i < length; ++i)
+            line[i] = first[i * step];
+
+        // Pixels outside the tile count as transparent.
+        int sum = 0;
+        for (int i = 0; i <= radius && i < length; ++i)
+            sum += line[i];
+        for (int i = 0; i < length; ++i) {
+            first[i * step] = sum / window;
+            const int enter = i + radius + 1;
+            const int leave = i - radius;
+            if (enter < length)
+                sum += line[enter];
+            if (leave >= 0)
+                sum -= line[leave];
+        }
+    }
+}
+
+// The shadow of a square, big enough that its middle row and column are the
+// fully-blurred edge profile: corners are 2 * blurRadius on each side, the centre
+// one pixel. Blurred once per style; three box passes approximate a gaussian that
+// reaches blurRadius.
+QPixmap shadowTile(const ShadowManager::Style &style)
+{
+    const int reach = qMax(1, style.blurRadius);
+    const QString key = QString("archiflow-shadow-%1-%2").arg(reach).arg(style.color.rgba(), 8, 16, QChar('0'));
+    QPixmap tile;
+    if (QPixmapCache::find(key, &tile))
+        return tile;
+
+    const int size = 4 * reach + 1;
+    QVector<int> alpha(size * size, 0);
+    for (int y = reach; y < size - reach; ++y) {
+        for (int x = reach; x < size - reach; ++x)
+            alpha[y * size + x] = 255;
+    }
+    const int box = qMax(1, reach / 3);
+    for (int pass = 0; pass < 3; ++pass) {
+        boxBlurPass(alpha, size, size, box, true);
+        boxBlurPass(alpha, size, size, box, false);
+    }
+
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    const QColor &color = style.color;
+    for (int y = 0; y < size; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size; ++x) {
+            const int a = alpha[y * size + x] * color.alpha() / 255;
+            line[x] = qPremultiply(qRgba(color.red(), color.green(), color.blue(), a));
+        }
+    }
+
+    tile = QPixmap::fromImage(image);
+    QPixmapCache::insert(key, tile);
+    return tile;
+}
+
+// Paints the cached shadow under its target. It sits in the target's parent,
+// directly below the target in stacking order, and ignores the mouse.
+class ShadowDecoration : public QWidget
+{
+public:
+    ShadowDecoration(QWidget *target, const ShadowManager::Style &style)
+        : QWidget(target->parentWidget())
+        , m_target(target)
+        , m_style(style)
+        , m_tile(shadowTile(style))
+    {
+        setAttribute(Qt::WA_TransparentForMouseEvents);
+        setFocusPolicy(Qt::NoFocus);
+        target->installEventFilter(this);
+        follow();
+    }
+
+    ~ShadowDecoration() override
+    {
+        if (m_target)
+            m_target->removeEventFilter(this);
+    }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (watched == m_target) {
+            switch (event->type()) {
+            case QEvent::Move:
+            case QEvent::Resize:
+            case QEvent::Show:
+            case QEvent::Hide:
+            case QEvent::ZOrderChange:
+                follow();
+                break;
+            case QEvent::ParentChange:
+                setParent(m_target->parentWidget());
+                follow();
+                break;
+            default:
+                break;
+            }
+        }
+        return QWidget::eventFilter(watched, event);
+    }
+
+    void paintEvent(QPaintEvent *) override
+    {
+        const int corner = 2 * qMax(1, m_style.blurRadius);
+        QPainter painter(this);
+        qDrawBorderPixmap(&painter, rect(), QMargins(corner, corner, corner, corner), m_tile);
+    }
+
+private:
+    void follow()
+    {
+        if (!m_target || !parentWidget())
+            return;
+        const int reach = qMax(1, m_style.blurRadius);
+        setGeometry(m_target->geometry().translated(m_style.offset).adjusted(-reach, -reach, reach, reach));
+        setVisible(!m_target->isHidden());
+        stackUnder(m_target);
+    }
+
+    QPointer<QWidget> m_target;
+    ShadowManager::Style m_style;
+    QPixmap m_tile;
+};
+
+} // namespace
+
+ShadowManager::ShadowManager(QObject *parent)
+    : ShadowManager(configuredMode(), parent)
+{
+}
+
+ShadowManager::ShadowManager(Mode mode, QObject *parent)
+    : QObject(parent)
+    , m_mode(mode)
+{
+}
+
+ShadowManager::Mode ShadowManager::configuredMode()
+{
+    return modeFromName(AppConfig::stringValue(AppConfig::ShadowMode), Cached);
+}
+
+void ShadowManager::saveConfiguredMode(Mode mode)
+{
+    AppConfig::instance().setUserValue(AppConfig::ShadowMode, modeName(mode));
+}
+
+QString ShadowManager::modeName(Mode mode)
+{
+    switch (mode) {
+    case Effect: return QStringLiteral("effect");
+    case Cached: return QStringLiteral("cached");
+    case Off:    return QStringLiteral("off");
+    }
+    return QString();
+}
+
+ShadowManager::Mode ShadowManager::modeFromName(const QString &name, Mode fallback)
+{
+    const QString key = name.trimmed().toLower();
+    for (Mode mode : {Effect, Cached, Off}) {
+        if (key == modeName(mode))
+            return mode;
+    }
+    return fallback;
+}
+
+void ShadowManager::add(QWidget *widget)
+{
+    add(widget, Style());
+}
+
+void ShadowManager::add(QWidget *widget, const Style &style)
+{
+    if (!widget)
+        return;
+    Target target;
+    target.widget = widget;
+    target.style = style;
+    apply(target);
+    m_targets.append(target);
+}
+
+void ShadowManager::setMode(Mode mode)
+{
+    if (mode == m_mode)
+        return;
+    m_mode = mode;
+
+    for (int i = m_targets.size() - 1; i >= 0; --i) {
+        Target &target = m_targets[i];
+        if (!target.widget) {
+            m_targets.removeAt(i);
+            continue;
+        }
+        clear(target);
+        apply(target);
+    }
+    emit modeChanged(mode);
+}
+
+void ShadowManager::apply(Target &target)
+{
+    QWidget *widget = target.widget;
+    switch (m_mode) {
+    case Effect: {
+        QGraphicsDropShadowEffect *shadow = new QGraphicsDropShadowEffect(widget);
+        shadow->setBlurRadius(target.style.blurRadius);
+        shadow->setOffset(target.style.offset);
+        shadow->setColor(target.style.color);
+        widget->setGraphicsEffect(shadow);
+        break;
+    }
+    case Cached:
+        // A top-level widget has no parent to draw the decoration in.
+        if (widget->parentWidget()) {
+            target.decoration = new ShadowDecoration(widget, target.style);
+            connect(widget, &QObject::destroyed, target.decoration.data(), &QObject::deleteLater);
+        }
+        break;
+    case Off:
+        break;
+    }
+}
+
+void ShadowManager::clear(Target &target)
+{
+    target.widget->setGraphicsEffect(nullptr);   // deletes the effect, if any
+    delete target.decoration.data();
+}
@@ -0,0 +1,78 @@
+#ifndef SHADOWMANAGER_H
+#define SHADOWMANAGER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QColor>
+#include <QPoint>
+#include <QList>
+
+class QWidget;
+
+// Drop shadows for the dashboard's panels, in one of three rendering modes:
+//
+//   Effect  QGraphicsDropShadowEffect on the panel. Every repaint of the panel,
+//           including each scroll step of a table inside it, is rendered offscreen
+//           and blurred again.
+//   Cached  A sibling widget stacked under the panel paints a nine-patch cut from
+//           a shadow tile that is blurred once per style and kept in QPixmapCache.
+//           The panel repaints exactly as if it had no shadow; the decoration only
+//           repaints when the panel moves or resizes.
+//   Off     No shadows.
+//
+// The dashboard starts in configuredMode(): AppConfig "ui/shadowMode"
+// (ARCHIFLOW_SHADOWS=effect|cached|off, default cached). setMode() switches every registered
+// shadow at run time.
+class ShadowManager : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        Effect,
+        Cached,
+        Off
+    };
+    Q_ENUM(Mode)
+
+    struct Style {
+        int blurRadius = 15;
+        QPoint offset = QPoint(4, 4);
+        QColor color = QColor(0, 0, 0, 80);
+    };
+
+    explicit ShadowManager(QObject *parent = nullptr);
+    explicit ShadowManager(Mode mode, QObject *parent = nullptr);
+
+    static Mode configuredMode();
+    static void saveConfiguredMode(Mode mode);
+    static QString modeName(Mode mode);
+    static Mode modeFromName(const QString &name, Mode fallback);
+
+    // Gives 'widget' a shadow in the current mode; it follows the widget's geometry
+    // and visibility from then on.
+    void add(QWidget *widget);
+    void add(QWidget *widget, const Style &style);
+
+    Mode mode() const { return m_mode; }
+
+    // Re-applies every registered shadow in 'mode'.
+    void setMode(Mode mode);
+
+signals:
+    void modeChanged(ShadowManager::Mode mode);
+
+private:
+    struct Target {
+        QPointer<QWidget> widget;
+        Style style;
+        QPointer<QWidget> decoration;   // Cached mode only
+    };
+
+    void apply(Target &target);
+    void clear(Target &target);
+
+    Mode m_mode;
+    QList<Target> m_targets;
+};
+
+#endif // SHADOWMANAGER_H
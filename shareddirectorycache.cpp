@@ -0,0 +1,390 @@
+#include "shareddirectorycache.h"
+#include "appconfig.h"
+#include "storagebackend.h"
+#include "tracing.h"
+
+#include <QByteArray>
+#include <QDeadlineTimer>
+#include <QThread>
+#include <QDebug>
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+// Lives at the start of the segment, followed by the payload:
+//   employees: userId, hwid, role, status (quint32 length + UTF-16), rowVersion,
+//              lastSeen, createdAt (qint64, msecs since epoch or kNullTime)
+//   whitelist: hwid (as above), permission (quint32), starting at whitelistOffset
+struct SharedDirectoryCache::Header {
+    std::atomic<quint64> sequence;        // odd while a publisher writes
+    std::atomic<qint64> publishedMs;      // 0: nothing published, or invalidated
+    std::atomic<qint64> refreshLeaseMs;   // lease expiry; 0: free
+    std::atomic<quint64> generation;      // bumped by every invalidate()
+    quint32 magic;
+    quint32 layout;
+    quint64 payloadBytes;
+    quint64 whitelistOffset;
+    quint32 employeeCount;
+    quint32 whitelistCount;
+};
+
+namespace {
+
+// A new segment is zero-filled: no magic means nothing was published yet.
+constexpr quint32 kMagic = 0x46435241;   // "ARCF"
+// Bump when the payload encoding changes; older snapshots are then ignored.
+constexpr quint32 kLayout = 2;
+constexpr qint64 kNullTime = std::numeric_limits<qint64>::min();
+
+static_assert(std::atomic<quint64>::is_always_lock_free && std::atomic<qint64>::is_always_lock_free,
+              "the header atomics are shared between processes");
+
+qsizetype textBytes(const QString &text)
+{
+    return qsizetype(sizeof(quint32)) + text.size() * qsizetype(sizeof(QChar));
+}
+
+qsizetype employeeBytes(const EmployeeRecord &record)
+{
+    return textBytes(record.userId) + textBytes(record.hwid) + textBytes(record.role)
+           + textBytes(record.status) + 3 * qsizetype(sizeof(qint64));
+}
+
+qsizetype whitelistBytes(const statements::WhitelistRow &row)
+{
+    return textBytes(row.hwid) + qsizetype(sizeof(quint32));
+}
+
+class PayloadWriter
+{
+public:
+    explicit PayloadWriter(char *out) : m_out(out) {}
+
+    void u32(quint32 value) { put(&value, sizeof(value)); }
+    void i64(qint64 value) { put(&value, sizeof(value)); }
+    void text(const QString &text)
+    {
+        u32(quint32(text.size()));
+        put(text.constData(), size_t(text.size()) * sizeof(QChar));
+    }
+    void time(const QDateTime &time) { i64(time.isValid() ? time.toMSecsSinceEpoch() : kNullTime); }
+
+private:
+    void put(const void *data, size_t bytes)
+    {
+        if (bytes)
+            std::memcpy(m_out, data, bytes);
+        m_out += bytes;
+    }
+
+    char *m_out;
+};
+
+// Decodes a private copy of the payload; every length is checked against the
+// copy, so a snapshot of another layout cannot read past it.
+class PayloadReader
+{
+public:
+    PayloadReader(const char *begin, const char *end) : m_at(begin), m_end(end) {}
+
+    bool ok() const { return m_ok; }
+
+    quint32 u32()
+    {
+        quint32 value = 0;
+        take(&value, sizeof(value));
+        return value;
+    }
+    qint64 i64()
+    {
+        qint64 value = 0;
+        take(&value, sizeof(value));
+        return value;
+    }
+    QString text()
+    {
+        const quint32 length = u32();
+        if (!m_ok || length == 0)
+            return QString();
+        if (size_t(m_end - m_at) / sizeof(QChar) < length) {
+            m_ok = false;
+            return QString();
+        }
+        QString text(qsizetype(length), Qt::Uninitialized);
+        take(text.data(), size_t(length) * sizeof(QChar));
+        return text;
+    }
+    QDateTime time()
+    {
+        const qint64 msecs = i64();
+        return msecs == kNullTime ? QDateTime() : QDateTime::fromMSecsSinceEpoch(msecs);
+    }
+
+private:
+    void take(void *out, size_t bytes)
+    {
+        if (!m_ok || size_t(m_end - m_at) < bytes) {
+            m_ok = false;
+            return;
+        }
+        std::memcpy(out, m_at, bytes);
+        m_at += bytes;
+    }
+
+    const char *m_at;
+    const char *m_end;
+    bool m_ok = true;
+};
+
+} // namespace
+
+SharedDirectoryCache *SharedDirectoryCache::configured()
+{
+    // Never destroyed: loaders on scheduler workers may still use it during
+    // shutdown. The system drops the mapping when the process exits.
+    static SharedDirectoryCache *cache = []() -> SharedDirectoryCache * {
+        if (!AppConfig::boolValue(AppConfig::SharedDirectoryEnabled))
+            return nullptr;
+        auto *created = new SharedDirectoryCache(StorageBackend::instance().databaseIdentity(),
+                                                 AppConfig::intValue(AppConfig::SharedDirectoryBytes));
+        if (!created->isAttached()) {
+            delete created;
+            return nullptr;
+        }
+        return created;
+    }();
+    return cache;
+}
+
+SharedDirectoryCache::SharedDirectoryCache(const QString &databaseIdentity, qsizetype capacityBytes)
+{
+    // Instances pointed at different databases get different segments.
+    m_memory.setNativeKey(QSharedMemory::legacyNativeKey(
+        QString("archiflow-directory-%1").arg(databaseIdentity.left(16))));
+
+    if (!m_memory.create(qsizetype(sizeof(Header)) + capacityBytes)) {
+        // Another instance created it first; its size wins.
+        if (m_memory.error() != QSharedMemory::AlreadyExists || !m_memory.attach()) {
+            qWarning() << "Shared directory cache unavailable:" << m_memory.errorString();
+            return;
+        }
+    }
+    if (m_memory.size() < qsizetype(sizeof(Header))) {
+        qWarning() << "Shared directory cache segment is too small:" << m_memory.size() << "bytes";
+        m_memory.detach();
+        return;
+    }
+
+    m_header = static_cast<Header *>(m_memory.data());
+    m_payloadCapacity = m_memory.size() - qsizetype(sizeof(Header));
+}
+
+bool SharedDirectoryCache::read(Snapshot *snapshot, int parts) const
+{
+    if (!m_header)
+        return false;
+
+    TraceSpan span("cache", "directory.read");
+    const qint64 maxAgeMs = AppConfig::intValue(AppConfig::SharedDirectoryMaxAgeMs);
+    const char *payload = reinterpret_cast<const char *>(m_header + 1);
+
+    for (int attempt = 0; attempt < MaxReadAttempts; ++attempt) {
+        const quint64 before = m_header->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        // Everything below may be torn; it is only trusted once the sequence
+        // turns out unchanged.
+        const qint64 publishedMs = m_header->publishedMs.load(std::memory_order_relaxed);
+        const quint32 magic = m_header->magic;
+        const quint32 layout = m_header->layout;
+        const quint64 payloadBytes = m_header->payloadBytes;
+        const quint64 whitelistOffset = m_header->whitelistOffset;
+        const quint32 employeeCount = m_header->employeeCount;
+        const quint32 whitelistCount = m_header->whitelistCount;
+
+        const bool fresh = magic == kMagic && layout == kLayout && publishedMs != 0
+                           && QDateTime::currentMSecsSinceEpoch() - publishedMs <= maxAgeMs
+                           && payloadBytes <= quint64(m_payloadCapacity)
+                           && whitelistOffset <= payloadBytes;
+        const quint64 from = (parts & Employees) ? 0 : whitelistOffset;
+        const quint64 to = (parts & Whitelist) ? payloadBytes : whitelistOffset;
+        QByteArray copy;
+        if (fresh)
+            copy = QByteArray(payload + from, qsizetype(to - from));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_header->sequence.load(std::memory_order_relaxed) != before)
+            continue;
+
+        if (!fresh)
+            return false;
+
+        Snapshot decoded;
+        decoded.publishedAt = QDateTime::fromMSecsSinceEpoch(publishedMs);
+        PayloadReader reader(copy.constData(), copy.constData() + copy.size());
+        if (parts & Employees) {
+            decoded.employees.reserve(qMin<qsizetype>(employeeCount, copy.size() / employeeBytes({})));
+            for (quint32 i = 0; i < employeeCount && reader.ok(); ++i) {
+                EmployeeRecord record;
+                record.userId = reader.text();
+                record.hwid = reader.text();
+                record.role = reader.text();
+                record.status = reader.text();
+                record.passwordHashLoaded = false;
+                record.rowVersion = reader.i64();
+                record.lastSeen = reader.time();
+                record.createdAt = reader.time();
+                decoded.employees.append(std::move(record));
+            }
+        }
+        if (parts & Whitelist) {
+            decoded.whitelist.reserve(qMin<qsizetype>(whitelistCount, copy.size() / whitelistBytes({})));
+            for (quint32 i = 0; i < whitelistCount && reader.ok(); ++i) {
+                statements::WhitelistRow row;
+                row.hwid = reader.text();
+                row.permission = int(reader.u32());
+                decoded.whitelist.append(std::move(row));
+            }
+        }
+        if (!reader.ok()) {
+            qWarning() << "Shared directory snapshot could not be decoded; ignoring it.";
+            return false;
+        }
+
+        span.setRows(decoded.employees.size() + decoded.whitelist.size());
+        *snapshot = std::move(decoded);
+        return true;
+    }
+    return false;
+}
+
+bool SharedDirectoryCache::acquire(Snapshot *snapshot, bool *refreshing)
+{
+    *refreshing = false;
+    if (!m_header || AppConfig::intValue(AppConfig::SharedDirectoryMaxAgeMs) == 0)
+        return false;
+
+    // The lease expires on its own, so a refresher that died is replaced; the
+    // deadline only bounds the wait.
+    QDeadlineTimer deadline(LeaseMs);
+    while (!read(snapshot)) {
+        if (tryLease()) {
+            *refreshing = true;
+            return false;
+        }
+        if (deadline.hasExpired())
+            return false;
+        QThread::msleep(PollMs);
+    }
+    return true;
+}
+
+bool SharedDirectoryCache::tryLease()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 held = m_header->refreshLeaseMs.load(std::memory_order_relaxed);
+    if (held > now || !m_header->refreshLeaseMs.compare_exchange_strong(held, now + LeaseMs))
+        return false;
+    // Taken before the rows are read: an invalidation after this point may not be
+    // reflected in them.
+    m_leaseGeneration = m_header->generation.load();
+    return true;
+}
+
+bool SharedDirectoryCache::publish(const QList<EmployeeRecord> &employees,
+                                   const QList<statements::WhitelistRow> &whitelist,
+                                   QString *errorText)
+{
+    if (!m_header)
+        return false;
+
+    TraceSpan span("cache", "directory.publish");
+    qsizetype whitelistOffset = 0;
+    for (const EmployeeRecord &record : employees)
+        whitelistOffset += employeeBytes(record);
+    qsizetype payloadBytes = whitelistOffset;
+    for (const statements::WhitelistRow &row : whitelist)
+        payloadBytes += whitelistBytes(row);
+
+    if (payloadBytes > m_payloadCapacity) {
+        abandonRefresh();
+        if (errorText)
+            *errorText = QString("The directory needs %1 bytes; the shared segment holds %2 (%3).")
+                             .arg(payloadBytes).arg(m_payloadCapacity)
+                             .arg(AppConfig::key(AppConfig::SharedDirectoryBytes));
+        return false;
+    }
+
+    // A write that settled while the rows were being read may be missing from
+    // them; the next load reads again.
+    const quint64 generation = m_leaseGeneration;
+    if (m_header->generation.load() != generation) {
+        abandonRefresh();
+        return true;
+    }
+
+    QMutexLocker locker(&m_publishMutex);
+    if (!m_memory.lock()) {
+        abandonRefresh();
+        if (errorText)
+            *errorText = m_memory.errorString();
+        return false;
+    }
+
+    // Odd while writing. A publisher that died mid-write left it odd already.
+    const quint64 sequence = m_header->sequence.load(std::memory_order_relaxed) | 1;
+    m_header->sequence.store(sequence, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    PayloadWriter writer(reinterpret_cast<char *>(m_header + 1));
+    for (const EmployeeRecord &record : employees) {
+        writer.text(record.userId);
+        writer.text(record.hwid);
+        writer.text(record.role);
+        writer.text(record.status);
+        writer.i64(record.rowVersion);
+        writer.time(record.lastSeen);
+        writer.time(record.createdAt);
+    }
+    for (const statements::WhitelistRow &row : whitelist) {
+        writer.text(row.hwid);
+        writer.u32(quint32(row.permission));
+    }
+    m_header->magic = kMagic;
+    m_header->layout = kLayout;
+    m_header->payloadBytes = quint64(payloadBytes);
+    m_header->whitelistOffset = quint64(whitelistOffset);
+    m_header->employeeCount = quint32(employees.size());
+    m_header->whitelistCount = quint32(whitelist.size());
+    // Sequentially consistent with invalidate(): either its zero lands after this
+    // store, or the generation it bumped first is seen here and the snapshot is
+    // withdrawn before readers can take it.
+    m_header->publishedMs.store(QDateTime::currentMSecsSinceEpoch());
+    if (m_header->generation.load() != generation)
+        m_header->publishedMs.store(0);
+
+    m_header->sequence.store(sequence + 1, std::memory_order_release);
+    m_header->refreshLeaseMs.store(0, std::memory_order_release);
+    m_memory.unlock();
+
+    span.setRows(employees.size() + whitelist.size());
+    return true;
+}
+
+void SharedDirectoryCache::abandonRefresh()
+{
+    if (m_header)
+        m_header->refreshLeaseMs.store(0, std::memory_order_release);
+}
+
+void SharedDirectoryCache::invalidate()
+{
+    if (!m_header)
+        return;
+    m_header->generation.fetch_add(1);
+    m_header->publishedMs.store(0);
+}
@@ -0,0 +1,89 @@
+#ifndef SHAREDDIRECTORYCACHE_H
+#define SHAREDDIRECTORYCACHE_H
+
+#include <QString>
+#include <QList>
+#include <QDateTime>
+#include <QMutex>
+#include <QSharedMemory>
+
+#include "employeerecord.h"
+#include "statements.h"
+
+// A snapshot of the directory ('empl' without password hashes, and
+// WHITELISTED_USERS) in shared memory, for the instances running on one host.
+//
+// Off by default ("cache/sharedDirectory", ARCHIFLOW_SHARED_CACHE). When on, every
+// instance configured for the same database attaches to one segment. A loader
+// that finds a snapshot younger than "cache/sharedMaxAgeMs" decodes it instead of
+// querying; otherwise one instance takes the refresh lease, queries and publishes
+// while the others wait for its snapshot (or query themselves when the lease runs
+// out). Writes through the journal and registrations invalidate the snapshot, so
+// the next load on any instance goes to the database again.
+//
+// The segment holds a header and one payload. The publisher writes under the
+// segment lock and bumps a sequence counter before (odd: writing) and after (even:
+// stable); readers take no lock, copy the payload out and retry when the counter
+// was odd or moved meanwhile. Password hashes are never published; loads that need
+// them always query.
+//
+// The segment is local to the host (on Windows, to the login session).
+class SharedDirectoryCache
+{
+public:
+    enum Part {
+        Employees = 0x1,
+        Whitelist = 0x2,
+        Everything = Employees | Whitelist
+    };
+
+    struct Snapshot {
+        QList<EmployeeRecord> employees;        // passwordHashLoaded = false
+        QList<statements::WhitelistRow> whitelist;
+        QDateTime publishedAt;
+    };
+
+    // The cache for the configured backend; null when the cache is off or the
+    // segment could not be created.
+    static SharedDirectoryCache *configured();
+
+    SharedDirectoryCache(const QString &databaseIdentity, qsizetype capacityBytes);
+
+    bool isAttached() const { return m_header != nullptr; }
+
+    // Decodes the parts asked for from a snapshot that is fresh; false when there
+    // is none or it stayed mid-update through every retry.
+    bool read(Snapshot *snapshot, int parts = Everything) const;
+
+    // Returns a fresh snapshot, waiting while another instance refreshes it. False
+    // with *refreshing set: this caller holds the lease and should load and
+    // publish() (or abandonRefresh()); false without: load privately.
+    bool acquire(Snapshot *snapshot, bool *refreshing);
+
+    // Replaces the snapshot and releases the refresh lease. Skipped (still true)
+    // when the snapshot was invalidated after the lease was taken.
+    bool publish(const QList<EmployeeRecord> &employees,
+                 const QList<statements::WhitelistRow> &whitelist,
+                 QString *errorText = nullptr);
+    void abandonRefresh();
+
+    // Marks the snapshot stale for every instance.
+    void invalidate();
+
+private:
+    struct Header;
+
+    static constexpr int MaxReadAttempts = 8;
+    static constexpr int LeaseMs = 20000;
+    static constexpr int PollMs = 50;
+
+    bool tryLease();
+
+    QSharedMemory m_memory;
+    Header *m_header = nullptr;
+    quint64 m_leaseGeneration = 0;   // the segment's generation when this process took the lease
+    qsizetype m_payloadCapacity = 0;
+    QMutex m_publishMutex;   // QSharedMemory::lock() is not re-entrant per object
+};
+
+#endif // SHAREDDIRECTORYCACHE_H
@@ -9,17 +9,62 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    allocationstats.cpp \
+    appconfig.cpp \
+    dashboardanalytics.cpp \
+    dashboardviews.cpp \
+    diagnosticsdialog.cpp \
+    employeeactiondelegate.cpp \
+    employeemodel.cpp \
     home.cpp \
+    lookupcache.cpp \
     main.cpp \
     login.cpp \
-    register.cpp
+    presenceservice.cpp \
+    register.cpp \
+    schemamigrator.cpp \
+    sessiontoken.cpp \
+    sha256batch.cpp \
+    shadowmanager.cpp \
+    shareddirectorycache.cpp \
+    stallwatchdog.cpp \
+    storagebackend.cpp \
+    taskscheduler.cpp \
+    tracing.cpp \
+    userrepository.cpp \
+    writebehindqueue.cpp \
+    writejournal.cpp
 
 HEADERS += \
+    allocationstats.h \
+    appconfig.h \
+    dashboardanalytics.h \
+    dashboardviews.h \
     databaseloader.h \
+    diagnosticsdialog.h \
+    employeeactiondelegate.h \
+    employeemodel.h \
+    employeerecord.h \
     home.h \
     login.h \
+    lookupcache.h \
     pdfexportworker.h \
-    register.h
+    presenceservice.h \
+    register.h \
+    schema.h \
+    schemamigrator.h \
+    sessiontoken.h \
+    sha256batch.h \
+    shadowmanager.h \
+    shareddirectorycache.h \
+    stallwatchdog.h \
+    statements.h \
+    storagebackend.h \
+    taskscheduler.h \
+    tracing.h \
+    userrepository.h \
+    writebehindqueue.h \
+    writejournal.h
 
 FORMS += \
     home.ui \
@@ -39,3 +84,6 @@ QT += core gui sql printsupport
 
 
 QT += charts
+
+# Lets the stall watchdog's backtrace_symbols() name the application's own functions.
+linux: QMAKE_LFLAGS += -rdynamic
@@ -0,0 +1,401 @@
+#include "stallwatchdog.h"
+#include "appconfig.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QDeadlineTimer>
+#include <QStandardPaths>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QDebug>
+
+#include <array>
+#include <utility>
+
+#if defined(Q_OS_WIN)
+#  include <windows.h>
+#elif defined(Q_OS_LINUX)
+#  include <cerrno>
+#  include <cstdlib>
+#  include <ctime>
+#  include <cxxabi.h>
+#  include <execinfo.h>
+#  include <pthread.h>
+#  include <semaphore.h>
+#  include <signal.h>
+#endif
+
+namespace {
+
+constexpr int kMaxFrames = 64;
+
+QString spanText(const Tracer::Event &span)
+{
+    return QString("%1 %2 (%3 ms)").arg(QLatin1String(span.category), span.name)
+                                   .arg(span.durationNs / 1e6, 0, 'f', 1);
+}
+
+#if defined(Q_OS_WIN)
+
+HANDLE g_guiThread = nullptr;
+
+void prepareCapture()
+{
+    DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &g_guiThread,
+                    THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, 0);
+}
+
+QStringList captureStack()
+{
+    if (!g_guiThread)
+        return {};
+
+    // Nothing between SuspendThread and ResumeThread may allocate: the GUI thread
+    // could be holding the heap lock.
+    std::array<DWORD64, kMaxFrames> frames;
+    int count = 0;
+    if (SuspendThread(g_guiThread) == DWORD(-1))
+        return {};
+    CONTEXT context;
+    ZeroMemory(&context, sizeof(context));
+    context.ContextFlags = CONTEXT_FULL;
+    if (GetThreadContext(g_guiThread, &context)) {
+#if defined(_M_X64) || defined(__x86_64__)
+        while (count < kMaxFrames && context.Rip) {
+            frames[count++] = context.Rip;
+            DWORD64 imageBase = 0;
+            PRUNTIME_FUNCTION function = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+            if (function) {
+                PVOID handlerData = nullptr;
+                DWORD64 establisherFrame = 0;
+                RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context,
+                                 &handlerData, &establisherFrame, nullptr);
+            } else {
+                // A leaf function: the return address is on top of the stack.
+                context.Rip = *reinterpret_cast<const DWORD64 *>(context.Rsp);
+                context.Rsp += sizeof(DWORD64);
+            }
+        }
+#endif
+    }
+    ResumeThread(g_guiThread);
+
+    QStringList stack;
+    for (int i = 0; i < count; ++i) {
+        HMODULE module = nullptr;
+        wchar_t path[MAX_PATH] = {};
+        if (GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS
+                                   | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                               reinterpret_cast<LPCWSTR>(frames[i]), &module)
+            && GetModuleFileNameW(module, path, MAX_PATH)) {
+            stack.append(QString("%1+0x%2").arg(QFileInfo(QString::fromWCharArray(path)).fileName())
+                                           .arg(frames[i] - reinterpret_cast<DWORD64>(module), 0, 16));
+        } else {
+            stack.append(QString("0x%1").arg(frames[i], 0, 16));
+        }
+    }
+    return stack;
+}
+
+#elif defined(Q_OS_LINUX)
+
+pthread_t g_guiThread;
+void *g_frames[kMaxFrames];
+volatile sig_atomic_t g_frameCount = 0;
+sem_t g_captured;
+
+int captureSignal()
+{
+    return SIGRTMIN + 2;
+}
+
+// Runs on the GUI thread, interrupted wherever it is blocked.
+void onCaptureSignal(int)
+{
+    const int savedErrno = errno;
+    g_frameCount = backtrace(g_frames, kMaxFrames);
+    sem_post(&g_captured);
+    errno = savedErrno;
+}
+
+void prepareCapture()
+{
+    g_guiThread = pthread_self();
+    sem_init(&g_captured, 0, 0);
+    // The first backtrace() loads libgcc, which allocates; never do that in the handler.
+    void *warmUp[1];
+    backtrace(warmUp, 1);
+
+    struct sigaction action = {};
+    action.sa_handler = onCaptureSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(captureSignal(), &action, nullptr);
+}
+
+QString demangledFrame(const char *symbol)
+{
+    // "binary(mangled+0x1f) [0x...]"
+    QString text = QString::fromLocal8Bit(symbol);
+    const int open = text.indexOf(QLatin1Char('('));
+    const int plus = text.indexOf(QLatin1Char('+'), open);
+    if (open < 0 || plus <= open + 1)
+        return text;
+    const QByteArray mangled = text.mid(open + 1, plus - open - 1).toLocal8Bit();
+    int status = -1;
+    char *name = abi::__cxa_demangle(mangled.constData(), nullptr, nullptr, &status);
+    if (status == 0 && name)
+        text.replace(open + 1, plus - open - 1, QString::fromLocal8Bit(name));
+    std::free(name);
+    return text;
+}
+
+QStringList captureStack()
+{
+    while (sem_trywait(&g_captured) == 0) {
+    }
+    g_frameCount = 0;
+    if (pthread_kill(g_guiThread, captureSignal()) != 0)
+        return {};
+
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += 200 * 1000 * 1000;
+    if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000 * 1000 * 1000;
+    }
+    int waited;
+    do {
+        waited = sem_timedwait(&g_captured, &deadline);
+    } while (waited != 0 && errno == EINTR);
+    if (waited != 0)
+        return {};
+
+    const int count = g_frameCount;
+    QStringList stack;
+    if (char **symbols = backtrace_symbols(g_frames, count)) {
+        // Frame 0 is the handler, frame 1 the kernel's signal trampoline.
+        for (int i = 2; i < count; ++i)
+            stack.append(demangledFrame(symbols[i]));
+        std::free(symbols);
+    }
+    return stack;
+}
+
+#else
+
+void prepareCapture()
+{
+}
+
+QStringList captureStack()
+{
+    return {};
+}
+
+#endif
+
+} // namespace
+
+StallWatchdog &StallWatchdog::instance()
+{
+    static StallWatchdog watchdog;
+    return watchdog;
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    stop();
+}
+
+void StallWatchdog::start()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_thread)
+        return;
+    m_guiThread = QThread::currentThread();
+    m_stopping = false;
+    prepareCapture();
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("stall-watchdog");
+    m_thread->start(QThread::HighPriority);
+}
+
+void StallWatchdog::stop()
+{
+    QThread *thread = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+        std::swap(thread, m_thread);
+    }
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void StallWatchdog::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_stopping) {
+        const int thresholdMs = AppConfig::intValue(AppConfig::StallThresholdMs);
+        if (thresholdMs <= 0) {
+            m_wake.wait(&m_mutex, 1000);
+            continue;
+        }
+
+        QObject *target = QCoreApplication::instance();
+        if (!target)
+            break;
+        const quint64 beat = ++m_beatsSent;
+        const qint64 sentNs = Tracer::nowNs();
+        const QDateTime sentAt = QDateTime::currentDateTime();
+        QMetaObject::invokeMethod(target, [this, beat]() {
+            QMutexLocker locker(&m_mutex);
+            m_beatsAnswered = qMax(m_beatsAnswered, beat);
+            m_answeredNs = Tracer::nowNs();
+            m_wake.wakeAll();
+        }, Qt::QueuedConnection);
+
+        const QDeadlineTimer answerBy(thresholdMs);
+        while (!m_stopping && m_beatsAnswered < beat && !answerBy.hasExpired())
+            m_wake.wait(&m_mutex, answerBy);
+
+        if (!m_stopping && m_beatsAnswered < beat) {
+            // Still blocked: look at what the GUI thread is doing right now.
+            Stall stall;
+            stall.at = sentAt;
+            locker.unlock();
+            stall.spans = Tracer::openSpans(m_guiThread);
+            stall.stack = captureStack();
+            locker.relock();
+
+            while (!m_stopping && m_beatsAnswered < beat)
+                m_wake.wait(&m_mutex);
+            if (m_stopping)
+                break;
+            stall.durationNs = m_answeredNs - sentNs;
+            record(stall);
+
+            QStringList spans;
+            for (const Tracer::Event &span : stall.spans)
+                spans.append(spanText(span));
+            locker.unlock();
+            qWarning().noquote() << QString("GUI thread stalled for %1 ms").arg(stall.durationNs / 1e6, 0, 'f', 1)
+                                 << (spans.isEmpty() ? QString() : "in " + spans.join(" > "));
+            QString errorText;
+            if (!writeReport(reportPath(), &errorText))
+                qWarning() << "Cannot write stall report:" << errorText;
+            locker.relock();
+        }
+
+        m_wake.wait(&m_mutex, qMax(5, thresholdMs / 2));
+    }
+}
+
+void StallWatchdog::record(const Stall &stall)
+{
+    const qint64 ms = stall.durationNs / 1000000;
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && ms >= BucketBoundsMs[bucket])
+        ++bucket;
+
+    m_report.thresholdMs = AppConfig::intValue(AppConfig::StallThresholdMs);
+    ++m_report.stalls;
+    ++m_report.histogram[bucket];
+    m_report.recent.prepend(stall);
+    if (m_report.recent.size() > MaxKeptStalls)
+        m_report.recent.removeLast();
+}
+
+StallWatchdog::Report StallWatchdog::report() const
+{
+    QMutexLocker locker(&m_mutex);
+    Report report = m_report;
+    report.thresholdMs = AppConfig::intValue(AppConfig::StallThresholdMs);
+    return report;
+}
+
+void StallWatchdog::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_report = Report();
+}
+
+QString StallWatchdog::reportPath()
+{
+    QString path = AppConfig::stringValue(AppConfig::StallReportPath);
+    if (path.isEmpty()) {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        path = QDir(dir).filePath("stalls.txt");
+    }
+    return path;
+}
+
+QString StallWatchdog::bucketName(int bucket)
+{
+    if (bucket == 0)
+        return QString("< %1 ms").arg(BucketBoundsMs[0]);
+    if (bucket >= BucketCount - 1)
+        return QString(">= %1 ms").arg(BucketBoundsMs[BucketCount - 2]);
+    return QString("%1-%2 ms").arg(BucketBoundsMs[bucket - 1]).arg(BucketBoundsMs[bucket]);
+}
+
+bool StallWatchdog::writeReport(const QString &path, QString *errorText) const
+{
+    const Report current = report();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        if (errorText)
+            *errorText = file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "ARCHIFLOW GUI stall report\n"
+        << "written " << QDateTime::currentDateTime().toString(Qt::ISODateWithMs)
+        << ", threshold " << current.thresholdMs << " ms, "
+        << current.stalls << " stalls\n\n";
+
+    out << "Stall durations\n";
+    for (int bucket = 0; bucket < BucketCount; ++bucket)
+        out << "  " << bucketName(bucket).leftJustified(14) << current.histogram[bucket] << '\n';
+
+    out << "\nMost recent stalls\n";
+    for (const Stall &stall : current.recent) {
+        out << '\n' << stall.at.toString(Qt::ISODateWithMs) << "  "
+            << QString::number(stall.durationNs / 1e6, 'f', 1) << " ms\n";
+        if (stall.spans.isEmpty()) {
+            out << "  spans: none open\n";
+        } else {
+            QStringList spans;
+            for (const Tracer::Event &span : stall.spans)
+                spans.append(spanText(span));
+            out << "  spans: " << spans.join(" > ") << '\n';
+        }
+        if (stall.stack.isEmpty()) {
+            out << "  stack: not captured\n";
+        } else {
+            out << "  stack:\n";
+            for (int i = 0; i < stall.stack.size(); ++i)
+                out << "    #" << i << ' ' << stall.stack.at(i) << '\n';
+        }
+    }
+    out.flush();
+
+    if (!file.commit()) {
+        if (errorText)
+            *errorText = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QDateTime>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "tracing.h"
+
+class QThread;
+
+// Watches the GUI event loop from a thread of its own.
+//
+// The watchdog posts a heartbeat to the GUI thread every half threshold and waits
+// for it to be delivered. A heartbeat that is still queued after the threshold
+// ("diagnostics/stallThresholdMs", default 50 ms, see AppConfig) means the loop is
+// blocked in some handler: the watchdog then records the trace spans open on the
+// GUI thread (e.g. "ui updateWhitelistTable > sql.exec whitelist.select_all") and
+// the GUI thread's call stack, waits for the heartbeat to arrive and files the
+// stall under its full duration. A modal dialog's nested loop delivers heartbeats, so
+// it does not count as a stall.
+//
+// Stack capture interrupts the GUI thread only for the walk itself: on Windows it
+// is suspended and unwound (frames as module+offset, for addr2line or a map
+// file); on Linux a signal makes it call backtrace() on itself. Elsewhere only
+// the spans are recorded.
+//
+// The stall histogram and the most recent stalls are rewritten to the report file
+// ("diagnostics/stallReport", else stalls.txt in the application data directory)
+// after every stall, so it survives a window that is killed while frozen.
+class StallWatchdog
+{
+public:
+    // Upper bounds of the histogram buckets; the last bucket is open-ended.
+    static constexpr int BucketBoundsMs[] = { 100, 250, 500, 1000, 2500, 5000 };
+    static constexpr int BucketCount = int(sizeof(BucketBoundsMs) / sizeof(BucketBoundsMs[0])) + 1;
+    static constexpr int MaxKeptStalls = 100;
+
+    struct Stall {
+        QDateTime at;                 // when the heartbeat was posted
+        qint64 durationNs = 0;
+        QList<Tracer::Event> spans;   // open on the GUI thread, outermost first
+        QStringList stack;            // GUI thread frames, innermost first
+    };
+
+    struct Report {
+        int thresholdMs = 0;
+        qint64 stalls = 0;            // since start or the last clear()
+        qint64 histogram[BucketCount] = {};
+        QList<Stall> recent;          // newest first, up to MaxKeptStalls
+    };
+
+    static StallWatchdog &instance();
+
+    // Call on the GUI thread; the thread that calls start() is the one watched.
+    void start();
+    void stop();
+
+    Report report() const;
+    void clear();
+
+    static QString reportPath();
+    bool writeReport(const QString &path, QString *errorText = nullptr) const;
+
+    static QString bucketName(int bucket);
+
+private:
+    StallWatchdog() = default;
+    ~StallWatchdog();
+    Q_DISABLE_COPY(StallWatchdog)
+
+    void run();
+    void record(const Stall &stall);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QThread *m_thread = nullptr;
+    const QThread *m_guiThread = nullptr;
+    bool m_stopping = false;
+    quint64 m_beatsSent = 0;
+    quint64 m_beatsAnswered = 0;
+    qint64 m_answeredNs = 0;
+    Report m_report;
+};
+
+#endif // STALLWATCHDOG_H
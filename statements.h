@@ -0,0 +1,235 @@
+#ifndef STATEMENTS_H
+#define STATEMENTS_H
+
+#include "schema.h"
+#include "employeerecord.h"
+
+// Every statement the application and the CLI run against 'empl',
+// WHITELISTED_USERS and activity_log. Each one is checked against schema.h when
+// this header is compiled; see schema::Statement::valid for what is checked.
+namespace statements {
+
+using schema::ActivityLog;
+using schema::Empl;
+using schema::WhitelistedUsers;
+using schema::param;
+using schema::params;
+using schema::field;
+using schema::fields;
+
+// ---- Result rows that are not EmployeeRecord ----
+
+struct StatusCountRow {
+    QString status;
+    int count = 0;
+};
+
+struct WhitelistRow {
+    QString hwid;
+    int permission = 0;
+};
+
+struct CountRow {
+    int count = 0;
+};
+
+// ---- empl ----
+
+inline constexpr auto emplLoadAll = schema::query(
+    "empl.load_all",
+    "SELECT user_id, hwid, role, status, password_hash, row_version, last_seen, created_at FROM empl",
+    params(),
+    fields(field(Empl::userId,       &EmployeeRecord::userId),
+           field(Empl::hwid,         &EmployeeRecord::hwid),
+           field(Empl::role,         &EmployeeRecord::role),
+           field(Empl::status,       &EmployeeRecord::status),
+           field(Empl::passwordHash, &EmployeeRecord::passwordHash),
+           field(Empl::rowVersion,   &EmployeeRecord::rowVersion),
+           field(Empl::lastSeen,     &EmployeeRecord::lastSeen),
+           field(Empl::createdAt,    &EmployeeRecord::createdAt)));
+static_assert(emplLoadAll.valid(), "empl.load_all does not match the schema");
+
+// The directory without password_hash, for a grid that keeps the password column
+// hidden; the hashes of the rows on screen are fetched when it is shown.
+inline constexpr auto emplLoadDirectory = schema::query(
+    "empl.load_directory",
+    "SELECT user_id, hwid, role, status, row_version, last_seen, created_at FROM empl",
+    params(),
+    fields(field(Empl::userId,       &EmployeeRecord::userId),
+           field(Empl::hwid,         &EmployeeRecord::hwid),
+           field(Empl::role,         &EmployeeRecord::role),
+           field(Empl::status,       &EmployeeRecord::status),
+           field(Empl::rowVersion,   &EmployeeRecord::rowVersion),
+           field(Empl::lastSeen,     &EmployeeRecord::lastSeen),
+           field(Empl::createdAt,    &EmployeeRecord::createdAt)));
+static_assert(emplLoadDirectory.valid(), "empl.load_directory does not match the schema");
+
+// Hashes of up to PasswordHashChunk users per round trip, looked up through the
+// unique index on user_id. Unused placeholders repeat one of the ids.
+inline constexpr int PasswordHashChunk = 16;
+inline constexpr auto emplSelectPasswordHashes = schema::query(
+    "empl.select_password_hashes",
+    "SELECT user_id, password_hash FROM empl "
+    " WHERE user_id IN (:id0, :id1, :id2, :id3, :id4, :id5, :id6, :id7, "
+    "                   :id8, :id9, :id10, :id11, :id12, :id13, :id14, :id15)",
+    params(param(":id0",  Empl::userId), param(":id1",  Empl::userId),
+           param(":id2",  Empl::userId), param(":id3",  Empl::userId),
+           param(":id4",  Empl::userId), param(":id5",  Empl::userId),
+           param(":id6",  Empl::userId), param(":id7",  Empl::userId),
+           param(":id8",  Empl::userId), param(":id9",  Empl::userId),
+           param(":id10", Empl::userId), param(":id11", Empl::userId),
+           param(":id12", Empl::userId), param(":id13", Empl::userId),
+           param(":id14", Empl::userId), param(":id15", Empl::userId)),
+    fields(field(Empl::userId,       &EmployeeRecord::userId),
+           field(Empl::passwordHash, &EmployeeRecord::passwordHash)));
+static_assert(emplSelectPasswordHashes.valid(), "empl.select_password_hashes does not match the schema");
+static_assert(decltype(emplSelectPasswordHashes)::ParamCount == PasswordHashChunk,
+              "empl.select_password_hashes must have PasswordHashChunk placeholders");
+
+// Every hash in one scan, for requests too large to send id by id (PDF export).
+inline constexpr auto emplLoadPasswordHashes = schema::query(
+    "empl.load_password_hashes",
+    "SELECT user_id, password_hash FROM empl",
+    params(),
+    fields(field(Empl::userId,       &EmployeeRecord::userId),
+           field(Empl::passwordHash, &EmployeeRecord::passwordHash)));
+static_assert(emplLoadPasswordHashes.valid(), "empl.load_password_hashes does not match the schema");
+
+inline constexpr auto emplSelectPasswordHash = schema::query(
+    "empl.select_password_hash",
+    "SELECT password_hash FROM empl WHERE user_id = :userId",
+    params(param(":userId", Empl::userId)),
+    fields(field(Empl::passwordHash, &EmployeeRecord::passwordHash)));
+static_assert(emplSelectPasswordHash.valid(), "empl.select_password_hash does not match the schema");
+
+// The SELECT only yields a row when the HWID is whitelisted, so the permission
+// check and the insert are the same statement. DISTINCT keeps a duplicated
+// whitelist entry from turning into a self-inflicted unique violation.
+inline constexpr auto emplRegisterWhitelisted = schema::statement(
+    "empl.register_whitelisted",
+    "INSERT INTO empl (user_id, hwid, role, status, password_hash, created_at) "
+    "SELECT DISTINCT :id, :hwid, :role, :status, :pass, :created "
+    "  FROM WHITELISTED_USERS "
+    " WHERE HWID = :wlhwid AND PERMISSION >= 1",
+    params(param(":id",      Empl::userId),
+           param(":hwid",    Empl::hwid),
+           param(":role",    Empl::role),
+           param(":status",  Empl::status),
+           param(":pass",    Empl::passwordHash),
+           param(":created", Empl::createdAt),
+           param(":wlhwid",  WhitelistedUsers::hwid)));
+static_assert(emplRegisterWhitelisted.valid(), "empl.register_whitelisted does not match the schema");
+
+inline constexpr auto emplInsert = schema::statement(
+    "empl.insert",
+    "INSERT INTO empl (user_id, hwid, role, status, password_hash, created_at) "
+    "VALUES (:id, :hwid, :role, :status, :pass, :created)",
+    params(param(":id",      Empl::userId),
+           param(":hwid",    Empl::hwid),
+           param(":role",    Empl::role),
+           param(":status",  Empl::status),
+           param(":pass",    Empl::passwordHash),
+           param(":created", Empl::createdAt)));
+static_assert(emplInsert.valid(), "empl.insert does not match the schema");
+
+inline constexpr auto emplCountByStatus = schema::query(
+    "empl.count_by_status",
+    "SELECT status, COUNT(*) FROM empl GROUP BY status",
+    params(),
+    fields(field(Empl::status,     &StatusCountRow::status),
+           field(schema::countAll, &StatusCountRow::count)));
+static_assert(emplCountByStatus.valid(), "empl.count_by_status does not match the schema");
+
+// Expiry is applied while aggregating, so stale clients need no cleanup writes.
+// The CASE sits in a subquery because Oracle will not GROUP BY an expression
+// containing a bind variable.
+inline constexpr auto emplCountByPresence = schema::query(
+    "empl.count_by_presence",
+    "SELECT presence, COUNT(*) FROM ("
+    "  SELECT CASE WHEN status = 'Online' AND (last_seen IS NULL OR last_seen < :cutoff)"
+    "              THEN 'Offline' ELSE status END AS presence"
+    "    FROM empl"
+    ") GROUP BY presence",
+    params(param(":cutoff", Empl::lastSeen)),
+    fields(field(schema::computed<QString>("presence"), &StatusCountRow::status),
+           field(schema::countAll,                      &StatusCountRow::count)));
+static_assert(emplCountByPresence.valid(), "empl.count_by_presence does not match the schema");
+
+inline constexpr auto emplHeartbeat = schema::statement(
+    "empl.heartbeat",
+    "UPDATE empl SET status = :status, last_seen = :seen WHERE user_id = :id",
+    params(param(":status", Empl::status),
+           param(":seen",   Empl::lastSeen),
+           param(":id",     Empl::userId)));
+static_assert(emplHeartbeat.valid(), "empl.heartbeat does not match the schema");
+
+inline constexpr auto emplUpdateVersioned = schema::statement(
+    "empl.update_versioned", R"(
+        UPDATE empl
+           SET role          = :role,
+               status        = :status,
+               password_hash = COALESCE(:pass, password_hash),
+               last_seen     = COALESCE(:seen, last_seen),
+               row_version   = row_version + 1
+         WHERE user_id       = :id
+           AND row_version   = :ver
+    )",
+    params(param(":role",   Empl::role),
+           param(":status", Empl::status),
+           param(":pass",   Empl::passwordHash),
+           param(":seen",   Empl::lastSeen),
+           param(":id",     Empl::userId),
+           param(":ver",    Empl::rowVersion)));
+static_assert(emplUpdateVersioned.valid(), "empl.update_versioned does not match the schema");
+
+inline constexpr auto emplDeleteVersioned = schema::statement(
+    "empl.delete_versioned",
+    "DELETE FROM empl WHERE user_id = :id AND row_version = :ver",
+    params(param(":id",  Empl::userId),
+           param(":ver", Empl::rowVersion)));
+static_assert(emplDeleteVersioned.valid(), "empl.delete_versioned does not match the schema");
+
+// ---- WHITELISTED_USERS ----
+
+inline constexpr auto whitelistSelectAll = schema::query(
+    "whitelist.select_all",
+    "SELECT HWID, PERMISSION FROM WHITELISTED_USERS",
+    params(),
+    fields(field(WhitelistedUsers::hwid,       &WhitelistRow::hwid),
+           field(WhitelistedUsers::permission, &WhitelistRow::permission)));
+static_assert(whitelistSelectAll.valid(), "whitelist.select_all does not match the schema");
+
+inline constexpr auto whitelistInsert = schema::statement(
+    "whitelist.insert",
+    "INSERT INTO WHITELISTED_USERS (HWID, PERMISSION) VALUES (:hwid, :perm)",
+    params(param(":hwid", WhitelistedUsers::hwid),
+           param(":perm", WhitelistedUsers::permission)));
+static_assert(whitelistInsert.valid(), "whitelist.insert does not match the schema");
+
+inline constexpr auto whitelistUpdatePermission = schema::statement(
+    "whitelist.update_permission",
+    "UPDATE WHITELISTED_USERS SET PERMISSION = :perm WHERE HWID = :hwid",
+    params(param(":perm", WhitelistedUsers::permission),
+           param(":hwid", WhitelistedUsers::hwid)));
+static_assert(whitelistUpdatePermission.valid(), "whitelist.update_permission does not match the schema");
+
+inline constexpr auto whitelistCount = schema::query(
+    "whitelist.count",
+    "SELECT COUNT(*) FROM WHITELISTED_USERS",
+    params(),
+    fields(field(schema::countAll, &CountRow::count)));
+static_assert(whitelistCount.valid(), "whitelist.count does not match the schema");
+
+// ---- activity_log ----
+
+inline constexpr auto activityInsert = schema::statement(
+    "activity.insert",
+    "INSERT INTO activity_log (logged_at, user_id, message) VALUES (:at, :user, :message)",
+    params(param(":at",      ActivityLog::loggedAt),
+           param(":user",    ActivityLog::userId),
+           param(":message", ActivityLog::message)));
+static_assert(activityInsert.valid(), "activity.insert does not match the schema");
+
+} // namespace statements
+
+#endif // STATEMENTS_H
@@ -0,0 +1,219 @@
+#include "storagebackend.h"
+#include "appconfig.h"
+#include "schemamigrator.h"
+#include "sha256batch.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QDir>
+#include <QStringList>
+#include <QThread>
+#include <QDebug>
+
+namespace {
+
+// Rough width of an 'empl' row as the Oracle ODBC driver buffers it (five VARCHAR2
+// columns, two of them 64-character hashes), used to turn rows into FBS bytes.
+constexpr int kEstimatedRowBytes = 256;
+
+bool execAll(QSqlDatabase &db, const QStringList &statements, QString *errorText)
+{
+    QSqlQuery query(db);
+    for (const QString &sql : statements) {
+        if (!query.exec(sql)) {
+            if (errorText)
+                *errorText = QString("%1: %2").arg(sql, query.lastError().text());
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<StorageBackend> createBackend()
+{
+    const QString kind = AppConfig::stringValue(AppConfig::StorageBackendKind).toLower();
+
+    if (kind == QLatin1String("sqlite")) {
+        QString path = AppConfig::stringValue(AppConfig::SqlitePath);
+        if (path.isEmpty())
+            path = SqliteBackend::defaultPath();
+        return std::make_unique<SqliteBackend>(path);
+    }
+
+    if (kind != QLatin1String("oracle"))
+        qWarning() << "Unknown storage backend" << kind << "- using Oracle.";
+
+    QString connectionString = AppConfig::stringValue(AppConfig::OdbcConnectionString);
+    if (connectionString.isEmpty())
+        connectionString = OracleOdbcBackend::defaultConnectionString();
+    return std::make_unique<OracleOdbcBackend>(connectionString);
+}
+
+} // namespace
+
+// ------------------ StorageBackend ------------------
+
+QSqlDatabase StorageBackend::open(const QString &connectionName, QString *errorText) const
+{
+    const QString name = connectionName.isEmpty()
+                             ? QString::fromLatin1(QSqlDatabase::defaultConnection)
+                             : connectionName;
+
+    if (QSqlDatabase::contains(name)) {
+        QSqlDatabase existing = QSqlDatabase::database(name, false);
+        if (existing.isOpen())
+            return existing;
+    }
+
+    QSqlDatabase db = QSqlDatabase::addDatabase(driver(), name);
+    db.setDatabaseName(databaseName());
+    db.setConnectOptions(connectOptions());
+    if (!db.open()) {
+        if (errorText)
+            *errorText = db.lastError().text();
+        return db;
+    }
+    if (!configure(db, errorText)) {
+        db.close();
+        return db;
+    }
+
+    // Once per backend; later connections wait here until the schema is ready.
+    if (m_migrate) {
+        QMutexLocker locker(&m_schemaMutex);
+        if (!m_schemaReady) {
+            if (!ensureSchema(db, errorText)) {
+                db.close();
+                return db;
+            }
+            m_schemaReady = true;
+        }
+    }
+    return db;
+}
+
+bool StorageBackend::ensureSchema(QSqlDatabase &db, QString *errorText) const
+{
+    SchemaMigrator migrator(db, kind());
+    if (!migrator.migrate(errorText))
+        return false;
+
+    // A missing index does not stop the application, but it should not go unnoticed.
+    QString planError;
+    for (const SchemaMigrator::PlanCheck &check : migrator.checkPlans(&planError)) {
+        if (!check.indexed)
+            qWarning().noquote() << check.statement << "reads" << check.table << "without an index:\n" << check.plan;
+    }
+    if (!planError.isEmpty())
+        qWarning() << "Query plan check incomplete:" << planError;
+    return true;
+}
+
+bool StorageBackend::configure(QSqlDatabase &, QString *) const
+{
+    return true;
+}
+
+QString StorageBackend::databaseIdentity() const
+{
+    return Sha256Batch::hex(QString("%1\n%2").arg(driver(), databaseName()).toUtf8());
+}
+
+QString StorageBackend::threadConnectionName(const QString &prefix)
+{
+    return QString("%1-%2").arg(prefix).arg(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+}
+
+bool StorageBackend::isConnectionError(const QSqlError &error)
+{
+    if (error.type() == QSqlError::ConnectionError)
+        return true;
+
+    // A dropped Oracle session surfaces as a statement error: end-of-file on the
+    // channel, not connected, lost contact, or the listener being unreachable.
+    // ODBC reports connection failures with SQLSTATE class 08.
+    static const char *const markers[] = {
+        "ORA-03113", "ORA-03114", "ORA-03135", "ORA-01012",
+        "ORA-12170", "ORA-12541", "ORA-12543", "ORA-12560"
+    };
+    const QString text = error.text();
+    for (const char *marker : markers) {
+        if (text.contains(QLatin1String(marker)))
+            return true;
+    }
+    return error.nativeErrorCode().startsWith(QLatin1String("08"));
+}
+
+const StorageBackend &StorageBackend::instance()
+{
+    static const std::unique_ptr<StorageBackend> backend = createConfigured();
+    return *backend;
+}
+
+std::unique_ptr<StorageBackend> StorageBackend::createConfigured()
+{
+    std::unique_ptr<StorageBackend> backend = createBackend();
+    backend->setFetchSize(AppConfig::intValue(AppConfig::FetchSize));
+    backend->setMigratesSchema(AppConfig::boolValue(AppConfig::MigrateSchema));
+    return backend;
+}
+
+// ------------------ Oracle / ODBC ------------------
+
+OracleOdbcBackend::OracleOdbcBackend(const QString &connectionString)
+    : m_connectionString(connectionString)
+{
+}
+
+QString OracleOdbcBackend::databaseName() const
+{
+    // The Oracle ODBC driver fills its array fetches up to FetchBufferSize (FBS, in
+    // bytes); derive it from the fetch size unless the DSN already pins it.
+    if (m_connectionString.contains(QLatin1String("FBS="), Qt::CaseInsensitive))
+        return m_connectionString;
+
+    QString connectionString = m_connectionString;
+    if (!connectionString.isEmpty() && !connectionString.endsWith(QLatin1Char(';')))
+        connectionString += QLatin1Char(';');
+    return connectionString + QString("FBS=%1;").arg(fetchSize() * kEstimatedRowBytes);
+}
+
+QString OracleOdbcBackend::defaultConnectionString()
+{
+    return QStringLiteral("DRIVER={Oracle in XE};DBQ=XE;UID=DALI;PWD=dali;");
+}
+
+// ------------------ SQLite ------------------
+
+SqliteBackend::SqliteBackend(const QString &path)
+    : m_path(path)
+{
+}
+
+QString SqliteBackend::defaultPath()
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return QDir(dir).filePath("archiflow.sqlite");
+}
+
+QString SqliteBackend::connectOptions() const
+{
+    // Wait on a concurrent writer instead of failing with SQLITE_BUSY.
+    return QStringLiteral("QSQLITE_BUSY_TIMEOUT=5000");
+}
+
+bool SqliteBackend::configure(QSqlDatabase &db, QString *errorText) const
+{
+    // WAL lets readers run alongside the single writer; NORMAL sync is durable across
+    // application crashes and only risks the last commits on power loss.
+    return execAll(db, {
+            "PRAGMA journal_mode = WAL",
+            "PRAGMA synchronous = NORMAL",
+            "PRAGMA temp_store = MEMORY",
+            "PRAGMA cache_size = -16384",
+            "PRAGMA mmap_size = 268435456",
+            "PRAGMA foreign_keys = ON"
+        }, errorText);
+}
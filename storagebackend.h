@@ -0,0 +1,124 @@
+#ifndef STORAGEBACKEND_H
+#define STORAGEBACKEND_H
+
+#include <QString>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QMutex>
+
+#include <memory>
+
+// Where the 'empl' and WHITELISTED_USERS tables live. The application talks to
+// the selected backend only through open(); everything after that is plain QtSql.
+//
+// Selection happens once at startup from AppConfig: "storage/backend"
+// (ARCHIFLOW_BACKEND=oracle|sqlite, default Oracle), with the DSN or database file
+// and the fetch size ("storage/fetchSize") read alongside it.
+//
+// The first connection a backend opens brings the schema up to date (see
+// SchemaMigrator) unless "storage/migrate" (ARCHIFLOW_MIGRATE) is false, e.g. for
+// a schema that a DBA manages.
+class StorageBackend
+{
+public:
+    enum class Kind {
+        Oracle,
+        Sqlite
+    };
+
+    virtual ~StorageBackend() = default;
+
+    virtual Kind kind() const = 0;
+    virtual QString name() const = 0;
+
+    // Returns an open connection with the given name for the calling thread, creating
+    // and configuring it on first use. An empty name means Qt's default connection.
+    // QSqlDatabase connections are thread-bound: use one name per thread.
+    QSqlDatabase open(const QString &connectionName = QString(), QString *errorText = nullptr) const;
+
+    // Applies pending schema migrations and logs hot-path statements that would
+    // scan a whole table.
+    virtual bool ensureSchema(QSqlDatabase &db, QString *errorText = nullptr) const;
+
+    bool migratesSchema() const { return m_migrate; }
+    void setMigratesSchema(bool migrate) { m_migrate = migrate; }
+
+    // Rows the driver should return per network round trip on bulk reads.
+    // Applies to connections opened after the change.
+    int fetchSize() const { return m_fetchSize; }
+    void setFetchSize(int rows) { m_fetchSize = qMax(1, rows); }
+
+    // A digest of the driver and database, equal in every process configured for
+    // the same database; it carries no credentials.
+    QString databaseIdentity() const;
+
+    // "<prefix>-<thread id>": a connection name private to the calling thread.
+    static QString threadConnectionName(const QString &prefix);
+
+    // True when 'error' means the server is unreachable or the session was lost,
+    // as opposed to the statement itself being rejected.
+    static bool isConnectionError(const QSqlError &error);
+
+    // The backend chosen for this process.
+    static const StorageBackend &instance();
+
+    // A new backend built from the same settings as instance().
+    static std::unique_ptr<StorageBackend> createConfigured();
+
+protected:
+    virtual QString driver() const = 0;
+    virtual QString databaseName() const = 0;
+    virtual QString connectOptions() const { return QString(); }
+
+    // Runs once per new connection, right after it opened.
+    virtual bool configure(QSqlDatabase &db, QString *errorText) const;
+
+private:
+    int m_fetchSize = 500;
+    bool m_migrate = true;
+    mutable QMutex m_schemaMutex;
+    mutable bool m_schemaReady = false;
+};
+
+// Oracle XE through the ODBC driver (the production setup).
+class OracleOdbcBackend : public StorageBackend
+{
+public:
+    explicit OracleOdbcBackend(const QString &connectionString);
+
+    Kind kind() const override { return Kind::Oracle; }
+    QString name() const override { return QStringLiteral("oracle"); }
+
+    static QString defaultConnectionString();
+
+protected:
+    QString driver() const override { return QStringLiteral("QODBC"); }
+    QString databaseName() const override;
+
+private:
+    QString m_connectionString;
+};
+
+// Embedded SQLite file in WAL mode, for branch offices, headless runs and benchmarks.
+class SqliteBackend : public StorageBackend
+{
+public:
+    explicit SqliteBackend(const QString &path);
+
+    Kind kind() const override { return Kind::Sqlite; }
+    QString name() const override { return QStringLiteral("sqlite"); }
+    QString path() const { return m_path; }
+
+    static QString defaultPath();
+
+protected:
+    QString driver() const override { return QStringLiteral("QSQLITE"); }
+    QString databaseName() const override { return m_path; }
+    QString connectOptions() const override;
+    bool configure(QSqlDatabase &db, QString *errorText) const override;
+
+private:
+    QString m_path;
+};
+
+#endif // STORAGEBACKEND_H
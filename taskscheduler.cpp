@@ -0,0 +1,244 @@
+#include "taskscheduler.h"
+#include "appconfig.h"
+#include "tracing.h"
+
+#include <QThread>
+#include <QDebug>
+
+#include <exception>
+
+namespace {
+
+// Index of the scheduler worker running on this thread, or -1.
+thread_local int t_workerIndex = -1;
+thread_local TaskScheduler *t_scheduler = nullptr;
+
+// Lanes whose limit comes from AppConfig; Interactive may always use every worker.
+const struct {
+    TaskScheduler::Priority priority;
+    AppConfig::Setting setting;
+} kConfiguredLanes[] = {
+    { TaskScheduler::Load, AppConfig::LoadLaneLimit },
+    { TaskScheduler::Export, AppConfig::ExportLaneLimit },
+    { TaskScheduler::Background, AppConfig::BackgroundLaneLimit },
+};
+
+int configuredWorkerCount()
+{
+    const int workers = AppConfig::intValue(AppConfig::SchedulerWorkers);
+    return workers > 0 ? workers : QThread::idealThreadCount();
+}
+
+} // namespace
+
+// ------------------ TaskHandle ------------------
+
+void TaskHandle::cancel() const
+{
+    if (m_state)
+        m_state->cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool TaskHandle::isCancelled() const
+{
+    return m_state && m_state->cancelled.load(std::memory_order_relaxed);
+}
+
+// ------------------ TaskScheduler ------------------
+
+TaskScheduler::TaskScheduler(int workerCount)
+{
+    workerCount = qMax(2, workerCount);
+
+    // Exports are heavy and rare; loads may overlap a refresh with a search reload.
+    m_limits[Interactive] = workerCount;
+    m_limits[Load] = 2;
+    m_limits[Export] = 1;
+    m_limits[Background] = 1;
+
+    for (int i = 0; i < workerCount; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->thread = QThread::create([this, i]() { workerLoop(i); });
+        worker->thread->setObjectName(QString("scheduler-%1").arg(i));
+        m_workers.push_back(std::move(worker));
+    }
+    for (const auto &worker : m_workers)
+        worker->thread->start();
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    shutdown();
+}
+
+TaskScheduler &TaskScheduler::instance()
+{
+    static TaskScheduler scheduler(configuredWorkerCount());
+    static const bool limitsConfigured = [] {
+        for (const auto &lane : kConfiguredLanes)
+            scheduler.setLaneLimit(lane.priority, AppConfig::intValue(lane.setting));
+        QObject::connect(&AppConfig::instance(), &AppConfig::changed, &AppConfig::instance(),
+                         [](AppConfig::Setting setting) {
+            for (const auto &lane : kConfiguredLanes) {
+                if (lane.setting == setting)
+                    scheduler.setLaneLimit(lane.priority, AppConfig::intValue(setting));
+            }
+        });
+        return true;
+    }();
+    Q_UNUSED(limitsConfigured);
+    return scheduler;
+}
+
+TaskHandle TaskScheduler::submit(Priority priority, const QString &name, Work work,
+                                 std::function<void()> cleanup)
+{
+    Job job;
+    job.priority = priority;
+    job.name = name;
+    job.work = std::move(work);
+    job.cleanup = std::move(cleanup);
+    job.handle.m_state = std::make_shared<TaskHandle::State>();
+    job.queuedNs = Tracer::nowNs();
+    TaskHandle handle = job.handle;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_stopping) {
+        locker.unlock();
+        job.handle.cancel();
+        execute(job);
+        return handle;
+    }
+
+    if (t_scheduler == this && t_workerIndex >= 0) {
+        job.child = true;
+        m_workers[t_workerIndex]->local.push_back(std::move(job));
+    } else {
+        m_lanes[priority].push_back(std::move(job));
+    }
+    m_wake.wakeAll();
+    return handle;
+}
+
+void TaskScheduler::setLaneLimit(Priority priority, int maxConcurrent)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limits[priority] = qMax(1, maxConcurrent);
+    m_wake.wakeAll();
+}
+
+void TaskScheduler::shutdown()
+{
+    std::vector<Job> abandoned;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_stopping)
+            return;
+        m_stopping = true;
+        for (auto &lane : m_lanes) {
+            for (Job &job : lane)
+                abandoned.push_back(std::move(job));
+            lane.clear();
+        }
+        for (const auto &worker : m_workers) {
+            for (Job &job : worker->local)
+                abandoned.push_back(std::move(job));
+            worker->local.clear();
+        }
+        m_wake.wakeAll();
+    }
+
+    for (Job &job : abandoned) {
+        job.handle.cancel();
+        execute(job);
+    }
+
+    for (const auto &worker : m_workers) {
+        worker->thread->wait();
+        delete worker->thread;
+        worker->thread = nullptr;
+    }
+}
+
+bool TaskScheduler::takeJob(int index, Job *job)
+{
+    // 1. Own children, newest first (cache-warm, depth-first).
+    std::deque<Job> &own = m_workers[index]->local;
+    if (!own.empty()) {
+        *job = std::move(own.back());
+        own.pop_back();
+        return true;
+    }
+
+    // 2. Top-level lanes by priority, respecting each lane's concurrency limit.
+    for (int p = 0; p < PriorityCount; ++p) {
+        if (!m_lanes[p].empty() && m_running[p] < m_limits[p]) {
+            *job = std::move(m_lanes[p].front());
+            m_lanes[p].pop_front();
+            return true;
+        }
+    }
+
+    // 3. Steal the oldest child task of another worker.
+    for (size_t offset = 1; offset < m_workers.size(); ++offset) {
+        std::deque<Job> &victim = m_workers[(index + offset) % m_workers.size()]->local;
+        if (!victim.empty()) {
+            *job = std::move(victim.front());
+            victim.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    t_workerIndex = index;
+    t_scheduler = this;
+
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!takeJob(index, &job)) {
+                if (m_stopping)
+                    return;
+                m_wake.wait(&m_mutex);
+            }
+            if (!job.child)
+                ++m_running[job.priority];
+        }
+
+        const bool child = job.child;
+        const Priority priority = job.priority;
+        execute(job);
+
+        if (!child) {
+            QMutexLocker locker(&m_mutex);
+            --m_running[priority];
+            // A lane slot opened up; other workers may be waiting on it.
+            m_wake.wakeAll();
+        }
+    }
+}
+
+void TaskScheduler::execute(Job &job)
+{
+    // Time spent queued shows up next to the run time in the diagnostics table.
+    const qint64 startNs = Tracer::nowNs();
+    Tracer::record("scheduler.wait", job.name, job.queuedNs, startNs - job.queuedNs);
+    TraceSpan span("scheduler.run", job.name);
+
+    if (!job.handle.isCancelled() && job.work) {
+        try {
+            job.work(job.handle);
+        } catch (const std::exception &e) {
+            qWarning() << "Task" << job.name << "threw:" << e.what();
+        } catch (...) {
+            qWarning() << "Task" << job.name << "threw an unknown exception.";
+        }
+    }
+
+    if (job.cleanup)
+        job.cleanup();
+}
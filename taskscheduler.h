@@ -0,0 +1,114 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QThread;
+
+// Caller's view of a submitted task; the same handle is passed to the task body so
+// long-running work can poll isCancelled(). Cancelling a task that has not started
+// yet skips it entirely (its cleanup still runs).
+class TaskHandle
+{
+public:
+    TaskHandle() = default;
+
+    void cancel() const;
+    bool isCancelled() const;
+    bool isValid() const { return m_state != nullptr; }
+
+private:
+    friend class TaskScheduler;
+    struct State {
+        std::atomic<bool> cancelled{false};
+    };
+    std::shared_ptr<State> m_state;
+};
+
+// Fixed pool of worker threads shared by every background job in the application.
+//
+// Top-level submissions go into one FIFO lane per priority; idle workers serve the
+// highest lane that is below its concurrency limit. Tasks submitted from inside a
+// running task (e.g. partitions of a parallel computation) go to the submitting
+// worker's own deque: the owner pops LIFO, idle workers steal FIFO. Child tasks
+// run under their parent's lane budget and are not counted again.
+class TaskScheduler
+{
+public:
+    enum Priority {
+        Interactive = 0,   // short queries the user is waiting on
+        Load,              // directory loads and refreshes
+        Export,            // PDF and file exports
+        Background,        // sync, housekeeping
+        PriorityCount
+    };
+
+    using Work = std::function<void(const TaskHandle &)>;
+
+    explicit TaskScheduler(int workerCount);
+    ~TaskScheduler();
+
+    static TaskScheduler &instance();
+
+    // 'cleanup' runs exactly once on a worker thread: after the work, after an
+    // exception, when cancelled before starting, or at shutdown.
+    TaskHandle submit(Priority priority, const QString &name, Work work,
+                      std::function<void()> cleanup = {});
+
+    // Runs a QObject worker's slot on the pool and deleteLater()s the worker afterwards.
+    // Its signals reach GUI-thread receivers through queued connections.
+    template <typename Worker>
+    TaskHandle run(Priority priority, const QString &name, Worker *worker, void (Worker::*slot)())
+    {
+        return submit(priority, name,
+                      [worker, slot](const TaskHandle &) { (worker->*slot)(); },
+                      [worker]() { worker->deleteLater(); });
+    }
+
+    // Maximum number of top-level tasks of this priority running at once.
+    void setLaneLimit(Priority priority, int maxConcurrent);
+
+    int workerCount() const { return static_cast<int>(m_workers.size()); }
+
+    // Stops accepting work, cancels queued tasks (running their cleanup) and joins
+    // the workers after their current task.
+    void shutdown();
+
+private:
+    struct Job {
+        Priority priority = Background;
+        QString name;
+        Work work;
+        std::function<void()> cleanup;
+        TaskHandle handle;
+        qint64 queuedNs = 0;
+        bool child = false;
+    };
+
+    struct Worker {
+        QThread *thread = nullptr;
+        std::deque<Job> local;
+    };
+
+    void workerLoop(int index);
+    bool takeJob(int index, Job *job);
+    static void execute(Job &job);
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    std::deque<Job> m_lanes[PriorityCount];
+    int m_running[PriorityCount] = {};
+    int m_limits[PriorityCount] = {};
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    bool m_stopping = false;
+};
+
+#endif // TASKSCHEDULER_H
@@ -0,0 +1,318 @@
+#include "tracing.h"
+#include "appconfig.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct ThreadBuffer {
+    int capacity = 0;     // "diagnostics/traceBufferEvents"; the oldest events are overwritten
+    quint64 threadId = 0;
+    QString threadName;
+    const QThread *thread = nullptr;   // compared only; the buffer may outlive it
+    QMutex mutex;
+    QVector<Tracer::Event> events;
+    int next = 0;
+    QVector<Tracer::Event> open;       // spans not finished yet, outermost first
+};
+
+struct Registry {
+    QMutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    quint64 nextThreadId = 1;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+std::atomic<bool> &enabledFlag()
+{
+    static std::atomic<bool> enabled(AppConfig::boolValue(AppConfig::TraceEnabled));
+    return enabled;
+}
+
+const QElapsedTimer &clock()
+{
+    static const QElapsedTimer timer = [] {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    return timer;
+}
+
+// Buffers are owned by the registry so spans survive their thread.
+ThreadBuffer &localBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto created = std::make_shared<ThreadBuffer>();
+        created->capacity = AppConfig::intValue(AppConfig::TraceBufferEvents);
+        created->events.reserve(256);
+
+        Registry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        created->threadId = reg.nextThreadId++;
+        QThread *thread = QThread::currentThread();
+        created->thread = thread;
+        created->threadName = thread ? thread->objectName() : QString();
+        if (created->threadName.isEmpty()) {
+            const bool isMain = QCoreApplication::instance()
+                                && thread == QCoreApplication::instance()->thread();
+            created->threadName = isMain ? QStringLiteral("main")
+                                         : QString("worker-%1").arg(created->threadId);
+        }
+        reg.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+QList<Tracer::Event> snapshotEvents()
+{
+    QList<Tracer::Event> all;
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &buffer : reg.buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        for (const Tracer::Event &event : buffer->events)
+            all.append(event);
+    }
+    return all;
+}
+
+double percentileMs(const std::vector<qint64> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    // Nearest-rank percentile.
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    rank = std::clamp<size_t>(rank, 1, sorted.size());
+    return sorted[rank - 1] / 1e6;
+}
+
+} // namespace
+
+bool Tracer::isEnabled()
+{
+    return enabledFlag().load(std::memory_order_relaxed);
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    enabledFlag().store(enabled, std::memory_order_relaxed);
+}
+
+qint64 Tracer::nowNs()
+{
+    return clock().nsecsElapsed();
+}
+
+void Tracer::record(const char *category, const QString &name,
+                    qint64 startNs, qint64 durationNs, qint64 rows)
+{
+    if (!isEnabled())
+        return;
+
+    ThreadBuffer &buffer = localBuffer();
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    event.rows = rows;
+    event.threadId = buffer.threadId;
+
+    QMutexLocker locker(&buffer.mutex);
+    if (buffer.events.size() < buffer.capacity) {
+        buffer.events.append(event);
+    } else {
+        buffer.events[buffer.next] = event;
+        buffer.next = (buffer.next + 1) % buffer.capacity;
+    }
+}
+
+QList<Tracer::Stats> Tracer::statistics()
+{
+    QHash<QString, std::vector<qint64>> durations;
+    QHash<QString, Stats> stats;
+    for (const Event &event : snapshotEvents()) {
+        const QString key = QString::fromLatin1(event.category) + QLatin1Char('\n') + event.name;
+        durations[key].push_back(event.durationNs);
+        Stats &entry = stats[key];
+        entry.category = QString::fromLatin1(event.category);
+        entry.name = event.name;
+    }
+
+    QList<Stats> result;
+    for (auto it = stats.begin(); it != stats.end(); ++it) {
+        std::vector<qint64> &samples = durations[it.key()];
+        std::sort(samples.begin(), samples.end());
+        Stats entry = it.value();
+        entry.count = static_cast<int>(samples.size());
+        entry.p50Ms = percentileMs(samples, 0.50);
+        entry.p95Ms = percentileMs(samples, 0.95);
+        entry.p99Ms = percentileMs(samples, 0.99);
+        entry.maxMs = samples.back() / 1e6;
+        result.append(entry);
+    }
+    std::sort(result.begin(), result.end(), [](const Stats &a, const Stats &b) {
+        return a.p99Ms > b.p99Ms;
+    });
+    return result;
+}
+
+bool Tracer::exportChromeTrace(const QString &path, QString *errorText)
+{
+    QJsonArray traceEvents;
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    {
+        Registry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        for (const auto &buffer : reg.buffers) {
+            QJsonObject meta;
+            meta["ph"] = "M";
+            meta["name"] = "thread_name";
+            meta["pid"] = pid;
+            meta["tid"] = static_cast<qint64>(buffer->threadId);
+            meta["args"] = QJsonObject{ { "name", buffer->threadName } };
+            traceEvents.append(meta);
+        }
+    }
+
+    for (const Event &event : snapshotEvents()) {
+        QJsonObject entry;
+        entry["ph"] = "X";
+        entry["cat"] = QString::fromLatin1(event.category);
+        entry["name"] = event.name;
+        entry["pid"] = pid;
+        entry["tid"] = static_cast<qint64>(event.threadId);
+        entry["ts"] = event.startNs / 1000.0;
+        entry["dur"] = event.durationNs / 1000.0;
+        if (event.rows >= 0)
+            entry["args"] = QJsonObject{ { "rows", event.rows } };
+        traceEvents.append(entry);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorText)
+            *errorText = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+QList<Tracer::Event> Tracer::openSpans(const QThread *thread)
+{
+    QList<Event> open;
+    const qint64 now = nowNs();
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &buffer : reg.buffers) {
+        if (buffer->thread != thread)
+            continue;
+        QMutexLocker bufferLocker(&buffer->mutex);
+        for (Event event : buffer->open) {
+            event.durationNs = now - event.startNs;
+            open.append(event);
+        }
+    }
+    return open;
+}
+
+void Tracer::clear()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (const auto &buffer : reg.buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->events.clear();
+        buffer->next = 0;
+    }
+}
+
+// ------------------ TraceSpan ------------------
+
+TraceSpan::TraceSpan(const char *category, const QString &name)
+    : m_category(category)
+    , m_name(name)
+    , m_startNs(0)
+    , m_active(Tracer::isEnabled())
+{
+    if (!m_active)
+        return;
+    m_startNs = Tracer::nowNs();
+
+    ThreadBuffer &buffer = localBuffer();
+    Tracer::Event event;
+    event.category = m_category;
+    event.name = m_name;
+    event.startNs = m_startNs;
+    event.threadId = buffer.threadId;
+    QMutexLocker locker(&buffer.mutex);
+    buffer.open.append(event);
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (!m_active)
+        return;
+    Tracer::record(m_category, m_name, m_startNs, Tracer::nowNs() - m_startNs, m_rows);
+
+    ThreadBuffer &buffer = localBuffer();
+    QMutexLocker locker(&buffer.mutex);
+    if (!buffer.open.isEmpty())
+        buffer.open.removeLast();
+}
+
+// ------------------ QSqlQuery helpers ------------------
+
+bool tracedPrepare(QSqlQuery &query, const QString &statement, const QString &sql)
+{
+    TraceSpan span("sql.prepare", statement);
+    return query.prepare(sql);
+}
+
+bool tracedExec(QSqlQuery &query, const QString &statement)
+{
+    TraceSpan span("sql.exec", statement);
+    const bool ok = query.exec();
+    if (ok && !query.isSelect())
+        span.setRows(query.numRowsAffected());
+    return ok;
+}
+
+bool tracedExec(QSqlQuery &query, const QString &statement, const QString &sql)
+{
+    TraceSpan span("sql.exec", statement);
+    const bool ok = query.exec(sql);
+    if (ok && !query.isSelect())
+        span.setRows(query.numRowsAffected());
+    return ok;
+}
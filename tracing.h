@@ -0,0 +1,82 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QList>
+
+class QSqlQuery;
+class QThread;
+
+// Lightweight span recorder. Each thread appends finished spans to its own ring
+// buffer (the lock is only ever contended while exporting), so recording stays
+// cheap on the GUI thread and in workers alike. Set ARCHIFLOW_TRACE=0 (AppConfig
+// "diagnostics/trace") to disable.
+class Tracer
+{
+public:
+    struct Event {
+        const char *category = "";   // static string, e.g. "sql.exec"
+        QString name;
+        qint64 startNs = 0;
+        qint64 durationNs = 0;
+        qint64 rows = -1;            // -1 when the span has no row count
+        quint64 threadId = 0;
+    };
+
+    struct Stats {
+        QString category;
+        QString name;
+        int count = 0;
+        double p50Ms = 0;
+        double p95Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+    };
+
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    // Monotonic nanoseconds since the tracer was first used.
+    static qint64 nowNs();
+
+    static void record(const char *category, const QString &name,
+                       qint64 startNs, qint64 durationNs, qint64 rows = -1);
+
+    // Latency percentiles per (category, name) over the buffered spans.
+    static QList<Stats> statistics();
+
+    // Spans still running on 'thread', outermost first; durationNs is the time so
+    // far. Safe to call from any thread (the stall watchdog reads the GUI thread's).
+    static QList<Event> openSpans(const QThread *thread);
+
+    // Writes the buffered spans as Chrome trace / Perfetto JSON.
+    static bool exportChromeTrace(const QString &path, QString *errorText = nullptr);
+
+    static void clear();
+};
+
+// Records one complete span from construction to destruction.
+class TraceSpan
+{
+public:
+    TraceSpan(const char *category, const QString &name);
+    ~TraceSpan();
+
+    void setRows(qint64 rows) { m_rows = rows; }
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    const char *m_category;
+    QString m_name;
+    qint64 m_startNs;
+    qint64 m_rows = -1;
+    bool m_active;
+};
+
+// QSqlQuery calls timed under the statement's logical name.
+bool tracedPrepare(QSqlQuery &query, const QString &statement, const QString &sql);
+bool tracedExec(QSqlQuery &query, const QString &statement);
+bool tracedExec(QSqlQuery &query, const QString &statement, const QString &sql);
+
+#endif // TRACING_H
@@ -0,0 +1,252 @@
+#include "userrepository.h"
+#include "appconfig.h"
+#include "lookupcache.h"
+#include "statements.h"
+#include "sha256batch.h"
+
+#include <QSqlQuery>
+#include <QSet>
+#include <QDebug>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace {
+
+using IdChunk = std::array<QString, statements::PasswordHashChunk>;
+
+template <std::size_t... I>
+void bindIdChunk(QSqlQuery &query, const IdChunk &ids, std::index_sequence<I...>)
+{
+    schema::bind(query, statements::emplSelectPasswordHashes, ids[I]...);
+}
+
+UserRepository::CreateResult classifyFailure(const QSqlQuery &query, QString *errorText)
+{
+    const QSqlError error = query.lastError();
+    if (errorText)
+        *errorText = error.text();
+
+    if (UserRepository::isUniqueViolation(error))
+        return UserRepository::CreateResult::AlreadyExists;
+
+    qDebug() << "User insert failed:" << error.text();
+    return UserRepository::CreateResult::Failed;
+}
+
+} // namespace
+
+UserRepository::CreateResult UserRepository::registerWhitelistedUser(QSqlDatabase &db,
+                                                                     const QString &userId,
+                                                                     const QString &hwid,
+                                                                     const QString &role,
+                                                                     const QString &passwordHash,
+                                                                     QString *errorText)
+{
+    LookupCache &cache = LookupCache::instance();
+    if (cache.isMissing(LookupCache::Whitelist, hwid))
+        return CreateResult::NotWhitelisted;
+
+    // See statements::emplRegisterWhitelisted for why this is a single statement.
+    const quint64 generation = cache.generation();
+    QSqlQuery query(db);
+    if (!schema::run(query, statements::emplRegisterWhitelisted,
+                     userId, hwid, role, QStringLiteral("Offline"), passwordHash,
+                     QDateTime::currentDateTimeUtc(), hwid))
+        return classifyFailure(query, errorText);
+
+    if (query.numRowsAffected() == 0) {
+        cache.insertMissing(LookupCache::Whitelist, hwid, generation);
+        return CreateResult::NotWhitelisted;
+    }
+    // A login tried before registering may have cached the user as missing.
+    cache.invalidate(LookupCache::Users, userId);
+    return CreateResult::Created;
+}
+
+UserRepository::CreateResult UserRepository::createUser(QSqlDatabase &db,
+                                                        const QString &userId,
+                                                        const QString &hwid,
+                                                        const QString &role,
+                                                        const QString &passwordHash,
+                                                        QString *errorText)
+{
+    QSqlQuery query(db);
+    if (!schema::run(query, statements::emplInsert,
+                     userId, hwid, role, QStringLiteral("Offline"), passwordHash,
+                     QDateTime::currentDateTimeUtc()))
+        return classifyFailure(query, errorText);
+
+    LookupCache::instance().invalidate(LookupCache::Users, userId);
+    return CreateResult::Created;
+}
+
+bool UserRepository::isUniqueViolation(const QSqlError &error)
+{
+    // Oracle reports ORA-00001 through ODBC; SQLite SQLITE_CONSTRAINT_UNIQUE (2067)
+    // or SQLITE_CONSTRAINT_PRIMARYKEY (1555), "UNIQUE constraint failed". A bare
+    // native code 1 is not checked: on SQLite that is SQLITE_ERROR, which covers
+    // missing tables and syntax errors.
+    const QString code = error.nativeErrorCode();
+    const QString text = error.text();
+    return code == QLatin1String("2067") || code == QLatin1String("1555")
+           || text.contains(QLatin1String("ORA-00001"))
+           || text.contains(QLatin1String("unique constraint"), Qt::CaseInsensitive);
+}
+
+bool UserRepository::whitelistHwid(QSqlDatabase &db, const QString &hwid, int permission,
+                                   QString *errorText)
+{
+    QSqlQuery query(db);
+    if (!schema::run(query, statements::whitelistInsert, hwid, permission)) {
+        if (errorText)
+            *errorText = query.lastError().text();
+        return false;
+    }
+    LookupCache::instance().invalidate(LookupCache::Whitelist, hwid);
+    return true;
+}
+
+bool UserRepository::statusCounts(QSqlDatabase &db, StatusCounts *counts, QString *errorText,
+                                  const QDateTime &onlineSince)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    // Both variants decode into the same (status, count) row.
+    const bool ok = onlineSince.isValid()
+        ? schema::run(query, statements::emplCountByPresence, onlineSince.toUTC())
+        : schema::run(query, statements::emplCountByStatus);
+    if (!ok) {
+        if (errorText)
+            *errorText = query.lastError().text();
+        return false;
+    }
+
+    *counts = StatusCounts();
+    statements::StatusCountRow row;
+    while (query.next()) {
+        schema::read(query, statements::emplCountByStatus, row);
+        if (row.status.compare("Online", Qt::CaseInsensitive) == 0)
+            counts->online += row.count;
+        else if (row.status.compare("Offline", Qt::CaseInsensitive) == 0)
+            counts->offline += row.count;
+        else
+            counts->other += row.count;
+    }
+    return true;
+}
+
+qint64 UserRepository::presenceTtlMs()
+{
+    return PresenceTtlHeartbeats * qint64(AppConfig::intValue(AppConfig::PresenceHeartbeatMs));
+}
+
+bool UserRepository::heartbeat(QSqlDatabase &db, const QString &userId, const QString &status,
+                               QString *errorText)
+{
+    // last_seen is stamped in UTC by the client so the value compares the same way
+    // on every backend (TIMESTAMP on Oracle, ISO-8601 text on SQLite).
+    QSqlQuery query(db);
+    if (!schema::run(query, statements::emplHeartbeat, status, QDateTime::currentDateTimeUtc(), userId)) {
+        if (errorText)
+            *errorText = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool UserRepository::passwordHash(QSqlDatabase &db, const QString &userId, QString *hash, bool *found,
+                                  QString *errorText)
+{
+    LookupCache &cache = LookupCache::instance();
+    if (cache.isMissing(LookupCache::Users, userId)) {
+        *found = false;
+        hash->clear();
+        return true;
+    }
+
+    const quint64 generation = cache.generation();
+    QSqlQuery query(db);
+    if (!schema::run(query, statements::emplSelectPasswordHash, userId)) {
+        if (errorText)
+            *errorText = query.lastError().text();
+        return false;
+    }
+
+    *found = query.next();
+    if (*found) {
+        // Not cached: a password changed or a user deleted on another host must
+        // stop working here at once.
+        *hash = schema::read(query, statements::emplSelectPasswordHash).passwordHash;
+    } else {
+        hash->clear();
+        cache.insertMissing(LookupCache::Users, userId, generation);
+    }
+    return true;
+}
+
+bool UserRepository::passwordHashes(QSqlDatabase &db, const QStringList &userIds,
+                                    QHash<QString, QString> *hashes, QString *errorText)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    EmployeeRecord row;
+
+    if (userIds.size() > AppConfig::intValue(AppConfig::PasswordHashScanRows)) {
+        const QSet<QString> wanted(userIds.cbegin(), userIds.cend());
+        if (!schema::run(query, statements::emplLoadPasswordHashes)) {
+            if (errorText)
+                *errorText = query.lastError().text();
+            return false;
+        }
+        while (query.next()) {
+            schema::read(query, statements::emplLoadPasswordHashes, row);
+            if (wanted.contains(row.userId))
+                hashes->insert(row.userId, row.passwordHash);
+        }
+        return true;
+    }
+
+    if (!schema::prepare(query, statements::emplSelectPasswordHashes)) {
+        if (errorText)
+            *errorText = query.lastError().text();
+        return false;
+    }
+    for (qsizetype first = 0; first < userIds.size(); first += statements::PasswordHashChunk) {
+        IdChunk ids;
+        for (int i = 0; i < statements::PasswordHashChunk; ++i)
+            ids[i] = userIds.at(qMin(first + i, userIds.size() - 1));
+        bindIdChunk(query, ids, std::make_index_sequence<statements::PasswordHashChunk>());
+        if (!schema::exec(query, statements::emplSelectPasswordHashes)) {
+            if (errorText)
+                *errorText = query.lastError().text();
+            return false;
+        }
+        while (query.next()) {
+            schema::read(query, statements::emplSelectPasswordHashes, row);
+            hashes->insert(row.userId, row.passwordHash);
+        }
+    }
+    return true;
+}
+
+QString UserRepository::sha256Hex(const QString &text)
+{
+    return Sha256Batch::hex(text.toUtf8());
+}
+
+QStringList UserRepository::sha256Hex(const QStringList &texts)
+{
+    return Sha256Batch::hexOfUtf8(texts);
+}
+
+QString UserRepository::friendlyIdFromHwid(const QString &hwid)
+{
+    QString friendly = hwid;
+    std::reverse(friendly.begin(), friendly.end());
+    if (friendly.length() > 10) {
+        friendly = friendly.left(10);
+    }
+    return friendly;
+}
@@ -0,0 +1,96 @@
+#ifndef USERREPOSITORY_H
+#define USERREPOSITORY_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QSqlError>
+
+// Data paths for 'empl' and WHITELISTED_USERS shared by the windows and the
+// headless CLI. Each creation is a single statement: uniqueness comes from the
+// constraint on empl.user_id instead of a SELECT COUNT(*) pre-check.
+class UserRepository
+{
+public:
+    enum class CreateResult {
+        Created,
+        AlreadyExists,
+        NotWhitelisted,
+        Failed
+    };
+
+    // Inserts the user only if the HWID has a whitelist permission, in one round trip.
+    // An HWID found not whitelisted is remembered for a few seconds (LookupCache)
+    // and refused again without a round trip.
+    static CreateResult registerWhitelistedUser(QSqlDatabase &db,
+                                                const QString &userId,
+                                                const QString &hwid,
+                                                const QString &role,
+                                                const QString &passwordHash,
+                                                QString *errorText = nullptr);
+
+    // Inserts the user unconditionally (admin path), in one round trip.
+    static CreateResult createUser(QSqlDatabase &db,
+                                   const QString &userId,
+                                   const QString &hwid,
+                                   const QString &role,
+                                   const QString &passwordHash,
+                                   QString *errorText = nullptr);
+
+    static bool isUniqueViolation(const QSqlError &error);
+
+    // Adds a (hashed) HWID to the whitelist.
+    static bool whitelistHwid(QSqlDatabase &db, const QString &hwid, int permission,
+                              QString *errorText = nullptr);
+
+    struct StatusCounts {
+        int online = 0;
+        int offline = 0;
+        int other = 0;
+    };
+
+    // Online/offline totals computed by the database (GROUP BY status). With a valid
+    // 'onlineSince', Online rows whose last_seen is older (or missing) count as Offline.
+    static bool statusCounts(QSqlDatabase &db, StatusCounts *counts, QString *errorText = nullptr,
+                             const QDateTime &onlineSince = QDateTime());
+
+    // password_hash of one user. *found is false when there is no such user; only
+    // that absence is cached (LookupCache), so a hash that authenticates always comes
+    // from the database.
+    static bool passwordHash(QSqlDatabase &db, const QString &userId, QString *hash, bool *found,
+                             QString *errorText = nullptr);
+
+    // password_hash of the given users, for rows loaded without it. Users that no
+    // longer exist are left out of 'hashes'. Up to "storage/passwordHashScanRows"
+    // (see AppConfig) ids go as indexed IN-list lookups; more than that read the
+    // column in one scan.
+    static bool passwordHashes(QSqlDatabase &db, const QStringList &userIds,
+                               QHash<QString, QString> *hashes, QString *errorText = nullptr);
+
+    // A client is Online only while it keeps refreshing empl.last_seen; after this
+    // many heartbeat intervals ("presence/heartbeatMs") without one it counts as
+    // Offline. Tied to the interval so that a longer one cannot expire live clients.
+    static constexpr int PresenceTtlHeartbeats = 3;
+
+    static qint64 presenceTtlMs();
+
+    static QDateTime presenceCutoff() {
+        return QDateTime::currentDateTimeUtc().addMSecs(-presenceTtlMs());
+    }
+
+    // Sets the user's status and stamps last_seen, in one single-row UPDATE.
+    static bool heartbeat(QSqlDatabase &db, const QString &userId, const QString &status,
+                          QString *errorText = nullptr);
+
+    // Lower-case hex SHA-256 of the UTF-8 text, as stored for HWIDs and passwords.
+    static QString sha256Hex(const QString &text);
+    // The same for many texts at once (Sha256Batch); use it on bulk paths.
+    static QStringList sha256Hex(const QStringList &texts);
+
+    // The user_id derived from a hashed HWID: reversed and cut to 10 characters.
+    static QString friendlyIdFromHwid(const QString &hwid);
+};
+
+#endif // USERREPOSITORY_H
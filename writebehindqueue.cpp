@@ -0,0 +1,126 @@
+#include "writebehindqueue.h"
+#include "appconfig.h"
+
+#include <QDebug>
+
+WriteBehindQueue::WriteBehindQueue(WriteJournal *journal, QObject *parent)
+    : QObject(parent)
+    , m_journal(journal)
+{
+    m_flushTimer.setSingleShot(true);
+    connect(&m_flushTimer, &QTimer::timeout, this, &WriteBehindQueue::flush);
+    connect(m_journal, &WriteJournal::settled, this, &WriteBehindQueue::settle);
+}
+
+void WriteBehindQueue::enqueueUpdate(const EmployeeRecord &before, const EmployeeRecord &after)
+{
+    Write write;
+    write.before = before;
+    write.after = after;
+    enqueue(write);
+}
+
+void WriteBehindQueue::enqueueDelete(const EmployeeRecord &before)
+{
+    Write write;
+    write.remove = true;
+    write.before = before;
+    write.after = before;
+    enqueue(write);
+}
+
+void WriteBehindQueue::enqueue(const Write &write)
+{
+    const QString &userId = write.before.userId;
+    for (Write &queued : m_queued) {
+        if (queued.before.userId != userId)
+            continue;
+        // Same row, not journaled yet: keep the original 'before' and its version,
+        // aim at the newest target.
+        if (write.remove)
+            queued.remove = true;
+        else
+            queued.after = write.after;
+        return;
+    }
+
+    m_queued.append(write);
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start(AppConfig::intValue(AppConfig::WriteFlushDelayMs));
+}
+
+void WriteBehindQueue::flush()
+{
+    m_flushTimer.stop();
+    const QList<Write> batch = m_queued;
+    m_queued.clear();
+
+    for (Write write : batch) {
+        const QString userId = write.before.userId;
+        const auto chain = m_chains.constFind(userId);
+        if (chain != m_chains.cend()) {
+            write.before = chain->stored;
+            write.chained = true;
+        }
+
+        JournalEntry entry;
+        entry.kind = write.remove ? JournalEntry::Kind::DeleteUser : JournalEntry::Kind::UpdateUser;
+        entry.before = write.before;
+        entry.after = write.after;
+        const qint64 seq = m_journal->append(entry);
+
+        m_journaled.insert(seq, write);
+        Chain &latest = m_chains[userId];
+        latest.seq = seq;
+        latest.stored = storedAfter(write);
+    }
+}
+
+EmployeeRecord WriteBehindQueue::storedAfter(const Write &write)
+{
+    EmployeeRecord stored = write.remove ? write.before : write.after;
+    stored.rowVersion = write.before.rowVersion + 1;
+    return stored;
+}
+
+void WriteBehindQueue::settle(const JournalEntry &entry, WriteJournal::Outcome outcome, const QString &message)
+{
+    // Entries recovered from a previous run, and other kinds, are not ours.
+    const auto it = m_journaled.find(entry.seq);
+    if (it == m_journaled.end())
+        return;
+    const Write write = it.value();
+    m_journaled.erase(it);
+
+    const QString &userId = write.before.userId;
+    const auto chain = m_chains.find(userId);
+    if (chain != m_chains.end() && chain->seq == entry.seq)
+        m_chains.erase(chain);
+
+    if (outcome == WriteJournal::Outcome::Applied) {
+        emit committed(storedAfter(write), write.remove);
+        return;
+    }
+
+    if (write.doomed) {
+        qDebug() << "Dropped edit for" << userId << "queued behind a failed one:" << message;
+        return;
+    }
+
+    // Later writes to this row were built on a state that never reached the
+    // database, and new edits start again from the restored row.
+    m_chains.remove(userId);
+    for (Write &pending : m_journaled) {
+        if (pending.chained && pending.before.userId == userId)
+            pending.doomed = true;
+    }
+    emit failed(write.before,
+                outcome == WriteJournal::Outcome::Conflict ? Failure::Conflict : Failure::Error,
+                message);
+}
+
+void WriteBehindQueue::flushNow()
+{
+    flush();
+    m_journal->sync();
+}
@@ -0,0 +1,79 @@
+#ifndef WRITEBEHINDQUEUE_H
+#define WRITEBEHINDQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+
+#include "employeerecord.h"
+#include "writejournal.h"
+
+// Background writer for directory edits that the UI has already applied.
+//
+// Edits queued within "journal/flushDelayMs" (see AppConfig) of each other are
+// handed to the WriteJournal together; several edits to the same row collapse into one entry. The journal
+// makes them durable and replays them in batched transactions, also across a
+// lost connection or a restart. Every statement is guarded by the row_version it
+// was based on ("... WHERE user_id = :id AND row_version = :ver"), so a row
+// changed or deleted elsewhere meanwhile is reported as a conflict instead of
+// being overwritten. Each row settles on its own: committed() carries the stored
+// row with its new version, failed() the state to roll the row back to.
+//
+// An edit to a row whose previous write has not settled yet is journaled right
+// behind it, based on the version that write will store. If the earlier write
+// fails, the later ones conflict; only the first failure is reported.
+class WriteBehindQueue : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Failure {
+        Conflict,   // row_version no longer matched (edited or deleted elsewhere)
+        Error       // the database refused the statement
+    };
+
+    explicit WriteBehindQueue(WriteJournal *journal, QObject *parent = nullptr);
+
+    // 'before' is the last stored state of the row (its row_version is checked),
+    // 'after' the state the user wants.
+    void enqueueUpdate(const EmployeeRecord &before, const EmployeeRecord &after);
+    void enqueueDelete(const EmployeeRecord &before);
+
+    int pendingCount() const { return m_queued.size() + m_journaled.size(); }
+
+    // Journals whatever is still queued, for shutdown; it is sent on the next start
+    // if the journal cannot send it now.
+    void flushNow();
+
+signals:
+    void committed(const EmployeeRecord &stored, bool deleted);
+    void failed(const EmployeeRecord &restore, WriteBehindQueue::Failure failure, const QString &message);
+
+private:
+    struct Write {
+        bool remove = false;
+        EmployeeRecord before;
+        EmployeeRecord after;
+        bool chained = false;   // 'before' is what an unsettled write will store
+        bool doomed = false;    // that write failed; this one can only conflict
+    };
+
+    // The newest unsettled write of a row.
+    struct Chain {
+        qint64 seq = 0;
+        EmployeeRecord stored;
+    };
+
+    void enqueue(const Write &write);
+    void flush();
+    void settle(const JournalEntry &entry, WriteJournal::Outcome outcome, const QString &message);
+    static EmployeeRecord storedAfter(const Write &write);
+
+    WriteJournal *m_journal;
+    QList<Write> m_queued;                // at most one per user_id
+    QHash<qint64, Write> m_journaled;     // by journal sequence number
+    QHash<QString, Chain> m_chains;       // by user_id
+    QTimer m_flushTimer;
+};
+
+#endif // WRITEBEHINDQUEUE_H
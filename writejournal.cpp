@@ -0,0 +1,495 @@
+#include "writejournal.h"
+#include "appconfig.h"
+#include "storagebackend.h"
+#include "taskscheduler.h"
+#include "statements.h"
+#include "userrepository.h"
+#include "lookupcache.h"
+#include "tracing.h"
+
+#include <QPointer>
+#include <QHash>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+#if defined(Q_OS_WIN)
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+namespace {
+
+bool syncToDisk(QFile &file)
+{
+    if (!file.flush())
+        return false;
+#if defined(Q_OS_WIN)
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+const char *kindName(JournalEntry::Kind kind)
+{
+    switch (kind) {
+    case JournalEntry::Kind::UpdateUser:             return "update";
+    case JournalEntry::Kind::DeleteUser:             return "delete";
+    case JournalEntry::Kind::CreateUser:             return "create";
+    case JournalEntry::Kind::WhitelistAdd:           return "whitelist.add";
+    case JournalEntry::Kind::WhitelistSetPermission: return "whitelist.permission";
+    case JournalEntry::Kind::Activity:               return "activity";
+    }
+    return "";
+}
+
+bool kindFromName(const QString &name, JournalEntry::Kind *kind)
+{
+    using Kind = JournalEntry::Kind;
+    for (Kind candidate : {Kind::UpdateUser, Kind::DeleteUser, Kind::CreateUser,
+                           Kind::WhitelistAdd, Kind::WhitelistSetPermission, Kind::Activity}) {
+        if (name == QLatin1String(kindName(candidate))) {
+            *kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+QJsonObject recordToJson(const EmployeeRecord &record)
+{
+    QJsonObject object;
+    object["userId"] = record.userId;
+    object["hwid"] = record.hwid;
+    object["role"] = record.role;
+    object["status"] = record.status;
+    object["passwordHash"] = record.passwordHash;
+    if (!record.passwordHashLoaded)
+        object["passwordHashLoaded"] = false;
+    object["rowVersion"] = record.rowVersion;
+    return object;
+}
+
+EmployeeRecord recordFromJson(const QJsonObject &object)
+{
+    EmployeeRecord record;
+    record.userId = object["userId"].toString();
+    record.hwid = object["hwid"].toString();
+    record.role = object["role"].toString();
+    record.status = object["status"].toString();
+    record.passwordHash = object["passwordHash"].toString();
+    record.passwordHashLoaded = object["passwordHashLoaded"].toBool(true);
+    record.rowVersion = object["rowVersion"].toInteger();
+    return record;
+}
+
+// One journal line. Only the fields the entry's kind uses are written.
+QByteArray entryToLine(const JournalEntry &entry)
+{
+    using Kind = JournalEntry::Kind;
+    QJsonObject object;
+    object["seq"] = entry.seq;
+    object["kind"] = QLatin1String(kindName(entry.kind));
+    object["at"] = entry.at.toString(Qt::ISODateWithMs);
+    switch (entry.kind) {
+    case Kind::UpdateUser:
+        object["before"] = recordToJson(entry.before);
+        object["after"] = recordToJson(entry.after);
+        break;
+    case Kind::DeleteUser:
+        object["before"] = recordToJson(entry.before);
+        break;
+    case Kind::CreateUser:
+        object["after"] = recordToJson(entry.after);
+        break;
+    case Kind::WhitelistAdd:
+    case Kind::WhitelistSetPermission:
+        object["hwid"] = entry.hwid;
+        object["permission"] = entry.permission;
+        break;
+    case Kind::Activity:
+        object["userId"] = entry.userId;
+        object["text"] = entry.text;
+        break;
+    }
+    return QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n';
+}
+
+bool entryFromLine(const QByteArray &line, JournalEntry *entry)
+{
+    const QJsonObject object = QJsonDocument::fromJson(line).object();
+    if (object.isEmpty() || !kindFromName(object["kind"].toString(), &entry->kind))
+        return false;
+    entry->seq = object["seq"].toInteger();
+    entry->at = QDateTime::fromString(object["at"].toString(), Qt::ISODateWithMs);
+    entry->before = recordFromJson(object["before"].toObject());
+    entry->after = recordFromJson(object["after"].toObject());
+    entry->hwid = object["hwid"].toString();
+    entry->permission = object["permission"].toInt();
+    entry->userId = object["userId"].toString();
+    entry->text = object["text"].toString();
+    return entry->seq > 0;
+}
+
+QString checkpointPath(const QString &journalPath)
+{
+    return journalPath + QStringLiteral(".applied");
+}
+
+} // namespace
+
+WriteJournal::WriteJournal(QObject *parent)
+    : WriteJournal(defaultPath(), parent)
+{
+}
+
+WriteJournal::WriteJournal(const QString &path, QObject *parent)
+    : QObject(parent)
+    , m_path(path)
+    , m_file(path)
+{
+    // Everything appended in one event-loop turn shares one fsync.
+    m_syncTimer.setSingleShot(true);
+    connect(&m_syncTimer, &QTimer::timeout, this, &WriteJournal::sync);
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout, this, &WriteJournal::replay);
+
+    load();
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+        qWarning() << "Cannot open write journal" << m_path << "-" << m_file.errorString()
+                   << "; changes are kept in memory only.";
+
+    if (!m_durable.isEmpty())
+        QTimer::singleShot(0, this, &WriteJournal::replay);
+}
+
+WriteJournal::~WriteJournal()
+{
+    // Nothing is sent from here: what is left replays on the next start.
+    writeBuffered();
+}
+
+QString WriteJournal::defaultPath()
+{
+    QString path = AppConfig::stringValue(AppConfig::JournalPath);
+    if (path.isEmpty()) {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        path = QDir(dir).filePath("journal.jsonl");
+    }
+    return path;
+}
+
+void WriteJournal::load()
+{
+    QFile checkpoint(checkpointPath(m_path));
+    if (checkpoint.open(QIODevice::ReadOnly))
+        m_applied = checkpoint.readAll().trimmed().toLongLong();
+
+    QFile journal(m_path);
+    qint64 lastSeq = m_applied;
+    if (journal.open(QIODevice::ReadOnly)) {
+        while (!journal.atEnd()) {
+            const QByteArray line = journal.readLine().trimmed();
+            if (line.isEmpty())
+                continue;
+            JournalEntry entry;
+            if (!entryFromLine(line, &entry)) {
+                // A torn last line from a crash mid-write was never acknowledged.
+                qWarning() << "Skipping unreadable write journal line:" << line.left(80);
+                continue;
+            }
+            lastSeq = qMax(lastSeq, entry.seq);
+            if (entry.seq > m_applied)
+                m_durable.append(entry);
+        }
+    }
+
+    m_nextSeq = lastSeq + 1;
+    m_recovered = m_durable.size();
+    if (m_recovered > 0)
+        qDebug() << "Write journal:" << m_recovered << "change(s) from a previous run to replay.";
+}
+
+qint64 WriteJournal::append(const JournalEntry &entry)
+{
+    JournalEntry appended = entry;
+    appended.seq = m_nextSeq++;
+    if (!appended.at.isValid())
+        appended.at = QDateTime::currentDateTimeUtc();
+    m_buffered.append(appended);
+
+    if (!m_syncTimer.isActive())
+        m_syncTimer.start(0);
+    return appended.seq;
+}
+
+void WriteJournal::sync()
+{
+    writeBuffered();
+    replay();
+}
+
+void WriteJournal::writeBuffered()
+{
+    m_syncTimer.stop();
+    if (m_buffered.isEmpty())
+        return;
+
+    TraceSpan span("journal", "WriteJournal::sync");
+    span.setRows(m_buffered.size());
+
+    if (m_file.isOpen()) {
+        QByteArray lines;
+        for (const JournalEntry &entry : std::as_const(m_buffered))
+            lines += entryToLine(entry);
+        if (m_file.write(lines) != lines.size() || !syncToDisk(m_file))
+            qWarning() << "Write journal" << m_path << "could not be synced:" << m_file.errorString();
+    }
+
+    m_durable.append(m_buffered);
+    m_buffered.clear();
+}
+
+void WriteJournal::replay()
+{
+    // While offline only the retry timer sends; fresh appends just wait behind it.
+    if (m_replaying || m_retryTimer.isActive() || m_durable.isEmpty())
+        return;
+    m_replaying = true;
+
+    const QList<JournalEntry> batch = m_durable.mid(0, AppConfig::intValue(AppConfig::JournalMaxBatch));
+    QPointer<WriteJournal> self(this);
+    TaskScheduler::instance().submit(TaskScheduler::Interactive, "journal.replay",
+        [self, batch](const TaskHandle &) {
+            const BatchResult result = execute(batch);
+            QMetaObject::invokeMethod(self.data(), [self, batch, result]() {
+                if (self)
+                    self->finishBatch(batch, result);
+            }, Qt::QueuedConnection);
+        });
+}
+
+void WriteJournal::finishBatch(const QList<JournalEntry> &batch, const BatchResult &result)
+{
+    m_replaying = false;
+
+    if (result.connectionLost) {
+        qDebug() << "Write journal replay deferred:" << result.error;
+        setOnline(false);
+        const int retryMinMs = AppConfig::intValue(AppConfig::JournalRetryMinMs);
+        const int retryMaxMs = qMax(retryMinMs, AppConfig::intValue(AppConfig::JournalRetryMaxMs));
+        m_retryMs = m_retryMs == 0 ? retryMinMs : qMin(m_retryMs * 2, retryMaxMs);
+        m_retryTimer.start(m_retryMs);
+        return;
+    }
+
+    m_retryMs = 0;
+    setOnline(true);
+
+    m_durable.remove(0, batch.size());
+    m_applied = batch.last().seq;
+    writeCheckpoint(m_applied);
+
+    for (int i = 0; i < batch.size(); ++i) {
+        const Settlement &settlement = result.settlements.at(i);
+        emit settled(batch.at(i), settlement.outcome, settlement.message);
+    }
+
+    if (!m_durable.isEmpty()) {
+        replay();
+    } else if (m_buffered.isEmpty()) {
+        compact();
+        emit drained();
+    }
+}
+
+void WriteJournal::setOnline(bool online)
+{
+    if (online == m_online)
+        return;
+    m_online = online;
+    emit onlineChanged(online);
+}
+
+void WriteJournal::writeCheckpoint(qint64 seq)
+{
+    QSaveFile checkpoint(checkpointPath(m_path));
+    if (!checkpoint.open(QIODevice::WriteOnly)
+        || checkpoint.write(QByteArray::number(seq)) < 0
+        || !checkpoint.commit())
+        qWarning() << "Write journal checkpoint could not be saved:" << checkpoint.errorString();
+}
+
+void WriteJournal::compact()
+{
+    // Everything on disk is applied; sequence numbers continue from the checkpoint.
+    if (m_file.isOpen() && m_file.size() > 0) {
+        if (!m_file.resize(0) || !syncToDisk(m_file))
+            qWarning() << "Write journal" << m_path << "could not be truncated:" << m_file.errorString();
+    }
+}
+
+WriteJournal::BatchResult WriteJournal::execute(const QList<JournalEntry> &batch)
+{
+    TraceSpan span("task", "WriteJournal::execute");
+    span.setRows(batch.size());
+
+    const QString connectionName = StorageBackend::threadConnectionName("Journal");
+    BatchResult result;
+    {
+        QString errorText;
+        QSqlDatabase db = StorageBackend::instance().open(connectionName, &errorText);
+        if (!db.isOpen()) {
+            result.connectionLost = true;
+            result.error = QString("Database connection error: %1").arg(errorText);
+        } else {
+            result = executeOn(db, batch);
+        }
+    }
+
+    // A dead session stays "open"; drop it so the next attempt reconnects.
+    if (result.connectionLost)
+        QSqlDatabase::removeDatabase(connectionName);
+    return result;
+}
+
+WriteJournal::BatchResult WriteJournal::executeOn(QSqlDatabase &db, const QList<JournalEntry> &batch)
+{
+    using Kind = JournalEntry::Kind;
+    BatchResult result;
+
+    // One transaction per batch; each statement still succeeds or fails on its own.
+    const bool transactional = db.transaction();
+    if (!transactional && StorageBackend::isConnectionError(db.lastError())) {
+        result.connectionLost = true;
+        result.error = db.lastError().text();
+        return result;
+    }
+
+    // Each statement is prepared once per batch, on first use.
+    QHash<const void *, QSqlQuery> prepared;
+    QSqlQuery unprepared;
+    QSqlQuery *query = nullptr;
+    auto run = [&](const auto &stmt, const auto &...args) {
+        auto it = prepared.find(&stmt);
+        if (it == prepared.end()) {
+            QSqlQuery fresh(db);
+            if (!schema::prepare(fresh, stmt)) {
+                unprepared = fresh;
+                query = &unprepared;
+                return false;
+            }
+            it = prepared.insert(&stmt, fresh);
+        }
+        query = &it.value();
+        schema::bind(*query, stmt, args...);
+        return schema::exec(*query, stmt);
+    };
+
+    for (const JournalEntry &entry : batch) {
+        bool executed = false;
+        switch (entry.kind) {
+        case Kind::UpdateUser: {
+            // A status set by hand counts as a presence heartbeat at the time it was made.
+            const std::optional<QDateTime> seen = entry.after.status != entry.before.status
+                                                      ? std::optional<QDateTime>(entry.at.toUTC())
+                                                      : std::nullopt;
+            // An unchanged password is left alone, so a row loaded without its hash
+            // never writes an empty one back.
+            const std::optional<QString> password = entry.after.passwordHash != entry.before.passwordHash
+                                                        ? std::optional<QString>(entry.after.passwordHash)
+                                                        : std::nullopt;
+            executed = run(statements::emplUpdateVersioned,
+                           entry.after.role, entry.after.status, password, seen,
+                           entry.before.userId, entry.before.rowVersion);
+            break;
+        }
+        case Kind::DeleteUser:
+            executed = run(statements::emplDeleteVersioned, entry.before.userId, entry.before.rowVersion);
+            break;
+        case Kind::CreateUser:
+            executed = run(statements::emplInsert, entry.after.userId, entry.after.hwid,
+                           entry.after.role, entry.after.status, entry.after.passwordHash,
+                           entry.at.toUTC());
+            break;
+        case Kind::WhitelistAdd:
+            executed = run(statements::whitelistInsert, entry.hwid, entry.permission);
+            break;
+        case Kind::WhitelistSetPermission:
+            executed = run(statements::whitelistUpdatePermission, entry.permission, entry.hwid);
+            break;
+        case Kind::Activity:
+            executed = run(statements::activityInsert, entry.at.toUTC(), entry.userId, entry.text);
+            break;
+        }
+
+        Settlement settlement;
+        if (!executed) {
+            const QSqlError error = query->lastError();
+            if (StorageBackend::isConnectionError(error)) {
+                db.rollback();
+                result.connectionLost = true;
+                result.error = error.text();
+                result.settlements.clear();
+                return result;
+            }
+            settlement.outcome = Outcome::Rejected;
+            settlement.message = UserRepository::isUniqueViolation(error)
+                                     ? QString("%1 already exists.").arg(entry.kind == Kind::CreateUser
+                                                                             ? QString("User %1").arg(entry.after.userId)
+                                                                             : QString("HWID %1").arg(entry.hwid))
+                                     : error.text();
+        } else if (query->numRowsAffected() == 0) {
+            settlement.outcome = Outcome::Conflict;
+            settlement.message = entry.kind == Kind::WhitelistSetPermission
+                                     ? QString("HWID %1 is no longer whitelisted.").arg(entry.hwid)
+                                     : QString("User %1 was changed or deleted by someone else.").arg(entry.before.userId);
+        }
+        result.settlements.append(settlement);
+    }
+
+    if (transactional && !db.commit()) {
+        const QSqlError error = db.lastError();
+        db.rollback();
+        if (StorageBackend::isConnectionError(error)) {
+            result.connectionLost = true;
+            result.error = error.text();
+            result.settlements.clear();
+            return result;
+        }
+        for (Settlement &settlement : result.settlements) {
+            if (settlement.outcome == Outcome::Applied) {
+                settlement.outcome = Outcome::Rejected;
+                settlement.message = error.text();
+            }
+        }
+    }
+
+    // After the commit, so a lookup cannot cache the old absence again in between.
+    // Only keys that may now exist matter; the cache holds absent rows alone.
+    LookupCache &cache = LookupCache::instance();
+    for (const JournalEntry &entry : batch) {
+        switch (entry.kind) {
+        case Kind::CreateUser:
+            cache.invalidate(LookupCache::Users, entry.after.userId);
+            break;
+        case Kind::WhitelistAdd:
+        case Kind::WhitelistSetPermission:
+            cache.invalidate(LookupCache::Whitelist, entry.hwid);
+            break;
+        case Kind::UpdateUser:
+        case Kind::DeleteUser:
+        case Kind::Activity:
+            break;
+        }
+    }
+    return result;
+}
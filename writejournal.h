@@ -0,0 +1,126 @@
+#ifndef WRITEJOURNAL_H
+#define WRITEJOURNAL_H
+
+#include <QObject>
+#include <QList>
+#include <QFile>
+#include <QTimer>
+#include <QDateTime>
+#include <QSqlDatabase>
+
+#include "employeerecord.h"
+
+// One change the UI has already applied, waiting to reach the database.
+struct JournalEntry
+{
+    enum class Kind {
+        UpdateUser,              // before -> after, checked against before.rowVersion
+        DeleteUser,              // before, checked against before.rowVersion
+        CreateUser,              // after
+        WhitelistAdd,            // hwid, permission
+        WhitelistSetPermission,  // hwid, permission
+        Activity                 // userId, text
+    };
+
+    qint64 seq = 0;              // assigned by WriteJournal::append
+    Kind kind = Kind::Activity;
+    EmployeeRecord before;
+    EmployeeRecord after;
+    QString hwid;
+    int permission = 0;
+    QString userId;
+    QString text;
+    QDateTime at;                // when the change was made (UTC); defaults to append time
+};
+
+// Local write-ahead journal for directory changes.
+//
+// append() hands out a sequence number and returns at once. Entries appended in
+// the same event-loop turn are written and fsync'd together (group commit) before
+// any of them is sent, so a change survives a crash or a lost connection from
+// then on. Durable entries are replayed in order, up to "journal/maxBatch" (see
+// AppConfig) per transaction, on a scheduler thread.
+//
+// When the database cannot be reached (StorageBackend::isConnectionError) the
+// batch is rolled back and kept, and replay is retried with a backoff from
+// "journal/retryMinMs" up to "journal/retryMaxMs"; the journal reports offline
+// meanwhile. Any other failure belongs to the entry alone: it settles as Conflict (row_version moved)
+// or Rejected (e.g. a duplicate user) and the rest of the batch still commits.
+//
+// After each committed batch the last applied sequence number is written to a
+// checkpoint file next to the journal, and the journal is truncated once
+// everything has settled. Delivery is at-least-once: a crash between the commit
+// and the checkpoint replays that batch on the next start, where the versioned
+// writes settle as Conflict and inserts as Rejected. Entries left over from a
+// previous run are replayed at startup.
+class WriteJournal : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Outcome {
+        Applied,
+        Conflict,   // row_version no longer matched (edited or deleted elsewhere)
+        Rejected    // the database refused the statement
+    };
+
+    // Journal at AppConfig "journal/path" (ARCHIFLOW_JOURNAL_PATH), else
+    // journal.jsonl in the application data directory.
+    explicit WriteJournal(QObject *parent = nullptr);
+    WriteJournal(const QString &path, QObject *parent = nullptr);
+    ~WriteJournal() override;
+
+    static QString defaultPath();
+
+    qint64 append(const JournalEntry &entry);
+
+    // Writes and fsyncs whatever append() buffered, on the calling thread, and
+    // starts sending it.
+    void sync();
+
+    int pendingCount() const { return m_buffered.size() + m_durable.size(); }
+    int recoveredCount() const { return m_recovered; }
+    bool isOnline() const { return m_online; }
+
+signals:
+    void settled(const JournalEntry &entry, WriteJournal::Outcome outcome, const QString &message);
+    void onlineChanged(bool online);
+    void drained();     // every entry has settled
+
+private:
+    struct Settlement {
+        Outcome outcome = Outcome::Applied;
+        QString message;
+    };
+
+    struct BatchResult {
+        bool connectionLost = false;
+        QString error;
+        QList<Settlement> settlements;   // one per entry, when the batch committed
+    };
+
+    void load();
+    void writeBuffered();
+    void replay();
+    void finishBatch(const QList<JournalEntry> &batch, const BatchResult &result);
+    void setOnline(bool online);
+    void writeCheckpoint(qint64 seq);
+    void compact();
+
+    static BatchResult execute(const QList<JournalEntry> &batch);
+    static BatchResult executeOn(QSqlDatabase &db, const QList<JournalEntry> &batch);
+
+    QString m_path;
+    QFile m_file;
+    qint64 m_nextSeq = 1;
+    qint64 m_applied = 0;
+    QList<JournalEntry> m_buffered;   // appended, not yet on disk
+    QList<JournalEntry> m_durable;    // on disk, not yet applied
+    int m_recovered = 0;
+    bool m_replaying = false;
+    bool m_online = true;
+    int m_retryMs = 0;               // last backoff; 0 after a success
+    QTimer m_syncTimer;
+    QTimer m_retryTimer;
+};
+
+#endif // WRITEJOURNAL_H